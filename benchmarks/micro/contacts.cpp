@@ -0,0 +1,47 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+#define SDF_HEADLESS true
+#include <sdf/sdf.hpp>
+#include <solver/collision/contacts.hpp>
+#include <glm/glm.hpp>
+#include <cstdio>
+#include <string>
+
+/*
+    Contacts between two parts about 20mm wide, pressed 1mm into each other, at decreasing resolutions.
+    Halving the resolution should about quadruple the time, as the work follows the area of contact and not the volume of the overlap.
+*/
+
+static void run(const char* label, const auto& a, const auto& b){
+    using namespace solver::collision;
+    pose_t pa = {}, pb = {glm::mat3(glm::vec3{0,1,0},glm::vec3{-1,0,0},glm::vec3{0,0,1}),{19.0f,0,0}};
+    for(float resolution : {0.2f,0.1f,0.05f}){
+        config_t cfg;
+        cfg.resolution=resolution;
+        stats_t stats;
+        std::vector<contact_t> out;
+        ankerl::nanobench::Bench().minEpochIterations(2).run(std::string(label)+", "+std::to_string(resolution), [&] {
+            out.clear();
+            stats = contacts(a,pa,b,pb,out,cfg);
+            ankerl::nanobench::doNotOptimizeAway(out.data());
+        });
+        printf("%s at %g: %zu contacts, %zu cells, %zu leaves\n",label,resolution,stats.contacts,stats.cells,stats.leaves);
+    }
+}
+
+int main() {
+    {
+        using namespace sdf::comptime;
+        auto part = Join(Sphere({10.0}),Box({glm::vec3{4.0,12.0,4.0}}));
+        run("comptime",part,part);
+    }
+
+    {
+        using namespace sdf::dynamic;
+        auto part = Join(Sphere({10.0}),Box({glm::vec3{4.0,12.0,4.0}}));
+        auto frozen = sdf::dynamic::freeze(part);
+        run("frozen",frozen,frozen);
+    }
+
+    return 0;
+}
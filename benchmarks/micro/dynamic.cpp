@@ -0,0 +1,51 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+#define SDF_HEADLESS true
+#include <sdf/sdf.hpp>
+#include <glm/glm.hpp>
+
+/*
+    Host evaluation of the same tree built as separate shared_ptr nodes, as shared_ptr nodes in an arena, and frozen into a flat tree.
+*/
+
+constexpr size_t NODES = 256;
+
+static std::shared_ptr<sdf::utils::base_dyn<sdf::default_attrs>> make_scene(){
+    using namespace sdf::dynamic;
+    auto scene = Translate(Sphere({1.0}),{glm::vec3{0,0,0}});
+    for(size_t i=1;i<NODES;i++){
+        scene = Join(scene,Translate(Sphere({1.0}),{glm::vec3{(i%16)*2.0f,(i/16)*2.0f,0}}));
+    }
+    return scene;
+}
+
+static void run(const char* label, const auto& sdf){
+    float d = 0.0;
+    ankerl::nanobench::Bench().minEpochIterations(4).run(label, [&] {
+        for(int i=0;i<64;i++)
+            for(int j=0;j<64;j++)
+                d+=sdf.sample({i*0.5f,j*0.5f,0.0f});
+        ankerl::nanobench::doNotOptimizeAway(d);
+    });
+}
+
+int main() {
+    {
+        auto scene = make_scene();
+        run("dynamic (shared_ptr)",*scene);
+    }
+
+    {
+        arena storage;
+        sdf::utils::dyn_arena_scope scope(storage);
+        auto scene = make_scene();
+        run("dynamic (arena)",*scene);
+    }
+
+    {
+        auto scene = sdf::dynamic::freeze(make_scene());
+        run("frozen",scene);
+    }
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+
+#include <glm/glm.hpp>
+
+#define SDF_SHARED_SLOTS
+#include <utils/shared.hpp>
+shared_map<4> global_shared;
+
+#include <sdf/sdf.hpp>
+
+/*
+    The same grid of spheres as a chain of Join/Translate nodes, and as a single `Instances` node.
+    Updating the instances only rebuilds their slot, which is measured as well.
+*/
+
+constexpr size_t NODES = 256;
+
+static glm::vec3 place(size_t i, float t=0.0f){return {(i%16)*2.0f+t,(i/16)*2.0f,0};}
+
+static void run(const char* label, const auto& sdf){
+    float d = 0.0;
+    ankerl::nanobench::Bench().minEpochIterations(4).run(label, [&] {
+        for(int i=0;i<64;i++)
+            for(int j=0;j<64;j++)
+                d+=sdf.sample({i*0.5f,j*0.5f,0.0f});
+        ankerl::nanobench::doNotOptimizeAway(d);
+    });
+}
+
+int main() {
+    {
+        using namespace sdf::dynamic;
+        auto scene = Translate(Sphere({1.0}),{place(0)});
+        for(size_t i=1;i<NODES;i++){
+            scene = Join(scene,Translate(Sphere({1.0}),{place(i)}));
+        }
+        run("join of translated copies",sdf::dynamic::freeze(scene));
+    }
+
+    {
+        auto child = sdf::comptime::Sphere({1.0});
+        auto instances = sampler::instances::builder<sdf::default_attrs>::from(child);
+        for(size_t i=0;i<NODES;i++)instances.add(glm::mat3(1.0f),place(i));
+        instances.build();
+        instances.make_shared(0);
+
+        auto scene = sdf::comptime::Instances(child,{0});
+        run("instances",scene);
+
+        float t = 0.0f;
+        ankerl::nanobench::Bench().minEpochIterations(4).run("instances update", [&] {
+            t+=0.01f;
+            for(size_t i=0;i<NODES;i++)instances.set(i,glm::mat3(1.0f),place(i,t));
+            instances.update(0);
+        });
+    }
+
+    return 0;
+}
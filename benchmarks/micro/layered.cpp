@@ -0,0 +1,75 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+
+#include <glm/glm.hpp>
+
+#define SDF_SHARED_SLOTS
+#include <utils/shared.hpp>
+shared_map<4> global_shared;
+
+#include <sdf/sdf.hpp>
+#include <pipeline/basic.hpp>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../suite/scenes.hpp"
+
+/*
+    Frames of the sample scene of the suite with a small moving part, rendered as a single tree and split in a static and a dynamic layer.
+    The camera is fixed, so the layered pipeline only marches the static tree once, and the moving part on each frame.
+    Both must produce the same image, but for a few pixels on silhouettes where rays graze both trees and stop at slightly different points.
+*/
+
+constexpr int WIDTH = 512, HEIGHT = 384;
+
+int main() {
+    using namespace sdf::comptime;
+    using namespace glm;
+
+    auto scene = bench::sample();
+    auto env = sdf::dynamic::freeze(scene.root);
+    auto moving = [](float t){return Sphere({0.5})+vec3{sin(t)*2.0f,0.5f,-2.0f};};
+
+    //Materials are plain data, but not default constructible.
+    alignas(16) static char raw[sizeof(pipeline::material_t)*16] = {};
+    auto materials = (pipeline::material_t*)raw;
+    for(int i=0;i<16;i++){
+        materials[i].albedo.type = pipeline::material_t::albedo_t::COLOR;
+        materials[i].albedo.color = {{0.5f,0.6f,0.7f},1.0f};
+    }
+
+    auto whole = Join(env,moving(0));
+    auto dyn = moving(0);
+    int device = omp_get_initial_device();
+    pipeline::demo<decltype(whole)> single(device,whole,materials,16);
+    pipeline::demo<decltype(env),false,decltype(dyn)> layered(device,env,dyn,materials,16);
+
+    solver::projection::screen_camera_t camera;
+    camera.pos = scene.camera;
+    camera.canvas_width = WIDTH;
+    camera.canvas_height = HEIGHT;
+    single.set_camera(camera);
+    layered.set_camera(camera);
+
+    std::vector<glm::u8vec4> a(WIDTH*HEIGHT), b(WIDTH*HEIGHT);
+    size_t mismatches = 0;
+    float t = 0;
+
+    ankerl::nanobench::Bench().minEpochIterations(4).unit("frame").run("single tree", [&] {
+        t+=0.1f;
+        single.set_sdf(Join(env,moving(t)));
+        single.render(a.data());
+    });
+
+    ankerl::nanobench::Bench().minEpochIterations(4).unit("frame").run("static and dynamic layers, fixed camera", [&] {
+        t+=0.1f;
+        layered.set_dynamic(moving(t));
+        layered.render(b.data());
+    });
+
+    single.set_sdf(Join(env,moving(t)));
+    single.render(a.data());
+    for(size_t i=0;i<a.size();i++)mismatches+=a[i]!=b[i];
+    printf("%zu pixels differ\n",mismatches);
+    return mismatches<a.size()/1000?0:1;
+}
@@ -0,0 +1,48 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+#define SDF_HEADLESS true
+#include <sdf/sdf.hpp>
+#include <solver/mesh/extract.hpp>
+#include <glm/glm.hpp>
+
+/*
+    Throughput of the mesh extraction, in triangles per second, on comptime and frozen trees, and with trees pruned for each tile.
+*/
+
+static std::shared_ptr<sdf::utils::base_dyn<sdf::default_attrs>> make_scene(){
+    using namespace sdf::dynamic;
+    auto scene = Translate(Sphere({1.0}),{glm::vec3{0,0,0}});
+    for(size_t i=1;i<16;i++){
+        scene = Join(scene,Translate(Sphere({1.0}),{glm::vec3{(i%4)*1.5f,(i/4)*1.5f,0}}));
+    }
+    return scene;
+}
+
+static void run(const char* label, const auto& sdf, float resolution, bool prune = false){
+    solver::mesh::config_t cfg;
+    cfg.resolution=resolution;
+    cfg.prune=prune;
+    solver::mesh::counter_t sink;
+    auto stats = solver::mesh::extract(sdf,sink,cfg);
+
+    ankerl::nanobench::Bench().minEpochIterations(2).unit("triangle").batch(stats.triangles).run(label, [&] {
+        solver::mesh::counter_t sink;
+        ankerl::nanobench::doNotOptimizeAway(solver::mesh::extract(sdf,sink,cfg));
+    });
+}
+
+int main() {
+    {
+        using namespace sdf::comptime;
+        auto scene = Join(Sphere({1.0}),Translate(Box({glm::vec3{0.5,2.0,0.5}}),{glm::vec3{1,0,0}}));
+        run("comptime",scene,0.01f);
+    }
+
+    {
+        auto scene = sdf::dynamic::freeze(make_scene());
+        run("frozen",scene,0.02f);
+        run("frozen, pruned",scene,0.02f,true);
+    }
+
+    return 0;
+}
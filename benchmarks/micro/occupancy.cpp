@@ -0,0 +1,57 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+
+#include <glm/glm.hpp>
+
+#define SDF_SHARED_SLOTS
+#include <utils/shared.hpp>
+shared_map<4> global_shared;
+
+#include <sdf/sdf.hpp>
+#include <solver/projection/base.hpp>
+#include <sampler/occupancy.hpp>
+#include <cstdio>
+#include "../suite/scenes.hpp"
+
+/*
+    Sphere tracing of the small reference scenes of the suite, with and without skipping the empty cells of an occupancy grid.
+    The camera is low on the ground, so most rays graze it before reaching anything.
+    Besides time, the mean number of samples of the SDF per ray is reported, for rays hitting a surface.
+    Misses are reported by `march_schnell` as `MAX_STEPS` regardless of the work done, so they are left out.
+*/
+
+constexpr int SIZE = 256;
+
+static void run(const char* label, const auto& sdf, const sdf::bbox_t& box){
+    sampler::occupancy::builder grid(box,0.1f,128);
+    grid.build(sdf);
+    grid.make_shared(0);
+
+    solver::projection::base<std::remove_cvref_t<decltype(sdf)>> scene(sdf,{0,0.3,-12});
+    for(int occupancy : {-1,0}){
+        scene.occupancy = occupancy;
+        size_t steps = 0, hits = 0;
+        std::string name = std::string(label)+(occupancy<0?"":", occupancy grid");
+        ankerl::nanobench::Bench().minEpochIterations(2).unit("ray").batch(SIZE*SIZE).run(name, [&] {
+            steps = 0, hits = 0;
+            #pragma omp parallel for collapse(2) reduction(+:steps,hits)
+            for(int i=0;i<SIZE;i++)
+                for(int j=0;j<SIZE;j++){
+                    auto [d,n] = scene.render_schnell({(j-SIZE/2)/(float)SIZE,(i-SIZE/2)/(float)SIZE});
+                    if(std::isinf(d))continue;
+                    steps+=n;
+                    hits++;
+                }
+            ankerl::nanobench::doNotOptimizeAway(steps);
+        });
+        printf("%s: %.2f steps per ray, %zu hits\n",name.c_str(),steps/(double)hits,hits);
+    }
+}
+
+int main() {
+    for(auto& scene : {bench::sample(),bench::test_1()}){
+        run(scene.name.c_str(),sdf::dynamic::freeze(scene.root),scene.box);
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+#define SDF_HEADLESS true
+#include <sdf/sdf.hpp>
+#include <solver/projection/base.hpp>
+#include <glm/glm.hpp>
+#include <cstdio>
+#include "../suite/scenes.hpp"
+
+/*
+    Primary rays per second on the host over the small reference scenes of the suite, marched one by one and as packets of 4×4 and 8×8 rays.
+*/
+
+constexpr int SIZE = 512;
+
+template<uint N>
+static void packets(const char* label, auto& scene){
+    ankerl::nanobench::Bench().minEpochIterations(2).unit("ray").batch(SIZE*SIZE).run(label, [&] {
+        float acc = 0;
+        #pragma omp parallel for collapse(2) schedule(dynamic,1) reduction(+:acc)
+        for(int i=0;i<SIZE;i+=N)
+            for(int j=0;j<SIZE;j+=N){
+                glm::vec3 rd[N*N];
+                std::pair<float,uint> res[N*N];
+                for(uint y=0;y<N;y++)for(uint x=0;x<N;x++)rd[y*N+x]=scene.direction({(j+(int)x-SIZE/2)/(float)SIZE,(i+(int)y-SIZE/2)/(float)SIZE});
+                scene.template march_packet_schnell<N>(scene.camera.pos,rd,res);
+                for(auto& r : res)acc+=r.second;
+            }
+        ankerl::nanobench::doNotOptimizeAway(acc);
+    });
+}
+
+static void run(const char* label, const auto& sdf){
+    solver::projection::base<std::remove_cvref_t<decltype(sdf)>> scene(sdf,{0,0.3,-12});
+
+    ankerl::nanobench::Bench().minEpochIterations(2).unit("ray").batch(SIZE*SIZE).run(std::string(label)+", single rays", [&] {
+        float acc = 0;
+        #pragma omp parallel for collapse(2) schedule(dynamic,1) reduction(+:acc)
+        for(int i=0;i<SIZE;i++)
+            for(int j=0;j<SIZE;j++){
+                acc+=scene.render_schnell({(j-SIZE/2)/(float)SIZE,(i-SIZE/2)/(float)SIZE}).second;
+            }
+        ankerl::nanobench::doNotOptimizeAway(acc);
+    });
+
+    packets<4>((std::string(label)+", 4x4 packets").c_str(),scene);
+    packets<8>((std::string(label)+", 8x8 packets").c_str(),scene);
+}
+
+int main() {
+    for(auto& scene : {bench::sample(),bench::test_1()}){
+        run(scene.name.c_str(),sdf::dynamic::freeze(scene.root));
+    }
+
+    return 0;
+}
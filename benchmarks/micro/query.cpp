@@ -0,0 +1,55 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+#define SDF_HEADLESS true
+#include <sdf/sdf.hpp>
+#include <pipeline/query.hpp>
+#include <glm/glm.hpp>
+#include <random>
+#include <vector>
+
+/*
+    Queries per second for batches of 1M raycasts and closest points, on the default device.
+*/
+
+constexpr size_t N = 1<<20;
+
+static void run(const char* label, const auto& sdf){
+    using query_t = pipeline::query<std::remove_cvref_t<decltype(sdf)>>;
+    query_t engine(omp_get_default_device(),sdf);
+
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> box(-20.0f,20.0f);
+    std::vector<typename query_t::ray_t> rays(N);
+    std::vector<glm::vec3> points(N);
+    for(size_t i=0;i<N;i++){
+        glm::vec3 origin = {box(gen),box(gen),-30.0f};
+        rays[i]={origin,glm::normalize(glm::vec3{box(gen),box(gen),30.0f}*0.05f+glm::vec3{0,0,1}-origin*0.01f),100.0f};
+        points[i]={box(gen),box(gen),box(gen)};
+    }
+    std::vector<typename query_t::hit_t> hits(N);
+    std::vector<typename query_t::point_t> closest(N);
+
+    ankerl::nanobench::Bench().minEpochIterations(2).unit("query").batch(N).run(std::string(label)+", raycast", [&] {
+        ankerl::nanobench::doNotOptimizeAway(engine.raycast(rays.data(),hits.data(),N));
+    });
+    ankerl::nanobench::Bench().minEpochIterations(2).unit("query").batch(N).run(std::string(label)+", closest", [&] {
+        engine.closest(points.data(),closest.data(),N);
+        ankerl::nanobench::doNotOptimizeAway(closest[0]);
+    });
+}
+
+int main() {
+    {
+        using namespace sdf::comptime;
+        auto scene = Join(Cut(Translate(Sphere({4.0}),{glm::vec3{10,0,0}}),Join(Sphere({12.0}),Box({glm::vec3{20.0,4.0,8.0}}))),Translate(Box({glm::vec3{30,30,1}}),{glm::vec3{0,0,15}}));
+        run("comptime",scene);
+    }
+
+    {
+        using namespace sdf::dynamic;
+        auto scene = Join(Cut(Translate(Sphere({4.0}),{glm::vec3{10,0,0}}),Join(Sphere({12.0}),Box({glm::vec3{20.0,4.0,8.0}}))),Translate(Box({glm::vec3{30,30,1}}),{glm::vec3{0,0,15}}));
+        run("frozen",sdf::dynamic::freeze(scene));
+    }
+
+    return 0;
+}
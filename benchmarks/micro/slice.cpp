@@ -0,0 +1,38 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+#define SDF_HEADLESS true
+#include <sdf/sdf.hpp>
+#include <solver/slice/slicer.hpp>
+#include <glm/glm.hpp>
+
+/*
+    Layers per second when slicing a part about 40mm wide, at 25µm on the XY plane and 0.2mm layers.
+*/
+
+static void run(const char* label, const auto& sdf){
+    solver::slice::config_t cfg;
+    cfg.resolution=0.025f;
+    cfg.layer_height=0.2f;
+    solver::slice::slicer slicer(sdf,cfg);
+
+    ankerl::nanobench::Bench().minEpochIterations(2).unit("layer").batch(slicer.layers()).run(label, [&] {
+        solver::slice::counter_t sink;
+        ankerl::nanobench::doNotOptimizeAway(slicer.run(sink,cfg));
+    });
+}
+
+int main() {
+    {
+        using namespace sdf::comptime;
+        auto part = Cut(Translate(Sphere({4.0}),{glm::vec3{10,0,0}}),Join(Sphere({12.0}),Box({glm::vec3{20.0,4.0,8.0}})));
+        run("comptime",part);
+    }
+
+    {
+        using namespace sdf::dynamic;
+        auto part = Cut(Translate(Sphere({4.0}),{glm::vec3{10,0,0}}),Join(Sphere({12.0}),Box({glm::vec3{20.0,4.0,8.0}})));
+        run("frozen",sdf::dynamic::freeze(part));
+    }
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+
+#include <cstdio>
+#include <glm/glm.hpp>
+
+#define SDF_SHARED_SLOTS
+#include <utils/shared.hpp>
+shared_map<16> global_shared;
+
+#include <sdf/sdf.hpp>
+#include <scene-import/packed.hpp>
+
+/*
+    Startup cost of a scene, from its description to the moment it can be sampled via `Interpreted`.
+    The dynamic graph is what parse_xml generates, so the first case is a lower bound for the XML loader.
+*/
+
+constexpr size_t NODES = 4000;
+constexpr const char* PATH = "./startup-bench.enpack";
+
+static std::shared_ptr<sdf::utils::base_dyn<sdf::default_attrs>> make_scene(){
+    using namespace sdf::dynamic;
+    auto scene = Translate(Sphere({1.0}),{glm::vec3{0,0,0}});
+    for(size_t i=1;i<NODES;i++){
+        scene = Join(scene,Translate(Sphere({1.0}),{glm::vec3{i*2.0f,0,0}}));
+    }
+    return scene;
+}
+
+int main() {
+    {
+        auto scene = make_scene();
+        sdf::tree::builder builder;
+        builder.close(scene->to_tree(builder));
+        sdf::packed::writer<sdf::default_attrs> packed(builder);
+        packed.name("root",scene->addr());
+        if(!packed.save(PATH)){printf("Unable to write %s\n",PATH);return 1;}
+    }
+
+    {
+        float d = 0.0;
+        ankerl::nanobench::Bench().minEpochIterations(4).run("dynamic graph + to_tree + make_shared", [&] {
+            auto scene = make_scene();
+            sdf::tree::builder builder;
+            builder.close(scene->to_tree(builder));
+            builder.make_shared(2);
+            d+=sdf::comptime::Interpreted_t<sdf::default_attrs>(2).sample({0,0,0});
+            ankerl::nanobench::doNotOptimizeAway(d);
+        });
+    }
+
+    {
+        float d = 0.0;
+        ankerl::nanobench::Bench().minEpochIterations(4).run("packed mmap + assign", [&] {
+            sdf::packed::mapped scene(PATH);
+            scene.bind(3);
+            d+=sdf::comptime::Interpreted_t<sdf::default_attrs>(3).sample({0,0,0});
+            ankerl::nanobench::doNotOptimizeAway(d);
+        });
+    }
+
+    std::remove(PATH);
+    return 0;
+}
@@ -4,13 +4,17 @@
 #include <sdf/sdf.hpp>
 #include <glm/glm.hpp>
 
+/*
+    Sampling a scene of two spheres on a 4000x2000 grid, serially and through each of the OpenMP constructs.
+*/
+
 int main() {
     using namespace sdf::comptime;
     auto sdf_a = Sphere({{0,3,2}})+glm::vec3{0,0,2}+Sphere({{0,3,1}});
 
     {
         double d = 1.0;
-        ankerl::nanobench::Bench().minEpochIterations(1).run("some double ops", [&] {
+        ankerl::nanobench::Bench().minEpochIterations(1).run("two spheres, serial", [&] {
             for(int i=0;i<4000;i++)
                 for(int j=0;j<2000;j++)
                     d+=sdf_a({i,j,0.0}).distance;
@@ -20,7 +24,7 @@ int main() {
 
     {
         double d = 1.0;
-        ankerl::nanobench::Bench().minEpochIterations(1).run("some double ops", [&] {
+        ankerl::nanobench::Bench().minEpochIterations(1).run("two spheres, parallel for simd", [&] {
             #pragma omp parallel for simd collapse(2) reduction(+:d)
             for(int i=0;i<4000;i++)
                 for(int j=0;j<2000;j++)
@@ -31,7 +35,7 @@ int main() {
 
     {
         double d = 1.0;
-        ankerl::nanobench::Bench().minEpochIterations(1).run("some double ops", [&] {
+        ankerl::nanobench::Bench().minEpochIterations(1).run("two spheres, teams", [&] {
             #pragma omp teams distribute parallel for  collapse(2) reduction(+:d)
             for(int i=0;i<4000;i++)
                 for(int j=0;j<2000;j++)
@@ -42,7 +46,7 @@ int main() {
 
     {
         double d = 1.0;
-        ankerl::nanobench::Bench().minEpochIterations(1).run("some double ops", [&] {
+        ankerl::nanobench::Bench().minEpochIterations(1).run("two spheres, target teams", [&] {
             #pragma omp target teams distribute parallel for collapse(2) reduction(+:d)
             for(int i=0;i<4000;i++)
                 for(int j=0;j<2000;j++)
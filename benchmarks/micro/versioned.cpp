@@ -0,0 +1,69 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+
+#include <glm/glm.hpp>
+
+#define SDF_SHARED_SLOTS
+#include <utils/shared.hpp>
+shared_map<4> global_shared;
+
+#include <sdf/sdf.hpp>
+#include <sdf/versioned.hpp>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+/*
+    Cost of the versioned scene on both sides: taking a snapshot at the start of a frame, and publishing an edit.
+    Frames are simulated by a reader thread holding each snapshot for a while, and checking that the version it sees is never half written.
+    Each version is a buffer filled with a single byte, so a torn one would have mixed values.
+*/
+
+constexpr size_t SIZE = 1<<20;
+
+int main() {
+    sdf::versioned scene(0,3);
+    std::vector<uint8_t> bytes(SIZE,0);
+    scene.publish(bytes.data(),bytes.size());
+
+    ankerl::nanobench::Bench().minEpochIterations(1000).run("acquire, no writer", [&] {
+        auto snapshot = scene.acquire();
+        ankerl::nanobench::doNotOptimizeAway(snapshot.slot());
+    });
+
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> frames = 0, torn = 0;
+    std::thread reader([&]{
+        while(!stop.load()){
+            auto snapshot = scene.acquire();
+            auto view = global_shared[snapshot.slot()];
+            auto data = (const uint8_t*)view.base;
+            for(size_t i=0;i<view.size;i+=4096)if(data[i]!=data[0]){torn++;break;}
+            frames++;
+        }
+    });
+
+    size_t failed = 0;
+    uint8_t next = 1;
+    ankerl::nanobench::Bench().minEpochIterations(20).unit("version").run("publish 1MB, reader holding frames", [&] {
+        memset(bytes.data(),next,bytes.size());
+        if(scene.publish(bytes.data(),bytes.size()))next++;
+        else failed++;
+    });
+
+    ankerl::nanobench::Bench().minEpochIterations(20).unit("version").run("edit 1MB, reader holding frames", [&] {
+        if(!scene.edit([&](uint8_t* data, size_t size){memset(data,next,size);return true;}))failed++;
+        else next++;
+    });
+
+    ankerl::nanobench::Bench().minEpochIterations(1000).run("acquire, writer active", [&] {
+        auto snapshot = scene.acquire();
+        ankerl::nanobench::doNotOptimizeAway(snapshot.slot());
+    });
+
+    stop = true;
+    reader.join();
+    printf("%llu versions, %zu publications rejected with all slots busy, %zu frames, %zu torn\n",(unsigned long long)scene.version(),failed,frames.load(),torn.load());
+    return torn==0?0:1;
+}
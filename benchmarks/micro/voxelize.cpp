@@ -0,0 +1,53 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+#define SDF_HEADLESS true
+#include <sdf/sdf.hpp>
+#include <pipeline/voxelize.hpp>
+#include <glm/glm.hpp>
+#include <filesystem>
+
+/*
+    Layers per second when rasterizing a part about 40mm wide with 50µm pixels, evaluation alone and with encoding and writing to disk.
+*/
+
+static void run(const char* label, const auto& sdf){
+    using voxelize = pipeline::voxelize<std::remove_cvref_t<decltype(sdf)>>;
+    auto cfg = voxelize::fit(sdf,0.05f,0.05f);
+    auto dir = std::filesystem::temp_directory_path()/"enamento-voxelize";
+    std::filesystem::create_directories(dir);
+    cfg.prefix = (dir/"layer-").string();
+
+    voxelize vox(omp_get_default_device(),sdf,cfg);
+    std::vector<uint8_t> buffer(cfg.size.x*cfg.size.y);
+
+    ankerl::nanobench::Bench().minEpochIterations(20).unit("layer").run(std::string(label)+" (evaluate)", [&] {
+        vox.layer(cfg.layers/2,buffer.data());
+        ankerl::nanobench::doNotOptimizeAway(buffer[0]);
+    });
+
+    for(auto encoding : {voxelize::PNG,voxelize::RLE}){
+        cfg.encoding = encoding;
+        voxelize writer(omp_get_default_device(),sdf,cfg);
+        ankerl::nanobench::Bench().minEpochIterations(1).unit("layer").batch(cfg.layers).run(std::string(label)+(encoding==voxelize::PNG?" (png)":" (rle)"), [&] {
+            ankerl::nanobench::doNotOptimizeAway(writer.run());
+        });
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+int main() {
+    {
+        using namespace sdf::comptime;
+        auto part = Cut(Translate(Sphere({4.0}),{glm::vec3{10,0,0}}),Join(Sphere({12.0}),Box({glm::vec3{20.0,4.0,8.0}})));
+        run("comptime",part);
+    }
+
+    {
+        using namespace sdf::dynamic;
+        auto part = Cut(Translate(Sphere({4.0}),{glm::vec3{10,0,0}}),Join(Sphere({12.0}),Box({glm::vec3{20.0,4.0,8.0}})));
+        run("frozen",sdf::dynamic::freeze(part));
+    }
+
+    return 0;
+}
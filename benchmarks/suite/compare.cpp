@@ -0,0 +1,94 @@
+/**
+ * @file compare.cpp
+ * @author karurochari
+ * @brief Compare two reports of the benchmark suite, flagging regressions.
+ * @date 2025-04-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Cases are matched by scene, backend and workload. A case regresses when its time per item grows more than the threshold,
+ * and more than the error of the two measurements combined, so that noisy cases are not flagged.
+ * It only reads the reports written by the suite, which have one result per line.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <tuple>
+
+struct entry_t{
+    double ns;
+    double error;
+};
+
+using case_t = std::tuple<std::string,std::string,std::string>;
+
+static std::string field(const std::string& line, const char* name){
+    auto key = std::string("\"")+name+"\": ";
+    auto start = line.find(key);
+    if(start==std::string::npos)return {};
+    start+=key.size();
+    if(line[start]=='"'){
+        auto end = line.find('"',start+1);
+        return line.substr(start+1,end-start-1);
+    }
+    auto end = line.find_first_of(",}",start);
+    return line.substr(start,end-start);
+}
+
+static bool load(const char* path, std::map<case_t,entry_t>& out, std::string& commit){
+    std::ifstream in(path);
+    if(!in)return false;
+    std::string line;
+    while(std::getline(in,line)){
+        if(line.find("\"commit\":")!=std::string::npos)commit=field(line,"commit");
+        if(line.find("\"ns_per_item\":")==std::string::npos)continue;
+        out[{field(line,"scene"),field(line,"backend"),field(line,"workload")}]={atof(field(line,"ns_per_item").c_str()),atof(field(line,"error_pct").c_str())};
+    }
+    return true;
+}
+
+int main(int argc, const char** argv){
+    if(argc<3){
+        printf("Usage: %s <before.json> <after.json> [threshold %%, default 5]\n",argv[0]);
+        return 2;
+    }
+    double threshold = argc>3?atof(argv[3]):5.0;
+
+    std::map<case_t,entry_t> before, after;
+    std::string commit_before, commit_after;
+    if(!load(argv[1],before,commit_before)){printf("Unable to read %s\n",argv[1]);return 2;}
+    if(!load(argv[2],after,commit_after)){printf("Unable to read %s\n",argv[2]);return 2;}
+
+    printf("Comparing %s (%s) with %s (%s)\n\n",argv[1],commit_before.c_str(),argv[2],commit_after.c_str());
+    printf("| %-40s | %14s | %14s | %8s |\n","case","before ns/item","after ns/item","change");
+    printf("|%s|%s|%s|%s|\n",std::string(42,'-').c_str(),std::string(16,'-').c_str(),std::string(16,'-').c_str(),std::string(10,'-').c_str());
+
+    size_t regressions = 0, improvements = 0;
+    for(auto& [key,b] : before){
+        auto it = after.find(key);
+        auto label = std::get<0>(key)+"/"+std::get<1>(key)+"/"+std::get<2>(key);
+        if(it==after.end()){
+            printf("| %-40s | %14.2f | %14s | %8s |\n",label.c_str(),b.ns,"missing","");
+            continue;
+        }
+        auto& a = it->second;
+        double change = (a.ns/b.ns-1.0)*100.0;
+        double noise = std::max(threshold,b.error+a.error);
+        const char* mark = "";
+        if(change>noise){mark=" <- slower";regressions++;}
+        else if(change<-noise){mark=" <- faster";improvements++;}
+        printf("| %-40s | %14.2f | %14.2f | %+7.1f%% |%s\n",label.c_str(),b.ns,a.ns,change,mark);
+    }
+    for(auto& [key,a] : after){
+        if(before.contains(key))continue;
+        auto label = std::get<0>(key)+"/"+std::get<1>(key)+"/"+std::get<2>(key);
+        printf("| %-40s | %14s | %14.2f | %8s |\n",label.c_str(),"new",a.ns,"");
+    }
+
+    printf("\n%zu slower, %zu faster, threshold %.1f%%\n",regressions,improvements,threshold);
+    return regressions>0?1:0;
+}
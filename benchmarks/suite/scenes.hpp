@@ -0,0 +1,89 @@
+#pragma once
+
+/**
+ * @file scenes.hpp
+ * @author karurochari
+ * @brief Reference scenes for the benchmark suite, from a handful of nodes to tens of thousands.
+ * @date 2025-04-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Scenes are built as dynamic trees, which all the other backends are derived from.
+ * The small ones are also spelled out as comptime and polymorphic trees in the suite, as those can only be written by hand.
+ */
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace bench{
+
+using dyn_t = std::shared_ptr<sdf::utils::base_dyn<sdf::default_attrs>>;
+
+struct scene_t{
+    std::string name;
+    dyn_t       root;
+    sdf::bbox_t box;                //Region sampled, rendered and baked
+    glm::vec3   camera;
+};
+
+//As examples/sample-sdf.cpp
+inline scene_t sample(){
+    using namespace sdf::dynamic;
+    using glm::vec3;
+    auto root = Join(
+        Join(
+            SmoothJoin(Sphere({1.0}),Translate(Sphere({1.5}),{vec3{2.0,0.0,1.0}}),{0.5f}),
+            Translate(Box({vec3{1.0,2.0,3.0}}),{vec3{2.0,5.0,1.0}})
+        ),
+        Translate(Plane({}),{vec3{0.0,-1.0,0.0}})
+    );
+    return {"sample",root,{vec3{-8,-2,-8},vec3{8,8,8}},{0,3,-12}};
+}
+
+//As examples/test-1.xml
+inline scene_t test_1(){
+    using namespace sdf::dynamic;
+    using glm::vec3;
+    auto part = [](){return Join(Sphere({5.0}),Translate(Sphere({3.0}),{vec3{5,0,0}}));};
+    auto root = Join(part(),Join(part(),Join(part(),Join(part(),Translate(Sphere({3.0}),{vec3{5,5,0}})))));
+    return {"test-1",root,{vec3{-8,-8,-8},vec3{12,12,8}},{2,2,-30}};
+}
+
+inline dyn_t balanced(const std::vector<dyn_t>& items, size_t lo, size_t hi){
+    using namespace sdf::dynamic;
+    if(hi-lo==1)return items[lo];
+    size_t mid = (lo+hi)/2;
+    if(hi-lo<=4)return SmoothJoin(balanced(items,lo,mid),balanced(items,mid,hi),{0.4f});
+    return Join(balanced(items,lo,mid),balanced(items,mid,hi));
+}
+
+/**
+ * @brief Objects on a square grid, spheres alternating with rotated boxes.
+ * They are combined as a balanced tree, with smooth joins between neighbours and plain joins above.
+ *
+ * @param n number of objects, the scene has about 3.5 nodes per object
+ */
+inline scene_t grid(size_t n){
+    using namespace sdf::dynamic;
+    using glm::vec3;
+    size_t side = (size_t)std::ceil(std::sqrt((float)n));
+    std::vector<dyn_t> items;
+    items.reserve(n);
+    for(size_t i=0;i<n;i++){
+        vec3 pos = {(float)(i%side)*3.0f,0.0f,(float)(i/side)*3.0f};
+        if(i%2==0)items.push_back(Translate(Sphere({1.2}),{pos}));
+        else items.push_back(Translate(Rotate(Box({vec3{1.0,0.8,0.6}}),{vec3{0.3f*(i%7),0.5f*(i%5),0.0f}}),{pos}));
+    }
+
+    float extent = side*3.0f;
+    return {"grid-"+std::to_string(n),balanced(items,0,n),{vec3{-2,-2,-2},vec3{extent,2,extent}},{extent/2.0f,extent*0.6f,-extent*0.4f}};
+}
+
+inline std::vector<scene_t> scenes(){
+    return {sample(),test_1(),grid(64),grid(1024),grid(8192)};
+}
+
+}
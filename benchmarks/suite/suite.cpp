@@ -0,0 +1,229 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+
+#include <glm/glm.hpp>
+
+#define SDF_SHARED_SLOTS
+#include <utils/shared.hpp>
+shared_map<4> global_shared;
+
+#include <sdf/sdf.hpp>
+#include <sampler/octtree-3d.hpp>
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+#include <string>
+#include <vector>
+
+#include "scenes.hpp"
+
+/*
+    Reference scenes evaluated through every backend, for point sampling, attributes, full frames and octree baking.
+    Results are written as JSON, to be compared across commits with `bench-compare`.
+
+    Usage: suite [--output suite.json] [--commit <label>] [--filter <text>] [--dynlib <scene> <library.so>]
+    `--filter` keeps the cases whose "scene/backend/workload" contains the text.
+    `--dynlib` adds the Dynlib backend for a scene, from a library exporting all the `addr__*` entry points of `Dynlib`.
+*/
+
+constexpr size_t BUDGET = 1<<22;            //Evaluations of nodes per run, to size each workload on the scene
+constexpr int    MAX_STEPS = 128;
+constexpr size_t BAKE_NODES = 1024;         //Larger scenes take minutes to bake on the host, so they are skipped
+constexpr size_t SLOT_INTERPRETED = 0, SLOT_OCTREE = 1;
+
+struct result_t{
+    std::string scene;
+    size_t      nodes;
+    std::string backend;
+    std::string workload;
+    std::string unit;
+    size_t      items;
+    double      ns;                         //Median per item
+    double      error;                      //Median absolute percent error
+};
+
+struct suite_t{
+    std::vector<result_t> results;
+    std::string filter;
+
+    void measure(const bench::scene_t& scene, size_t nodes, const char* backend, const char* workload, const char* unit, size_t items, auto&& fn){
+        std::string label = scene.name+"/"+backend+"/"+workload;
+        if(!filter.empty() && label.find(filter)==std::string::npos)return;
+        ankerl::nanobench::Bench bench;
+        bench.minEpochIterations(1).unit(unit).batch(items).run(label,fn);
+        auto& r = bench.results().back();
+        results.push_back({scene.name,nodes,backend,workload,unit,items,
+            r.median(ankerl::nanobench::Result::Measure::elapsed)*1e9,
+            r.medianAbsolutePercentError(ankerl::nanobench::Result::Measure::elapsed)*100.0});
+    }
+
+    template<typename S>
+    void run(const bench::scene_t& scene, size_t nodes, const char* backend, const S& sdf, bool bake = true){
+        auto& box = scene.box;
+        auto extent = box.max-box.min;
+
+        //Points on a regular grid covering the region.
+        size_t points = std::clamp<size_t>(BUDGET/nodes,256,1<<16);
+        int side = (int)std::cbrt((float)points);
+        points = side*side*side;
+        auto at = [&](int i){return box.min+extent*(glm::vec3(i%side,(i/side)%side,i/(side*side))+0.5f)/(float)side;};
+
+        measure(scene,nodes,backend,"sample","sample",points,[&]{
+            float d = 0.0f;
+            for(int i=0;i<(int)points;i++)d+=sdf.sample(at(i));
+            ankerl::nanobench::doNotOptimizeAway(d);
+        });
+
+        //Attributes come with normals, which take several samples of each node, so fewer points are enough.
+        size_t stride = 16;
+        measure(scene,nodes,backend,"attrs","sample",points/stride,[&]{
+            float d = 0.0f;
+            for(int i=0;i<(int)points;i+=stride)d+=sdf(at(i)).distance;
+            ankerl::nanobench::doNotOptimizeAway(d);
+        });
+
+        //Sphere tracing from the camera of the scene towards the centre of its region, on all threads.
+        int size = std::clamp((int)std::sqrt((float)(BUDGET*omp_get_max_threads()/(nodes*32))),8,256);
+        measure(scene,nodes,backend,"render","pixel",size*size,[&]{
+            auto target = (box.min+box.max)/2.0f;
+            auto forward = glm::normalize(target-scene.camera);
+            auto right = glm::normalize(glm::cross(forward,glm::vec3{0,1,0}));
+            auto up = glm::cross(right,forward);
+            size_t hits = 0;
+            #pragma omp parallel for collapse(2) schedule(dynamic,16) reduction(+:hits)
+            for(int i=0;i<size;i++)
+                for(int j=0;j<size;j++){
+                    auto rd = glm::normalize(forward+right*((j+0.5f)/size-0.5f)+up*((i+0.5f)/size-0.5f));
+                    float t = 0.0f;
+                    for(int k=0;k<MAX_STEPS;k++){
+                        float d = sdf.sample(scene.camera+t*rd);
+                        if(d<sdf::EPS){hits++;break;}
+                        t+=d;
+                    }
+                }
+            ankerl::nanobench::doNotOptimizeAway(hits);
+        });
+
+        if constexpr(sdf::sdf_i<S>){
+            if(!bake || nodes>=BAKE_NODES)return;
+            uint depth = nodes<128?6:nodes<4096?4:3;
+            float side = glm::max(extent.x,glm::max(extent.y,extent.z));
+            sampler::octatree3D::builder octree(sdf,depth,(box.min+box.max)/2.0f,side);
+            octree.build();
+            measure(scene,nodes,backend,"bake","cell",octree.stats().cells,[&]{
+                octree.build();
+                ankerl::nanobench::doNotOptimizeAway(octree.stats());
+            });
+        }
+    }
+
+    bool save(const char* path, const char* commit) const{
+        auto file = fopen(path,"w");
+        if(file==nullptr)return false;
+        fprintf(file,"{\n  \"version\": 1,\n  \"commit\": \"%s\",\n  \"compiler\": \"%s\",\n  \"threads\": %d,\n  \"results\": [\n",commit,__VERSION__,omp_get_max_threads());
+        for(size_t i=0;i<results.size();i++){
+            auto& r = results[i];
+            fprintf(file,"    {\"scene\": \"%s\", \"nodes\": %zu, \"backend\": \"%s\", \"workload\": \"%s\", \"unit\": \"%s\", \"items\": %zu, \"ns_per_item\": %.4f, \"error_pct\": %.3f}%s\n",
+                r.scene.c_str(),r.nodes,r.backend.c_str(),r.workload.c_str(),r.unit.c_str(),r.items,r.ns,r.error,i+1<results.size()?",":"");
+        }
+        fprintf(file,"  ]\n}\n");
+        return fclose(file)==0;
+    }
+};
+
+int main(int argc, const char** argv){
+    const char* output = "suite.json";
+    const char* commit = "";
+    std::vector<std::pair<std::string,std::string>> dynlibs;
+    suite_t suite;
+
+    for(int i=1;i<argc;i++){
+        if(strcmp(argv[i],"--output")==0 && i+1<argc)output=argv[++i];
+        else if(strcmp(argv[i],"--commit")==0 && i+1<argc)commit=argv[++i];
+        else if(strcmp(argv[i],"--filter")==0 && i+1<argc)suite.filter=argv[++i];
+        else if(strcmp(argv[i],"--dynlib")==0 && i+2<argc){dynlibs.push_back({argv[i+1],argv[i+2]});i+=2;}
+        else{
+            printf("Usage: %s [--output suite.json] [--commit <label>] [--filter <text>] [--dynlib <scene> <library.so>]\n",argv[0]);
+            return 1;
+        }
+    }
+
+    for(auto& scene : bench::scenes()){
+        sdf::tree::builder builder;
+        builder.close(scene.root->to_tree(builder));
+        size_t nodes = builder.stats.nodes;
+
+        //Only the small scenes can be written by hand as comptime and polymorphic trees.
+        if(scene.name=="sample"){
+            using glm::vec3;
+            {
+                using namespace sdf::comptime;
+                auto root = Join(Join(SmoothJoin(Sphere({1.0}),Translate(Sphere({1.5}),{vec3{2.0,0.0,1.0}}),{0.5f}),Translate(Box({vec3{1.0,2.0,3.0}}),{vec3{2.0,5.0,1.0}})),Translate(Plane({}),{vec3{0.0,-1.0,0.0}}));
+                suite.run(scene,nodes,"comptime",root);
+            }
+            {
+                using namespace sdf::polymorphic;
+                auto root = Join(Join(SmoothJoin(Sphere({1.0}),Translate(Sphere({1.5}),{vec3{2.0,0.0,1.0}}),{0.5f}),Translate(Box({vec3{1.0,2.0,3.0}}),{vec3{2.0,5.0,1.0}})),Translate(Plane({}),{vec3{0.0,-1.0,0.0}}));
+                suite.run(scene,nodes,"polymorphic",root);
+            }
+        }
+        else if(scene.name=="test-1"){
+            using glm::vec3;
+            {
+                using namespace sdf::comptime;
+                auto part = [](){return Join(Sphere({5.0}),Translate(Sphere({3.0}),{vec3{5,0,0}}));};
+                auto root = Join(part(),Join(part(),Join(part(),Join(part(),Translate(Sphere({3.0}),{vec3{5,5,0}})))));
+                suite.run(scene,nodes,"comptime",root);
+            }
+            {
+                using namespace sdf::polymorphic;
+                auto part = [](){return Join(Sphere({5.0}),Translate(Sphere({3.0}),{vec3{5,0,0}}));};
+                auto root = Join(part(),Join(part(),Join(part(),Join(part(),Translate(Sphere({3.0}),{vec3{5,5,0}})))));
+                suite.run(scene,nodes,"polymorphic",root);
+            }
+        }
+
+        suite.run(scene,nodes,"dynamic",*scene.root);
+
+        //Children are addressed by 16 bit offsets in flat trees, so larger ones cannot be frozen yet.
+        if(builder.bytes.size()>UINT16_MAX){
+            printf("%s: %zu bytes of tree, too large for the flat backends\n",scene.name.c_str(),builder.bytes.size());
+        }
+        else{
+            auto frozen = sdf::dynamic::freeze(scene.root);
+            suite.run(scene,nodes,"frozen",frozen);
+
+            builder.make_shared(SLOT_INTERPRETED);
+            suite.run(scene,nodes,"interpreted",sdf::comptime::Interpreted_t<sdf::default_attrs>(SLOT_INTERPRETED));
+
+            //The octree is the baked product, so it is only sampled.
+            if(nodes<BAKE_NODES){
+                auto extent = scene.box.max-scene.box.min;
+                sampler::octatree3D::builder octree(frozen,nodes<128?8:5,(scene.box.min+scene.box.max)/2.0f,glm::max(extent.x,glm::max(extent.y,extent.z)));
+                octree.build();
+                if(octree.make_shared(SLOT_OCTREE)){
+                    suite.run(scene,nodes,"octa-sampled",sdf::comptime::OctaSampled3D({SLOT_OCTREE}),false);
+                }
+            }
+        }
+
+        #if SDF_IS_HOST==true
+        for(auto& [name,path] : dynlibs){
+            if(name!=scene.name)continue;
+            auto handle = dlopen(path.c_str(),RTLD_LAZY|RTLD_GLOBAL);
+            if(handle==nullptr){
+                printf("Unable to load %s: %s\n",path.c_str(),dlerror());
+                continue;
+            }
+            suite.run(scene,nodes,"dynlib",sdf::comptime::Dynlib(sdf::impl::Dynlib<sdf::default_attrs>(handle,omp_get_initial_device())));
+        }
+        #endif
+    }
+
+    if(!suite.save(output,commit)){
+        printf("Unable to write %s\n",output);
+        return 1;
+    }
+    printf("%zu results written to %s\n",suite.results.size(),output);
+    return 0;
+}
@@ -18,7 +18,17 @@
 #include <cstdlib>
 #include <filesystem>
 #include <ctime>
+#include <chrono>
+#include <thread>
 #include <dlfcn.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include "utils/jobs.hpp"
+#include "utils/trace.hpp"
+
+extern char** environ;
 
 struct so_compiler{
     namespace fs = std::filesystem;
@@ -39,6 +49,33 @@ struct so_compiler{
 
         void *dl_handle=nullptr;
 
+        //Run a shell command in its own process group, so that it can be stopped with all its children.
+        static int run(const std::string& command, jobs::status_t* status){
+            const char* argv[] = {"/bin/sh","-c",command.c_str(),nullptr};
+            posix_spawnattr_t attr;
+            posix_spawnattr_init(&attr);
+            posix_spawnattr_setflags(&attr,POSIX_SPAWN_SETPGROUP);
+            posix_spawnattr_setpgroup(&attr,0);
+            pid_t pid;
+            int ret = posix_spawn(&pid,"/bin/sh",nullptr,&attr,(char* const*)argv,environ);
+            posix_spawnattr_destroy(&attr);
+            if(ret!=0)return -1;
+
+            int wstatus = 0;
+            for(;;){
+                auto done = waitpid(pid,&wstatus,status!=nullptr?WNOHANG:0);
+                if(done==pid)break;
+                if(done<0)return -1;
+                if(status->cancelled()){
+                    kill(-pid,SIGTERM);
+                    waitpid(pid,&wstatus,0);
+                    return -1;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return WIFEXITED(wstatus)?WEXITSTATUS(wstatus):-1;
+        }
+
     public:
 
         so_compiler(platform_t platform, std::string_view compiler = "clang++", std::string_view include_path = {}, std::string_view lib_path = {}):
@@ -57,8 +94,18 @@ struct so_compiler{
             dl_handle=nullptr;
         }
 
-        bool build(std::string_view code){
+        /**
+         * @brief Compile the code as a shared library and load it.
+         *
+         * @param code
+         * @param status if set, progress is reported there in steps (write, compile, load), and cancellation stops the compiler
+         * @return true on success
+         * @return false on failure or if cancelled
+         */
+        bool build(std::string_view code, jobs::status_t* status = nullptr){
+            trace::scope _trace("jit","compile");
             reset();
+            if(status!=nullptr)status->expect(3);
 
             auto time = std::time(0);
             tmp_src = fs::temp_directory_path()/std::format("sdf-{}.cpp",time);
@@ -74,6 +121,10 @@ struct so_compiler{
                 ofs.write(code.data(),code.size());
                 ofs.close();
             }
+            if(status!=nullptr){
+                if(status->cancelled())return false;
+                status->advance();
+            }
 
             //Compile
             {
@@ -85,12 +136,14 @@ struct so_compiler{
 
                 std::string command = std::format("{} -fvisibility=hidden -O3 -std=c++23 -Wno-return-type-c-linkage -shared -fPIC {} {} -o {} -L{} -I{} -lstdc++ -lvssdf ",compiler,platforms[platform],tmp_src.c_str(),tmp_so.c_str(),lib_path,include_path);
                 std::cout << "Compiling library with command: " << command << std::endl;
-                int ret = std::system(command.c_str());
+                int ret = run(command,status);
+                if(status!=nullptr && status->cancelled())return false;
                 if (ret != 0) {
                     std::cerr << "Compilation failed with code: " << ret << std::endl;
                     return false;
                 }
             }
+            if(status!=nullptr)status->advance();
 
             //Prepare dl handle
             {
@@ -101,6 +154,7 @@ struct so_compiler{
                 }
                 dlerror(); // Reset errors
             }
+            if(status!=nullptr)status->advance();
 
             return true;
         }
@@ -10,10 +10,14 @@
  * 
  */
 
+#include <atomic>
 #include <glm/glm.hpp>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include "solver/projection/base.hpp"
 #include "../sdf/sdf.hpp"
+#include "../utils/trace.hpp"
 
 namespace pipeline{
 
@@ -41,6 +45,34 @@ namespace utils{
         auto y = pow2ceil(screen.y);
         return {{x.first,y.first},std::min(x.second,y.second)};
     }
+
+    /**
+     * @brief Element of the Halton sequence, to spread subpixel offsets evenly across samples.
+     *
+     * @param i index in the sequence, starting from 1
+     * @param base a prime, different for each dimension
+     * @return float in [0,1)
+     */
+    inline float halton(uint32_t i, uint32_t base){
+        float f = 1.0f, ret = 0.0f;
+        while(i>0){
+            f/=base;
+            ret+=f*(i%base);
+            i/=base;
+        }
+        return ret;
+    }
+}
+
+namespace layers{
+    //Placeholder for the dynamic layer of pipelines which do not have one.
+    struct none_t{};
+
+    template<typename SDF>
+    struct of{using type = solver::projection::base<SDF>;};
+
+    template<>
+    struct of<void>{using type = none_t;};
 }
 
 struct material_t{
@@ -61,8 +93,20 @@ struct material_t{
 };
 
 
-template<typename SDF, bool cone_march = false>
+/**
+ * @brief Demo renderer, with edges highlighted over flat materials.
+ *
+ * @tparam SDF the scene, or its static part if `DYNAMIC` is set
+ * @tparam cone_march
+ * @tparam DYNAMIC optional tree for the moving parts of the scene, sharing the attributes of `SDF`.
+ *         When set, the first pass of the static tree is cached and only marched again when the camera or the static tree change.
+ *         Each frame only marches the dynamic tree, bounded by the cached depth, and keeps the closest of the two.
+ */
+template<typename SDF, bool cone_march = false, typename DYNAMIC = void>
 struct demo{
+    static constexpr bool layered = !std::is_void_v<DYNAMIC>;
+    using dynamic_t = std::conditional_t<layered,DYNAMIC,layers::none_t>;
+
     private:
         int device;
 
@@ -75,26 +119,56 @@ struct demo{
 
         //On device
         fields_t*   layer_0 = nullptr;
+        fields_t*   layer_static = nullptr;     //Cached first pass of the static tree, if layered
         glm::vec4*  sobel_base = nullptr;
         glm::vec4*  sobel_dilate = nullptr;
         material_t* materials = nullptr;
 
         //On host
         glm::u8vec4*output = nullptr;
-        
+        std::vector<glm::vec4> history;     //Sum of the samples of a still view
+        uint32_t history_samples = 0;
+
+        uint32_t sample = 0;
+        glm::vec2 jitter = {0,0};           //Subpixel offset of the primary rays, in render pixels
+
         solver::projection::base<SDF> scene;
+        typename layers::of<DYNAMIC>::type dynamic;
+
+        //The cached static layer is valid for this view only.
+        bool static_valid = false;
+        struct view_t{
+            solver::projection::base_camera_t camera;
+            int width, height, max_steps;
+            glm::vec2 jitter;
+        }static_view = {};
+
+        constexpr static int PACKET = 8;    //Side of the packets of primary rays, when rendering on the host
+        constexpr static int MAX_STEPS_SCALE = 4;   //Growth of the step budget across refinements
 
     public:
 
+    //Fields of each pixel after the first pass
+    using output_t = fields_t;
+
     void cleanup(){
         omp_target_free(layer_0,device);
+        omp_target_free(layer_static,device);
         omp_target_free(sobel_base,device);
         omp_target_free(sobel_dilate,device);
         omp_free(output);
     }
 
-    demo(int device, SDF& sdf, const material_t* mats, size_t mats_n):device(device),scene(sdf){
+    demo(int device, SDF& sdf, const material_t* mats, size_t mats_n) requires (!layered):device(device),scene(sdf){
+        materials = (material_t*) omp_target_alloc(sizeof(material_t)*mats_n,device);
+        trace::scope _trace("materials","transfer");
+        omp_target_memcpy(materials,mats,mats_n*sizeof(material_t),0,0,device,omp_get_device_num());
+    }
+
+    demo(int device, SDF& sdf, dynamic_t& dyn, const material_t* mats, size_t mats_n) requires layered:device(device),scene(sdf),dynamic(dyn){
+        static_assert(std::is_same_v<typename SDF::attrs_t,typename dynamic_t::attrs_t>, "The static and dynamic trees must share their attributes");
         materials = (material_t*) omp_target_alloc(sizeof(material_t)*mats_n,device);
+        trace::scope _trace("materials","transfer");
         omp_target_memcpy(materials,mats,mats_n*sizeof(material_t),0,0,device,omp_get_device_num());
     }
     
@@ -116,8 +190,10 @@ struct demo{
         allocated = display_width*display_width/scale/scale;
         
         cleanup();
+        static_valid = false;
 
         layer_0 = (fields_t*) omp_target_alloc((display_width*display_width/scale/scale)*sizeof(fields_t),device);
+        if constexpr(layered)layer_static = (fields_t*) omp_target_alloc((display_width*display_width/scale/scale)*sizeof(fields_t),device);
         sobel_base = (glm::vec4*) omp_target_alloc((display_width*display_width)*sizeof(glm::vec4),device);
         sobel_dilate = (glm::vec4*) omp_target_alloc((display_width*display_width)*sizeof(glm::vec4),device);
         output = (glm::u8vec4*) omp_alloc(display_width*display_height*sizeof(glm::u8vec4));
@@ -125,19 +201,73 @@ struct demo{
         return 0;
     }
 
+    /**
+     * @brief Set the view of the next frame.
+     * Refinements of a still view (`camera.sample>0`) are rendered at full resolution with a larger step budget and jittered rays, and averaged with the previous ones.
+     */
     void set_camera(const solver::projection::screen_camera_t& camera){
-        resize(camera.canvas_width, camera.canvas_height, camera.resolution_scale);
+        sample = camera.sample;
+        resize(camera.canvas_width, camera.canvas_height, sample>0?1.0f:camera.resolution_scale);
 
         render_height = display_height/scale;
         render_width = display_width/scale;
 
         scene.camera = camera;
+        scene.max_steps = solver::projection::base<SDF>::MAX_STEPS*std::min<int>(1+sample,MAX_STEPS_SCALE);
+        jitter = sample>0?glm::vec2{utils::halton(sample,2),utils::halton(sample,3)}-0.5f:glm::vec2{0,0};
+
+        if constexpr(layered){
+            dynamic.camera = camera;
+            dynamic.max_steps = scene.max_steps;
+
+            auto& c = static_view.camera;
+            const solver::projection::base_camera_t& n = camera;
+            bool same = c.pos==n.pos && c.rot==n.rot && c.zoom==n.zoom && c.projection==n.projection &&
+                        static_view.width==render_width && static_view.height==render_height &&
+                        static_view.max_steps==scene.max_steps && static_view.jitter==jitter;
+            if(!same){
+                static_valid = false;
+                static_view = {n,render_width,render_height,scene.max_steps,jitter};
+            }
+        }
+    }
+
+    //Size of the first pass, which is also the size of the fields downloaded by `download_fields`.
+    inline glm::ivec2 render_size() const{return {render_width,render_height};}
+
+    /**
+     * @brief Copy the fields of the last frame to the host, like depth and identifiers.
+     *
+     * @param out room for `render_size()` pixels, row major
+     * @return true on success
+     */
+    bool download_fields(output_t* out) const{
+        trace::scope _trace("fields","transfer");
+        return omp_target_memcpy(out,layer_0,render_width*render_height*sizeof(output_t),0,0,omp_get_initial_device(),device)==0;
+    }
+
+    //Swap the scene between frames, like a newer version of the same tree. For layered pipelines this is the static tree, and its cache is dropped.
+    void set_sdf(const SDF& sdf){
+        scene.sdf = sdf;
+        static_valid = false;
     }
 
+    //Swap the dynamic tree between frames, the static layer is kept.
+    void set_dynamic(const dynamic_t& sdf) requires layered{
+        dynamic.sdf = sdf;
+    }
+
+    //Drop the cached static layer, for changes the pipeline cannot see like data referenced by the static tree.
+    inline void invalidate(){static_valid = false;}
+
+    //True if the next frame will reuse the static layer.
+    inline bool static_cached() const{return static_valid;}
+
     glm::vec3 raycast(const glm::vec2& point){
         using namespace glm;
         vec2 coo = (point*scale-0.5f*vec2{display_width,display_height})/(float)display_height;
         vec3 ret;
+        trace::scope _trace("raycast","pass");
         #pragma omp target device(device)
         {
             ret = scene.raycast(coo);
@@ -145,25 +275,81 @@ struct demo{
         return ret;
     }
 
-    glm::u8vec4* render(glm::u8vec4* out=nullptr){
+    /**
+     * @brief Render a frame.
+     *
+     * @param out destination on the host, the internal buffer if null
+     * @param cancel checked between passes and while marching on the host, to drop frames which are no longer needed
+     * @return glm::u8vec4* the frame, or null if it was cancelled
+     */
+    glm::u8vec4* render(glm::u8vec4* out=nullptr, const std::atomic<bool>* cancel=nullptr){
         using namespace glm;
 
         if(out==nullptr)out=this->output;
+        auto cancelled = [&](){return cancel!=nullptr && cancel->load(std::memory_order_relaxed);};
+
+        //First Pass. For layered pipelines the static tree goes to its own cache, and is skipped while that is still valid.
+        trace::scope trace_march("march","pass");
+        if(layered && static_valid){/*Reused from a previous frame*/}
+        else if(device==omp_get_initial_device()){
+            //On the host, coherent primary rays are marched as packets.
+            fields_t* first = layered?layer_static:layer_0;
+            #pragma omp parallel for collapse(2) schedule(dynamic,1)
+            for (int i = 0; i < render_height; i+=PACKET) {
+                for (int j = 0; j < render_width; j+=PACKET) {
+                    if(cancelled())continue;
+                    fields_t tile[PACKET*PACKET];
+                    vec2 coo = ((vec2{j,i}+jitter)*scale-0.5f*vec2{display_width,display_height})/(float)display_height;
+                    scene.template render_packet<PACKET>(coo,scale/(float)display_height,tile);
+                    for(int y=0;y<PACKET && i+y<render_height;y++)
+                        for(int x=0;x<PACKET && j+x<render_width;x++)first[(i+y)*render_width+j+x]=tile[y*PACKET+x];
+                }
+            }
+        }
+        else{
+            #pragma omp target teams device(device) /*is_device_ptr(layer_0) is_device_ptr(sobel_base) is_device_ptr(sobel_dilate) these make amd64 build strange. investigate why?*/
+            {
 
-        //First Pass (only one layer in this rendering pipeline)
-        #pragma omp target teams device(device) /*is_device_ptr(layer_0) is_device_ptr(sobel_base) is_device_ptr(sobel_dilate) these make amd64 build strange. investigate why?*/
-        {
+                //Device buffers are reached through the mapped `this`, as in the other passes.
+                fields_t* dst = layered?layer_static:layer_0;
+                #pragma omp distribute parallel for collapse(2) schedule(static,1)
+                for (int i = 0; i < render_height; i++) {
+                    for (int j = 0; j < render_width; j++) {
+                        vec2 coo = ((vec2{j,i}+jitter)*scale-0.5f*vec2{display_width,display_height})/(float)display_height;
+                        dst[i*render_width+j]= scene.render(coo);
+                    }
+                }
+            }
+        }
 
-            #pragma omp distribute parallel for collapse(2) schedule(static,1)
-            for (int i = 0; i < render_height; i++) {
-                for (int j = 0; j < render_width; j++) {
-                    vec2 coo = (vec2{j,i}*scale-0.5f*vec2{display_width,display_height})/(float)display_height;
-                    layer_0[i*render_width+j]= scene.render(coo);
+        trace_march.close();
+        if(cancelled())return nullptr;
+
+        if constexpr(layered){
+            static_valid = true;
+
+            //Only the dynamic tree is marched on each frame, up to the static surface behind each pixel.
+            trace::scope trace_dynamic("dynamic","pass");
+            #pragma omp target teams device(device)
+            {
+                #pragma omp distribute parallel for collapse(2) schedule(static,1)
+                for (int i = 0; i < render_height; i++) {
+                    for (int j = 0; j < render_width; j++) {
+                        auto& back = layer_static[i*render_width+j];
+                        vec2 coo = ((vec2{j,i}+jitter)*scale-0.5f*vec2{display_width,display_height})/(float)display_height;
+                        auto front = dynamic.render_bounded(coo,back.depth);
+                        if(front.depth<back.depth)layer_0[i*render_width+j]={{front},front.depth,front.normals,front.iterations};
+                        else layer_0[i*render_width+j]=back;
+                    }
                 }
             }
+
+            trace_dynamic.close();
+            if(cancelled())return nullptr;
         }
 
         //Edge detection
+        trace::scope trace_sobel("sobel","pass");
         #pragma omp target teams device(device) 
         {             
             #pragma omp distribute parallel for collapse(2) schedule(static,1)
@@ -200,7 +386,11 @@ struct demo{
             }
         }
 
+        trace_sobel.close();
+        if(cancelled())return nullptr;
+
         //Dilate
+        trace::scope trace_dilate("dilate","pass");
         #pragma omp target teams device(device) 
         {             
             #pragma omp distribute parallel for collapse(2) schedule(static,1) 
@@ -249,9 +439,15 @@ struct demo{
             }
         }
 
+        trace_dilate.close();
+        if(cancelled())return nullptr;
+
+        //The frame is copied back to the host when leaving the data region, so it is traced as a transfer around the pass.
+        trace::scope trace_download("download","transfer");
         //u8vec4 *tmp = output;   //For some reason using output directly is illegal. I need a local copy. No idea why.
         #pragma omp target data map(from: out[0:display_width*display_height]) device(device)
         {
+            trace::scope trace_compose("compose","pass");
             #pragma omp target teams device(device) 
             {             
                 #pragma omp distribute parallel for collapse(2) schedule(static,1)
@@ -268,6 +464,23 @@ struct demo{
                 } 
             }
         }
+        trace_download.close();
+
+        //Refinements are averaged on the host, the first one restarts the history.
+        if(sample>0){
+            trace::scope trace_accumulate("accumulate","pass");
+            size_t pixels = display_width*display_height;
+            if(sample==1 || history.size()!=pixels){
+                history.assign(pixels,vec4{0});
+                history_samples = 0;
+            }
+            history_samples++;
+            #pragma omp parallel for
+            for(size_t i=0;i<pixels;i++){
+                history[i]+=vec4(out[i]);
+                out[i]=u8vec4(history[i]/(float)history_samples+0.5f);
+            }
+        }
         //memcpy(out,output,display_width*display_height*sizeof(glm::u8vec4));
         return out;
     }
@@ -0,0 +1,187 @@
+#pragma once
+
+/**
+ * @file query.hpp
+ * @author karurochari
+ * @brief Pipeline answering batches of geometric queries on an SDF, like raycasts and closest points, for physics and simulation clients.
+ * @date 2025-04-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Each batch is resolved by a single kernel on the selected device, one query per thread.
+ * Inputs and outputs go through device buffers owned by the pipeline, which are only reallocated when a batch is larger than all previous ones.
+ * When the device is the host the same code runs there, so clients do not need to know where queries are executed.
+ */
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdint>
+#include <omp.h>
+
+#include "../sdf/sdf.hpp"
+
+namespace pipeline{
+
+template<typename SDF>
+struct query{
+    using extras_t = typename SDF::attrs_t::extras_t;
+
+    struct config_t{
+        float       surface = sdf::EPS;         //Rays closer than this to a surface are hitting it
+        uint32_t    max_steps = 256;            //Upper limit for the samples along a ray
+        float       gradient_step = 1e-3f;      //Step of the central differences
+        uint32_t    projection_steps = 2;       //Iterations to project points on the surface, more are only needed for SDF which are not exact
+    };
+
+    struct ray_t{
+        glm::vec3   origin;
+        glm::vec3   direction;                  //Normalized
+        float       max_distance = INFINITY;
+    };
+
+    struct hit_t{
+        float       distance;                   //Along the ray, infinity if nothing was hit
+        glm::vec3   position;
+        glm::vec3   normal;
+        uint32_t    steps;
+        extras_t    fields;                     //Attributes of the surface, like its material
+    };
+
+    struct point_t{
+        float       distance;                   //Signed, as sampled
+        glm::vec3   gradient;
+        glm::vec3   projection;                 //Closest point on the surface
+    };
+
+    private:
+        int device;
+        SDF sdf;
+        config_t cfg;
+
+        void* device_in = nullptr;
+        void* device_out = nullptr;
+        size_t capacity_in = 0, capacity_out = 0;
+
+        void reserve(size_t in, size_t out){
+            if(in>capacity_in){
+                omp_target_free(device_in,device);
+                device_in = omp_target_alloc(in,device);
+                capacity_in = in;
+            }
+            if(out>capacity_out){
+                omp_target_free(device_out,device);
+                device_out = omp_target_alloc(out,device);
+                capacity_out = out;
+            }
+            if(device_in==nullptr || device_out==nullptr){
+                capacity_in = capacity_out = 0;
+                throw "Unable to allocate buffers for queries on the device";
+            }
+        }
+
+        static inline glm::vec3 gradient(const SDF& sdf, const glm::vec3& pos, float h){
+            return glm::vec3(
+                sdf.sample(pos+glm::vec3{h,0,0})-sdf.sample(pos-glm::vec3{h,0,0}),
+                sdf.sample(pos+glm::vec3{0,h,0})-sdf.sample(pos-glm::vec3{0,h,0}),
+                sdf.sample(pos+glm::vec3{0,0,h})-sdf.sample(pos-glm::vec3{0,0,h})
+            )/(2.0f*h);
+        }
+
+        static inline hit_t trace(const SDF& sdf, const ray_t& ray, const config_t& cfg){
+            float t = 0.0f;
+            uint32_t i = 0;
+            for(;i<cfg.max_steps;i++){
+                auto pos = ray.origin+t*ray.direction;
+                float d = sdf.sample(pos);
+                if(glm::abs(d)<cfg.surface){
+                    auto attrs = sdf(pos);
+                    return {t,pos,glm::normalize(gradient(sdf,pos,cfg.gradient_step)),i,attrs.fields};
+                }
+                t+=d;
+                if(t>ray.max_distance)break;
+            }
+            return {INFINITY,ray.origin+ray.direction*ray.max_distance,{0,0,0},i,{}};
+        }
+
+        static inline point_t project(const SDF& sdf, const glm::vec3& pos, const config_t& cfg){
+            float d = sdf.sample(pos);
+            auto g = gradient(sdf,pos,cfg.gradient_step);
+            auto p = pos;
+            float dp = d;
+            auto gp = g;
+            for(uint32_t i=0;i<cfg.projection_steps;i++){
+                float len = glm::length(gp);
+                if(len==0.0f)break;
+                p-=gp*(dp/len/len);
+                dp = sdf.sample(p);
+                if(glm::abs(dp)<cfg.surface)break;
+                gp = gradient(sdf,p,cfg.gradient_step);
+            }
+            return {d,g,p};
+        }
+
+    public:
+        query(int device, const SDF& sdf, const config_t& cfg = {}):device(device),sdf(sdf),cfg(cfg){}
+
+        ~query(){
+            omp_target_free(device_in,device);
+            omp_target_free(device_out,device);
+        }
+
+        query(const query&) = delete;
+        query& operator=(const query&) = delete;
+
+        inline const config_t& config() const{return cfg;}
+
+        /**
+         * @brief Cast a batch of rays.
+         *
+         * @param rays n rays, on the host
+         * @param out n results, on the host
+         * @param n
+         * @return size_t the number of rays which hit a surface
+         */
+        size_t raycast(const ray_t* rays, hit_t* out, size_t n){
+            if(n==0)return 0;
+            reserve(n*sizeof(ray_t),n*sizeof(hit_t));
+            ray_t* src = (ray_t*)device_in;
+            hit_t* dst = (hit_t*)device_out;
+            auto cfg = this->cfg;
+            omp_target_memcpy(src,rays,n*sizeof(ray_t),0,0,device,omp_get_initial_device());
+
+            size_t hits = 0;
+            #pragma omp target teams distribute parallel for device(device) is_device_ptr(src,dst) reduction(+:hits)
+            for(size_t i=0;i<n;i++){
+                dst[i]=trace(sdf,src[i],cfg);
+                hits+=!std::isinf(dst[i].distance);
+            }
+
+            omp_target_memcpy(out,dst,n*sizeof(hit_t),0,0,omp_get_initial_device(),device);
+            return hits;
+        }
+
+        /**
+         * @brief Distance, gradient and closest point on the surface for a batch of points.
+         *
+         * @param points n points, on the host
+         * @param out n results, on the host
+         * @param n
+         */
+        void closest(const glm::vec3* points, point_t* out, size_t n){
+            if(n==0)return;
+            reserve(n*sizeof(glm::vec3),n*sizeof(point_t));
+            glm::vec3* src = (glm::vec3*)device_in;
+            point_t* dst = (point_t*)device_out;
+            auto cfg = this->cfg;
+            omp_target_memcpy(src,points,n*sizeof(glm::vec3),0,0,device,omp_get_initial_device());
+
+            #pragma omp target teams distribute parallel for device(device) is_device_ptr(src,dst)
+            for(size_t i=0;i<n;i++){
+                dst[i]=project(sdf,src[i],cfg);
+            }
+
+            omp_target_memcpy(out,dst,n*sizeof(point_t),0,0,omp_get_initial_device(),device);
+        }
+};
+
+}
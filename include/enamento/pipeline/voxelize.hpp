@@ -0,0 +1,221 @@
+#pragma once
+
+/**
+ * @file voxelize.hpp
+ * @author karurochari
+ * @brief Pipeline slicing an SDF into one grayscale bitmap per layer, as used by resin (DLP/MSLA) printers.
+ * @date 2025-04-19
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Each layer is evaluated on the selected device, one row per thread. Along a row, the sampled distance tells how many of the following pixels
+ * are surely empty or surely full, so those spans are filled without sampling. Pixels close to the surface are anti-aliased from the distance.
+ *
+ * Layers go through a ring of `inflight` buffers. Evaluation, encoding and writing of a layer are OpenMP tasks depending on its buffer,
+ * so the next layers are evaluated while the previous ones are compressed and saved, and memory use does not depend on the number of layers.
+ */
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+#include "utils/png.hpp"
+#include "../sdf/sdf.hpp"
+
+namespace pipeline{
+
+namespace raster{
+    /**
+     * @brief Run length encoding of a grayscale bitmap.
+     * The stream starts with `ENRL`, width and height as little endian uint32, followed by runs as value (uint8) and length (LEB128).
+     */
+    inline void encode_rle(const uint8_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& out){
+        out.clear();
+        out.insert(out.end(),{'E','N','R','L'});
+        for(auto v : {width,height})for(int i=0;i<4;i++)out.push_back((v>>(8*i))&0xff);
+
+        size_t total = (size_t)width*height;
+        for(size_t i=0;i<total;){
+            size_t j = i+1;
+            while(j<total && pixels[j]==pixels[i])j++;
+            out.push_back(pixels[i]);
+            for(size_t n=j-i;;){
+                uint8_t byte = n&0x7f;
+                n>>=7;
+                out.push_back(byte|(n?0x80:0));
+                if(!n)break;
+            }
+            i=j;
+        }
+    }
+}
+
+template<typename SDF>
+struct voxelize{
+    enum encoding_t{PNG, RLE};
+
+    struct config_t{
+        glm::vec2   origin = {0,0};         //Corner of the first pixel on the XY plane
+        glm::uvec2  size = {0,0};           //In pixels
+        float       pixel = 0.05f;          //Side of a pixel
+        float       z0 = 0.0f;              //Height of the first layer, sampled in the middle of its thickness
+        float       layer_height = 0.05f;
+        uint32_t    layers = 0;
+        uint32_t    inflight = 4;           //Layers held in memory at once
+        encoding_t  encoding = PNG;
+        std::string prefix = "layer-";      //Files are named `<prefix><index>.png` or `.rle`
+    };
+
+    struct stats_t{
+        uint32_t    layers = 0;
+        uint32_t    failed = 0;             //Layers which could not be written
+        size_t      bytes = 0;              //Encoded size of all layers
+    };
+
+    /**
+     * @brief Configuration covering the bounding box of an SDF.
+     */
+    static config_t fit(const SDF& sdf, float pixel, float layer_height){
+        sdf::traits_t traits;
+        sdf.traits(traits);
+        auto& box = traits.outer_box;
+        if(any(isinf(box.min)) || any(isinf(box.max))){
+            throw "Voxelization requires a finite bounding box";
+        }
+        config_t ret;
+        ret.pixel = pixel;
+        ret.layer_height = layer_height;
+        ret.origin = glm::vec2(box.min);
+        ret.size = glm::uvec2(glm::ceil((glm::vec2(box.max)-glm::vec2(box.min))/pixel));
+        ret.z0 = box.min.z+layer_height/2.0f;
+        ret.layers = (uint32_t)std::ceil((box.max.z-box.min.z)/layer_height);
+        return ret;
+    }
+
+    private:
+        int device;
+        SDF sdf;
+        config_t cfg;
+
+        std::vector<uint8_t*> device_buffers;
+        std::vector<uint8_t*> host_buffers;
+
+        inline size_t bytes() const{return (size_t)cfg.size.x*cfg.size.y;}
+
+        void evaluate(uint32_t layer, uint32_t slot){
+            uint8_t* dst = device_buffers[slot];
+            float z = cfg.z0+layer*cfg.layer_height;
+            float pixel = cfg.pixel;
+            glm::vec2 origin = cfg.origin;
+            uint32_t width = cfg.size.x, height = cfg.size.y;
+
+            #pragma omp target teams distribute parallel for device(device) is_device_ptr(dst)
+            for(uint32_t y=0;y<height;y++){
+                uint8_t* row = dst+(size_t)y*width;
+                float py = origin.y+(y+0.5f)*pixel;
+                for(uint32_t x=0;x<width;){
+                    float d = sdf.sample({origin.x+(x+0.5f)*pixel,py,z});
+                    row[x]=(uint8_t)(glm::clamp(0.5f-d/pixel,0.0f,1.0f)*255.0f+0.5f);
+                    x++;
+                    //The k-th pixel after this one is at least |d|-k*pixel away from the surface, so it is fully empty or full while that exceeds half a pixel.
+                    float t = (glm::abs(d)-0.5f*pixel)/pixel;
+                    if(t>1.0f){
+                        uint32_t span = (uint32_t)std::ceil(t)-1;
+                        if(span>width-x)span=width-x;
+                        memset(row+x,d>0.0f?0:255,span);
+                        x+=span;
+                    }
+                }
+            }
+
+            omp_target_memcpy(host_buffers[slot],dst,bytes(),0,0,omp_get_initial_device(),device);
+        }
+
+        bool store(uint32_t layer, const uint8_t* src, size_t& written) const{
+            std::vector<uint8_t> encoded;
+            if(cfg.encoding==PNG)png::encode_gray(src,cfg.size.x,cfg.size.y,encoded);
+            else raster::encode_rle(src,cfg.size.x,cfg.size.y,encoded);
+
+            char name[32];
+            snprintf(name,sizeof(name),"%05u.%s",layer,cfg.encoding==PNG?"png":"rle");
+            FILE* fd = fopen((cfg.prefix+name).c_str(),"wb");
+            if(fd==nullptr)return false;
+            bool ok = fwrite(encoded.data(),encoded.size(),1,fd)==1;
+            ok&=fclose(fd)==0;
+            written=encoded.size();
+            return ok;
+        }
+
+    public:
+        voxelize(int device, const SDF& sdf, const config_t& cfg):device(device),sdf(sdf),cfg(cfg){
+            if(this->cfg.inflight==0)this->cfg.inflight=1;
+            for(uint32_t i=0;i<this->cfg.inflight;i++){
+                device_buffers.push_back((uint8_t*)omp_target_alloc(bytes(),device));
+                host_buffers.push_back((uint8_t*)omp_alloc(bytes()));
+            }
+        }
+
+        ~voxelize(){
+            for(auto ptr : device_buffers)omp_target_free(ptr,device);
+            for(auto ptr : host_buffers)omp_free(ptr);
+        }
+
+        voxelize(const voxelize&) = delete;
+        voxelize& operator=(const voxelize&) = delete;
+
+        inline const config_t& config() const{return cfg;}
+
+        /**
+         * @brief Evaluate a single layer, without encoding it.
+         *
+         * @param layer index of the layer
+         * @param out host buffer of `size.x*size.y` bytes
+         */
+        void layer(uint32_t layer, uint8_t* out){
+            evaluate(layer,0);
+            memcpy(out,host_buffers[0],bytes());
+        }
+
+        /**
+         * @brief Evaluate, encode and write all layers.
+         */
+        stats_t run(){
+            stats_t stats;
+            stats.layers = cfg.layers;
+            uint32_t failed = 0;
+            size_t total = 0;
+
+            #pragma omp parallel
+            #pragma omp single
+            for(uint32_t i=0;i<cfg.layers;i++){
+                uint32_t slot = i%cfg.inflight;
+                uint8_t* host = host_buffers[slot];
+
+                #pragma omp task depend(inout: host[0]) firstprivate(i,slot)
+                evaluate(i,slot);
+
+                #pragma omp task depend(inout: host[0]) firstprivate(i,host) shared(failed,total)
+                {
+                    size_t written = 0;
+                    bool ok = store(i,host,written);
+                    #pragma omp atomic
+                    total+=written;
+                    if(!ok){
+                        #pragma omp atomic
+                        failed++;
+                    }
+                }
+            }
+
+            stats.failed = failed;
+            stats.bytes = total;
+            return stats;
+        }
+};
+
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+/**
+ * @file instances.hpp
+ * @author karurochari
+ * @brief Buffer layout and builder for the transforms used by the `Instances` operator.
+ * @date 2025-04-15
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * The buffer is self-contained, so it can be moved into a shared slot and read on any device:
+ * - a header with the geometry of the grid and the offsets of each section;
+ * - the instances, as inverse affine transforms with an optional override of the attributes;
+ * - a uniform grid in CSR form, where each cell lists the instances whose bounding box gets close enough to it.
+ *
+ * Every instance is listed in all cells overlapping its bounding box expanded by `margin`.
+ * So from any point in a cell, the instances not listed are further than the distance to the cell boundary plus `margin`,
+ * which is what keeps the field a lower bound of the real distance while only visiting a handful of instances.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <vector>
+#include "sdf/commons.hpp"
+
+namespace sampler{
+
+namespace instances{
+
+using namespace glm;
+
+enum flags_t : uint32_t{
+    OVERRIDE = 1,       //Replace the attributes of the child with the ones of the instance
+};
+
+struct header_t{
+    uint32_t    count;              //Number of instances
+    uint32_t    cells;              //Number of cells in the grid
+    ivec3       dims;
+    float       cell_size;
+    vec3        min;                //Lower corner of the grid
+    float       margin;             //Geometry is always at least this far from the cells its instance is not listed in
+    uint32_t    instances_offset;   //Sections, as bytes from the start of the buffer
+    uint32_t    cells_offset;
+    uint32_t    items_offset;
+};
+
+template<typename Extras>
+struct instance_t{
+    mat3        inv_linear;         //World to local
+    vec3        inv_offset;
+    float       scale;              //Smallest singular value of the forward transform, to keep the distance bounded
+    uint32_t    flags;
+    Extras      extras;
+};
+
+struct cell_t{
+    uint32_t    begin;              //First item of the cell, the last one is given by the next cell
+    float       gap;                //Lower bound for the distance of all instances not listed in here from the cell boundary
+};
+
+template<typename Extras>
+inline const instance_t<Extras>* instances(const header_t* head){return (const instance_t<Extras>*)((const uint8_t*)head+head->instances_offset);}
+inline const cell_t* cells(const header_t* head){return (const cell_t*)((const uint8_t*)head+head->cells_offset);}
+inline const uint32_t* items(const header_t* head){return (const uint32_t*)((const uint8_t*)head+head->items_offset);}
+
+template <sdf::attrs_i Attrs>
+struct builder{
+    using extras_t = typename Attrs::extras_t;
+
+    struct entry_t{
+        mat3        linear;
+        vec3        offset;
+        uint32_t    flags;
+        extras_t    extras;
+    };
+
+    private:
+        std::vector<entry_t>    entries;
+        std::vector<uint8_t>    data;
+        sdf::bbox_t             child_box;
+        float                   cell_hint;
+        int                     max_dims;
+
+        constexpr static inline size_t align(size_t v){return (v+15)/16*16;}
+
+        //Smallest singular value of `m`, from the smallest eigenvalue of mᵀm (closed form for symmetric 3x3 matrices).
+        static float min_singular(const mat3& m){
+            dmat3 a = dmat3(transpose(m)*m);
+            double p1 = a[0][1]*a[0][1]+a[0][2]*a[0][2]+a[1][2]*a[1][2];
+            double lambda;
+            if(p1==0)lambda = glm::min(a[0][0],glm::min(a[1][1],a[2][2]));
+            else{
+                double q = (a[0][0]+a[1][1]+a[2][2])/3.0;
+                double p2 = (a[0][0]-q)*(a[0][0]-q)+(a[1][1]-q)*(a[1][1]-q)+(a[2][2]-q)*(a[2][2]-q)+2.0*p1;
+                double p = std::sqrt(p2/6.0);
+                double r = determinant((a-q*dmat3(1.0))/p)/2.0;
+                double phi = std::acos(glm::clamp(r,-1.0,1.0))/3.0;
+                lambda = q+2.0*p*std::cos(phi+2.0*std::numbers::pi/3.0);
+            }
+            return (float)std::sqrt(glm::max(lambda,0.0));
+        }
+
+        sdf::bbox_t world_box(const entry_t& entry) const{
+            sdf::bbox_t ret = {vec3(INFINITY),vec3(-INFINITY)};
+            for(int i=0;i<8;i++){
+                vec3 corner = {(i&1)?child_box.max.x:child_box.min.x,(i&2)?child_box.max.y:child_box.min.y,(i&4)?child_box.max.z:child_box.min.z};
+                corner = entry.linear*corner+entry.offset;
+                ret.min=glm::min(ret.min,corner);
+                ret.max=glm::max(ret.max,corner);
+            }
+            return ret;
+        }
+
+    public:
+
+        /**
+         * @brief Construct a new builder
+         *
+         * @param child_box bounding box of the child subtree in its own space. It must be finite.
+         * @param cell_size size of the cells in the grid, if zero it is the size of the largest instance.
+         * @param max_dims upper limit to the number of cells along each axis.
+         */
+        builder(const sdf::bbox_t& child_box, float cell_size = 0.0f, int max_dims = 64):child_box(child_box),cell_hint(cell_size),max_dims(max_dims){
+            if(any(isinf(child_box.min)) || any(isinf(child_box.max))){
+                throw "Instances require a child with a finite bounding box";
+            }
+        }
+
+        template <sdf::sdf_i SDF>
+        static builder from(const SDF& child, float cell_size = 0.0f, int max_dims = 64){
+            sdf::traits_t traits;
+            child.traits(traits);
+            return builder(traits.outer_box,cell_size,max_dims);
+        }
+
+        inline size_t add(const mat3& linear, const vec3& offset){
+            entries.push_back({linear,offset,0,{}});
+            return entries.size()-1;
+        }
+
+        inline size_t add(const mat3& linear, const vec3& offset, const extras_t& extras){
+            entries.push_back({linear,offset,OVERRIDE,extras});
+            return entries.size()-1;
+        }
+
+        inline void set(size_t i, const mat3& linear, const vec3& offset){
+            entries[i].linear=linear;
+            entries[i].offset=offset;
+        }
+
+        inline void set(size_t i, const extras_t& extras){
+            entries[i].flags|=OVERRIDE;
+            entries[i].extras=extras;
+        }
+
+        inline void unset(size_t i){entries[i].flags&=~OVERRIDE;}
+
+        inline entry_t& operator[](size_t i){return entries[i];}
+        inline const entry_t& operator[](size_t i) const{return entries[i];}
+        inline size_t size() const{return entries.size();}
+        inline void clear(){entries.clear();}
+
+        inline const header_t* stats() const{return data.empty()?nullptr:(const header_t*)data.data();}
+
+        /**
+         * @brief Generate the buffer from the current instances.
+         */
+        bool build(){
+            header_t head = {};
+            head.count=entries.size();
+
+            std::vector<sdf::bbox_t> boxes(entries.size());
+            float cell = cell_hint;
+            for(size_t i=0;i<entries.size();i++){
+                boxes[i]=world_box(entries[i]);
+                if(cell_hint<=0.0f){
+                    auto delta = boxes[i].max-boxes[i].min;
+                    cell=glm::max(cell,glm::max(delta.x,glm::max(delta.y,delta.z)));
+                }
+            }
+            if(cell<=0.0f)cell=1.0f;
+
+            if(entries.empty()){
+                head.dims={1,1,1};
+                head.min={0,0,0};
+                head.margin=INFINITY;
+            }
+            else{
+                //Half a cell is enough to never stall tracing at the cell boundaries, while keeping instances in few cells.
+                head.margin=cell*0.5f;
+                sdf::bbox_t grid = {vec3(INFINITY),vec3(-INFINITY)};
+                for(auto& box : boxes){
+                    box.min-=head.margin;
+                    box.max+=head.margin;
+                    grid.min=glm::min(grid.min,box.min);
+                    grid.max=glm::max(grid.max,box.max);
+                }
+                auto extent = grid.max-grid.min;
+                cell=glm::max(cell,glm::max(extent.x,glm::max(extent.y,extent.z))/max_dims);
+                head.dims=glm::clamp(ivec3(ceil(extent/cell)),ivec3(1),ivec3(max_dims));
+                head.min=grid.min;
+            }
+            head.cell_size=cell;
+            head.cells=head.dims.x*head.dims.y*head.dims.z;
+
+            auto index = [&](const ivec3& c){return (size_t)c.x+(size_t)head.dims.x*((size_t)c.y+(size_t)head.dims.y*(size_t)c.z);};
+            auto range = [&](const sdf::bbox_t& box, ivec3& lo, ivec3& hi){
+                lo=glm::clamp(ivec3(floor((box.min-head.min)/cell)),ivec3(0),head.dims-1);
+                hi=glm::clamp(ivec3(floor((box.max-head.min)/cell)),ivec3(0),head.dims-1);
+            };
+
+            //Cells in CSR form, first counting and then filling.
+            std::vector<cell_t> grid_cells(head.cells+1,{0,0.0f});
+            for(auto& box : boxes){
+                ivec3 lo,hi;
+                range(box,lo,hi);
+                for(int z=lo.z;z<=hi.z;z++)for(int y=lo.y;y<=hi.y;y++)for(int x=lo.x;x<=hi.x;x++)grid_cells[index({x,y,z})+1].begin++;
+            }
+            for(size_t i=0;i<head.cells;i++)grid_cells[i+1].begin+=grid_cells[i].begin;
+
+            std::vector<uint32_t> grid_items(grid_cells[head.cells].begin);
+            {
+                std::vector<uint32_t> cursor(head.cells);
+                for(size_t i=0;i<head.cells;i++)cursor[i]=grid_cells[i].begin;
+                for(uint32_t i=0;i<boxes.size();i++){
+                    ivec3 lo,hi;
+                    range(boxes[i],lo,hi);
+                    for(int z=lo.z;z<=hi.z;z++)for(int y=lo.y;y<=hi.y;y++)for(int x=lo.x;x<=hi.x;x++)grid_items[cursor[index({x,y,z})]++]=i;
+                }
+            }
+
+            //Empty cells can skip further, based on their Chebyshev distance from the closest occupied cell.
+            {
+                std::vector<int> steps(head.cells,-1);
+                std::vector<ivec3> frontier, next;
+                for(int z=0;z<head.dims.z;z++)for(int y=0;y<head.dims.y;y++)for(int x=0;x<head.dims.x;x++){
+                    auto i = index({x,y,z});
+                    if(grid_cells[i+1].begin!=grid_cells[i].begin){steps[i]=0;frontier.push_back({x,y,z});}
+                }
+                for(int k=1;!frontier.empty();k++){
+                    next.clear();
+                    for(auto& c : frontier){
+                        for(int dz=-1;dz<=1;dz++)for(int dy=-1;dy<=1;dy++)for(int dx=-1;dx<=1;dx++){
+                            ivec3 n = c+ivec3{dx,dy,dz};
+                            if(any(lessThan(n,ivec3(0))) || any(greaterThanEqual(n,head.dims)))continue;
+                            auto i = index(n);
+                            if(steps[i]!=-1)continue;
+                            steps[i]=k;
+                            next.push_back(n);
+                        }
+                    }
+                    std::swap(frontier,next);
+                }
+                for(size_t i=0;i<head.cells;i++){
+                    grid_cells[i].gap=steps[i]<=0?head.margin:glm::max(head.margin,(steps[i]-1)*cell);
+                }
+            }
+
+            head.instances_offset=align(sizeof(header_t));
+            head.cells_offset=align(head.instances_offset+sizeof(instance_t<extras_t>)*entries.size());
+            head.items_offset=align(head.cells_offset+sizeof(cell_t)*grid_cells.size());
+
+            data.assign(head.items_offset+sizeof(uint32_t)*grid_items.size(),0);
+            memcpy(data.data(),&head,sizeof(head));
+            auto dst = (instance_t<extras_t>*)(data.data()+head.instances_offset);
+            for(size_t i=0;i<entries.size();i++){
+                auto inv = inverse(entries[i].linear);
+                dst[i]={inv,-(inv*entries[i].offset),min_singular(entries[i].linear),entries[i].flags,entries[i].extras};
+            }
+            memcpy(data.data()+head.cells_offset,grid_cells.data(),sizeof(cell_t)*grid_cells.size());
+            memcpy(data.data()+head.items_offset,grid_items.data(),sizeof(uint32_t)*grid_items.size());
+            return true;
+        }
+
+        /**
+         * @brief Copy the last generated buffer in a shared slot, replacing its content.
+         */
+        bool make_shared(size_t idx) const{
+            if(data.empty())return false;
+            auto ret = global_shared.reserve(idx, data.size());
+            if(ret==false)return false;
+            memcpy(global_shared[idx].base,data.data(),data.size());
+            return global_shared.sync(idx);
+        }
+
+        /**
+         * @brief Rebuild and publish the instances after their transforms changed.
+         * Only the slot is synced, trees referencing it are left untouched.
+         * The host buffer of the slot is reused when its size is unchanged.
+         */
+        bool update(size_t idx){
+            if(!build())return false;
+            auto slot = global_shared[idx];
+            if(slot.base==nullptr || slot.size!=data.size())return make_shared(idx);
+            memcpy(slot.base,data.data(),data.size());
+            return global_shared.sync(idx);
+        }
+};
+
+}
+
+}
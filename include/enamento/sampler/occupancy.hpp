@@ -0,0 +1,197 @@
+#pragma once
+
+/**
+ * @file occupancy.hpp
+ * @author karurochari
+ * @brief Pyramid of occupancy grids baked from an SDF, to skip empty space while ray marching.
+ * @date 2025-04-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Each cell stores a lower bound of the SDF inside it, from its interval bounds. Cells of the coarser levels store the minimum of their children.
+ * A cell is empty when its bound is above `margin`, and a ray crossing it can jump straight to its exit.
+ * Rays walk the grid from the coarsest level which is empty at their position, so large free regions are crossed in a handful of steps,
+ * no matter how close they graze a surface.
+ *
+ * The buffer is self-contained, so it can be moved into a shared slot and read on any device.
+ * Points outside the grid are never considered empty, and marching there works as usual.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "sdf/commons.hpp"
+
+namespace sampler{
+
+namespace occupancy{
+
+using namespace glm;
+
+constexpr static inline uint32_t MAX_LEVELS = 12;
+constexpr static inline uint32_t MAX_SKIPS = 64;    //Jumps at most in a single call to `skip`
+
+struct header_t{
+    uint32_t    levels;             //Level 0 is the finest
+    float       cell_size;          //Side of the cells at level 0
+    vec3        min;                //Lower corner of the grid
+    float       margin;             //Cells are empty if the SDF is above this value everywhere in them
+    uvec3       dims[MAX_LEVELS];
+    uint32_t    offsets[MAX_LEVELS];//Start of each level, in cells from the start of the values
+    uint32_t    values_offset;      //Bytes from the start of the buffer
+};
+
+inline const float* values(const header_t* head){return (const float*)((const uint8_t*)head+head->values_offset);}
+
+/**
+ * @brief Advance a ray through the cells which are surely empty.
+ *
+ * @param head the grid
+ * @param ro origin of the ray
+ * @param rd direction of the ray, normalized
+ * @param t distance along the ray of the current point
+ * @param tmax distance at which to stop
+ * @return float the distance of the first point which is not in an empty cell, or beyond `tmax`.
+ */
+inline float skip(const header_t* head, const vec3& ro, const vec3& rd, float t, float tmax){
+    const float* cells = values(head);
+    for(uint32_t i=0;i<MAX_SKIPS && t<tmax;i++){
+        //Position in units of the finest cells.
+        vec3 p = (ro+t*rd-head->min)/head->cell_size;
+        if(any(lessThan(p,vec3(0))) || any(greaterThanEqual(p,vec3(head->dims[0]))))return t;
+
+        //Rays are mostly close to surfaces when this is called, so the search starts from the finest level and climbs while cells are empty.
+        uvec3 c = uvec3(p);
+        auto empty = [&](uint32_t level){
+            uvec3 cl = c>>level;
+            auto& dims = head->dims[level];
+            return cells[head->offsets[level]+cl.x+dims.x*(cl.y+dims.y*cl.z)]>head->margin;
+        };
+        if(!empty(0))return t;
+        uint32_t level = 0;
+        while(level+1<head->levels && empty(level+1))level++;
+
+        //Exit from the empty cell, along the axis reached first.
+        //The last coarse cells on each axis can extend past the grid, but only the part inside it was baked.
+        float side = (float)(1u<<level);
+        vec3 lo = vec3(c>>level)*side;
+        vec3 hi = glm::min(lo+side,vec3(head->dims[0]));
+        float exit = INFINITY;
+        for(int k=0;k<3;k++){
+            if(rd[k]>0.0f)exit=glm::min(exit,(hi[k]-p[k])/rd[k]);
+            else if(rd[k]<0.0f)exit=glm::min(exit,(lo[k]-p[k])/rd[k]);
+        }
+        //Nudged into the next cell. The SDF is above `margin` up to the boundary, so nothing can be hit within half of it.
+        t+=glm::max(exit,0.0f)*head->cell_size+head->margin*0.5f;
+    }
+    return t;
+}
+
+struct builder{
+    private:
+        std::vector<uint8_t>    data;
+        sdf::bbox_t             box;
+        float                   cell_size;
+        uint32_t                max_dims;
+
+        constexpr static inline size_t align(size_t v){return (v+15)/16*16;}
+
+    public:
+
+        /**
+         * @brief Construct a new builder
+         *
+         * @param box region covered by the grid. It must be finite.
+         * @param cell_size side of the finest cells.
+         * @param max_dims upper limit to the number of cells along each axis, the cells are enlarged to respect it.
+         */
+        builder(const sdf::bbox_t& box, float cell_size, uint32_t max_dims = 256):box(box),cell_size(cell_size),max_dims(max_dims){
+            if(any(isinf(box.min)) || any(isinf(box.max))){
+                throw "Occupancy grids require a finite region";
+            }
+            if(cell_size<=0.0f){
+                throw "Occupancy grids require a positive cell size";
+            }
+        }
+
+        inline const header_t* stats() const{return data.empty()?nullptr:(const header_t*)data.data();}
+
+        /**
+         * @brief Bake the grid from an SDF.
+         *
+         * @param sdf
+         * @param margin how far from any surface a cell must be to be empty, if zero a thousandth of a cell.
+         */
+        template <sdf::sdf_i SDF>
+        bool build(const SDF& sdf, float margin = 0.0f){
+            header_t head = {};
+            auto extent = box.max-box.min;
+            float cell = glm::max(cell_size,glm::max(extent.x,glm::max(extent.y,extent.z))/max_dims);
+            head.cell_size=cell;
+            head.min=box.min;
+            head.margin=margin>0.0f?margin:glm::max(cell*1e-3f,sdf::EPS*2.0f);
+            head.dims[0]=glm::clamp(uvec3(ceil(extent/cell)),uvec3(1),uvec3(max_dims));
+
+            uint32_t total = 0;
+            for(head.levels=0;head.levels<MAX_LEVELS;){
+                auto& dims = head.dims[head.levels];
+                head.offsets[head.levels]=total;
+                total+=dims.x*dims.y*dims.z;
+                head.levels++;
+                if(dims==uvec3(1) || head.levels==MAX_LEVELS)break;
+                head.dims[head.levels]=(dims+1u)/2u;
+            }
+
+            std::vector<float> cells(total);
+
+            //Finest level from the bounds of the SDF over each cell.
+            {
+                auto dims = head.dims[0];
+                #pragma omp parallel for collapse(2) schedule(dynamic,1)
+                for(uint32_t z=0;z<dims.z;z++)for(uint32_t y=0;y<dims.y;y++){
+                    for(uint32_t x=0;x<dims.x;x++){
+                        vec3 lo = head.min+vec3(x,y,z)*cell;
+                        cells[x+dims.x*(y+dims.y*z)]=sdf.bounds({lo,lo+cell}).min;
+                    }
+                }
+            }
+
+            //Coarser levels as the minimum of their children.
+            for(uint32_t l=1;l<head.levels;l++){
+                auto dims = head.dims[l], fine = head.dims[l-1];
+                const float* src = cells.data()+head.offsets[l-1];
+                float* dst = cells.data()+head.offsets[l];
+                for(uint32_t z=0;z<dims.z;z++)for(uint32_t y=0;y<dims.y;y++)for(uint32_t x=0;x<dims.x;x++){
+                    float v = INFINITY;
+                    for(uint32_t k=0;k<8;k++){
+                        uvec3 c = uvec3{x,y,z}*2u+uvec3{k&1,(k>>1)&1,(k>>2)&1};
+                        if(any(greaterThanEqual(c,fine)))continue;
+                        v=glm::min(v,src[c.x+fine.x*(c.y+fine.y*c.z)]);
+                    }
+                    dst[x+dims.x*(y+dims.y*z)]=v;
+                }
+            }
+
+            head.values_offset=align(sizeof(header_t));
+            data.assign(head.values_offset+sizeof(float)*cells.size(),0);
+            memcpy(data.data(),&head,sizeof(head));
+            memcpy(data.data()+head.values_offset,cells.data(),sizeof(float)*cells.size());
+            return true;
+        }
+
+        /**
+         * @brief Copy the last generated buffer in a shared slot, replacing its content.
+         */
+        bool make_shared(size_t idx) const{
+            if(data.empty())return false;
+            auto ret = global_shared.reserve(idx, data.size());
+            if(ret==false)return false;
+            memcpy(global_shared[idx].base,data.data(),data.size());
+            return global_shared.sync(idx);
+        }
+};
+
+}
+
+}
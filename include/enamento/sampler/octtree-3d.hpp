@@ -4,6 +4,8 @@
 #include <numbers>
 #include <vector>
 #include "sdf/commons.hpp"
+#include "utils/jobs.hpp"
+#include "utils/trace.hpp"
 
 namespace sampler{
 
@@ -41,6 +43,11 @@ struct builder{
         
         std::vector<node<typename SDF::attrs_t>> data;
 
+        jobs::status_t* status = nullptr;
+
+        //Progress is counted in cells of this level, or their share for leaves above it.
+        constexpr static uint PROGRESS_DEPTH = 2;
+
     public:
 
         /**
@@ -52,9 +59,24 @@ struct builder{
             data.clear();
         }
 
-        inline bool build(){
+        /**
+         * @brief Sample the SDF and build the tree.
+         *
+         * @param status if set, progress is reported there and cancellation is checked for each cell
+         * @return true on success
+         * @return false if cancelled, in which case the tree is left empty
+         */
+        inline bool build(jobs::status_t* status = nullptr){
+            trace::scope _trace("bake","sampler");
             reset();
+            this->status = status;
+            if(status!=nullptr)status->expect(1u<<(3*PROGRESS_DEPTH));
             auto ret =  generate(box_size);
+            this->status = nullptr;
+            if(status!=nullptr && status->cancelled()){
+                reset();
+                return false;
+            }
             data[0]=data.back();
             return true;
         }
@@ -91,9 +113,11 @@ struct builder{
         uint32_t generate( float box_size, vec3 boxcenter={0,0,0}, uint depth =0){
             //TODO: the main issue is that we should take the leaf elements and from there casting rays in all direction to look for a surface.
             //Then, and only then, we have a sampled value for normals and attributes. Otherwise for coarser approximations the calculated attributes makes no sense.
+            if(status!=nullptr && status->cancelled())return 0;
             typename SDF::attrs_t computed =  sdf(boxcenter+offset);
             size_t t = 0;
             if(abs(computed.distance)>box_size*std::numbers::sqrt3 || depth>max_steps){
+                if(status!=nullptr && depth<=PROGRESS_DEPTH)status->advance(1u<<(3*(PROGRESS_DEPTH-depth)));
                 sampler::octatree3D::node<typename SDF::attrs_t>* node;
                     {
                     //std::lock_guard<std::mutex>grd(mtx);
@@ -120,6 +144,7 @@ struct builder{
                         }
                     }
                 }
+                if(status!=nullptr && depth==PROGRESS_DEPTH)status->advance();
 
                 sampler::octatree3D::node<typename SDF::attrs_t>* node;
                 {
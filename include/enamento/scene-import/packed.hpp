@@ -0,0 +1,404 @@
+#pragma once
+
+/**
+ * @file packed.hpp
+ * @author karurochari
+ * @brief Memory-mappable binary format for scenes, to skip parsing and graph construction at startup.
+ * @date 2025-04-12
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * The file is a fixed header followed by a number of sections, each aligned to `ALIGNMENT` bytes.
+ * - `tree` is the verbatim content of a `sdf::tree::builder`. Offsets in there are relative, so it can be used in place.
+ * - `nodes` has one `node_t` entry for each node of the tree, in pre-order.
+ * - `fields` has the descriptors of the fields for each node (see `sdf::field_t`), so that tools can inspect and edit them.
+ * - `names` maps labels to the offset of the respective node in `tree`.
+ * - `materials` is an opaque array of records, its stride is stored to validate it against the type used by the consumer.
+ * - `strings` is a pool of null terminated strings. Any string in other sections is an offset in here.
+ *
+ * All values are stored in the native endianness and layout, since the tree itself is.
+ * The file is not meant to be portable across architectures or across different `Attrs`.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sdf/sdf.hpp"
+
+namespace sdf{
+namespace packed{
+
+constexpr char     MAGIC[8] = {'E','N','P','A','C','K','\0','\0'};
+constexpr uint32_t VERSION = 2;
+constexpr size_t   ALIGNMENT = 64;
+constexpr uint32_t NO_STRING = 0xffffffff;
+
+struct section_t{
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    uint32_t items = 0;
+    uint32_t stride = 0;
+};
+
+struct header_t{
+    char     magic[8];
+    uint32_t version;
+    uint32_t extras_size;   //sizeof(Attrs::extras_t), a cheap check that the tree is compatible with the consumer.
+    uint64_t file_size;
+
+    section_t tree;
+    section_t nodes;
+    section_t fields;
+    section_t names;
+    section_t materials;
+    section_t strings;
+};
+
+struct node_t{
+    uint32_t offset;        //Position of the node data in the tree section
+    uint16_t opcode;
+    uint16_t children;
+    uint32_t type;          //String with the name of the node type
+    uint32_t label;         //String with the label, NO_STRING if anonymous
+    uint32_t fields_begin;
+    uint32_t fields_items;
+};
+
+struct field_t{
+    uint32_t name;
+    uint8_t  type;          //sdf::field_t::type_t
+    uint8_t  widget;        //sdf::field_t::widget_t
+    uint8_t  readonly;
+    uint8_t  _reserved;
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct name_t{
+    uint32_t label;
+    uint32_t offset;
+};
+
+static_assert(sizeof(header_t)%8==0);
+static_assert(sizeof(node_t)==24);
+static_assert(sizeof(field_t)==16);
+static_assert(sizeof(name_t)==8);
+
+/**
+ * @brief Collect all the information needed to generate a packed file out of a tree.
+ *
+ * @tparam Attrs the attributes used when building the tree.
+ */
+template<typename Attrs>
+struct writer{
+    private:
+        const tree::builder& src;
+
+        std::vector<node_t>         nodes;
+        std::vector<field_t>        fields;
+        std::vector<name_t>         names;
+        std::vector<uint8_t>        materials;
+        uint32_t                    materials_items = 0;
+        uint32_t                    materials_stride = 0;
+
+        std::vector<char>                   strings;
+        std::map<std::string,uint32_t,std::less<>> strings_idx;
+
+        uint32_t intern(std::string_view str){
+            auto it = strings_idx.find(str);
+            if(it!=strings_idx.end())return it->second;
+            uint32_t ret = strings.size();
+            strings.insert(strings.end(),str.begin(),str.end());
+            strings.push_back(0);
+            strings_idx.emplace(std::string(str),ret);
+            return ret;
+        }
+
+        static size_t align(size_t v){return (v+ALIGNMENT-1)/ALIGNMENT*ALIGNMENT;}
+
+    public:
+        writer(const tree::builder& src):src(src){
+            auto base = src.bytes.data();
+            auto root = (const utils::tree_idx<Attrs>*)(base+src.root());
+            root->ctree_visit_pre([&](const char* name, fields_t node_fields, const void* addr, size_t children){
+                node_t node;
+                node.offset = (const uint8_t*)addr-base;
+                node.opcode = *(const uint16_t*)((const uint8_t*)addr-2);
+                node.children = children;
+                node.type = intern(name);
+                node.label = NO_STRING;
+                node.fields_begin = fields.size();
+                node.fields_items = node_fields.items;
+                for(auto& field : node_fields){
+                    fields.push_back({
+                        intern(field.name),(uint8_t)field.type,(uint8_t)field.widget,(uint8_t)field.readonly,0,
+                        (uint32_t)field.offset,(uint32_t)field.length
+                    });
+                }
+                nodes.push_back(node);
+                return true;
+            });
+        }
+
+        /**
+         * @brief Record a named reference.
+         *
+         * @param label
+         * @param origin the address of the node which was serialized into the builder (`addr()`).
+         * @return true if the node is part of the tree
+         * @return false else
+         */
+        bool name(std::string_view label, const void* origin){
+            auto offset = src.offset_of(origin);
+            if(offset==0)return false;
+            return name(label,(uint32_t)offset);
+        }
+
+        bool name(std::string_view label, uint32_t offset){
+            auto str = intern(label);
+            names.push_back({str,offset});
+            for(auto& node: nodes){
+                if(node.offset==offset){if(node.label==NO_STRING)node.label=str;return true;}
+            }
+            return false;
+        }
+
+        template<typename T>
+        void material(std::span<const T> items){
+            materials.resize(items.size_bytes());
+            memcpy(materials.data(),items.data(),items.size_bytes());
+            materials_items = items.size();
+            materials_stride = sizeof(T);
+        }
+
+        /**
+         * @brief Write the packed file.
+         *
+         * @param path
+         * @return true on success
+         * @return false else
+         */
+        bool save(const char* path) const{
+            header_t header;
+            memcpy(header.magic,MAGIC,sizeof(MAGIC));
+            header.version = VERSION;
+            header.extras_size = sizeof(typename Attrs::extras_t);
+
+            size_t cursor = align(sizeof(header_t));
+            auto layout = [&](section_t& section, size_t size, uint32_t items, uint32_t stride){
+                section.offset = cursor;
+                section.size = size;
+                section.items = items;
+                section.stride = stride;
+                cursor = align(cursor+size);
+            };
+            layout(header.tree, src.bytes.size(), nodes.size(), 0);
+            layout(header.nodes, nodes.size()*sizeof(node_t), nodes.size(), sizeof(node_t));
+            layout(header.fields, fields.size()*sizeof(field_t), fields.size(), sizeof(field_t));
+            layout(header.names, names.size()*sizeof(name_t), names.size(), sizeof(name_t));
+            layout(header.materials, materials.size(), materials_items, materials_stride);
+            layout(header.strings, strings.size(), strings_idx.size(), 0);
+            header.file_size = cursor;
+
+            FILE* fd = fopen(path,"wb");
+            if(fd==nullptr)return false;
+
+            bool ok = true;
+            auto put = [&](const section_t& section, const void* data){
+                if(section.size==0)return;
+                ok &= fseek(fd,section.offset,SEEK_SET)==0;
+                ok &= fwrite(data,1,section.size,fd)==section.size;
+            };
+            ok &= fwrite(&header,1,sizeof(header_t),fd)==sizeof(header_t);
+            put(header.tree,src.bytes.data());
+            put(header.nodes,nodes.data());
+            put(header.fields,fields.data());
+            put(header.names,names.data());
+            put(header.materials,materials.data());
+            put(header.strings,strings.data());
+            //Pad the tail, so that the file size matches the header.
+            ok &= fseek(fd,header.file_size-1,SEEK_SET)==0;
+            ok &= fputc(0,fd)!=EOF;
+
+            ok &= fclose(fd)==0;
+            return ok;
+        }
+};
+
+/**
+ * @brief A packed file mapped in memory. No parsing is involved, only validation of the header and tables.
+ * The mapping is private and writable, so changes to the tree (like from the UI) are not written back to disk.
+ */
+struct mapped{
+    private:
+        uint8_t* data = nullptr;
+        size_t   size = 0;
+        int      slot = -1;
+
+        template<typename T>
+        const T* at(const section_t& section) const{return (const T*)(data+section.offset);}
+
+        static bool fits(const section_t& section, size_t size){
+            return section.offset%8==0 && section.offset<=size && section.size<=size-section.offset;
+        }
+
+        bool validate() const{
+            if(size<sizeof(header_t))return false;
+            auto& h = header();
+            if(memcmp(h.magic,MAGIC,sizeof(MAGIC))!=0)return false;
+            if(h.version!=VERSION)return false;
+            if(h.file_size!=size)return false;
+            for(auto* section : {&h.tree,&h.nodes,&h.fields,&h.names,&h.materials,&h.strings}){
+                if(!fits(*section,size))return false;
+            }
+            if(h.tree.size<8)return false;
+            if(h.nodes.size!=(size_t)h.nodes.items*sizeof(node_t))return false;
+            if(h.fields.size!=(size_t)h.fields.items*sizeof(field_t))return false;
+            if(h.names.size!=(size_t)h.names.items*sizeof(name_t))return false;
+            if(h.materials.size!=(size_t)h.materials.items*h.materials.stride)return false;
+            if(h.strings.size!=0 && data[h.strings.offset+h.strings.size-1]!=0)return false;
+
+            uint32_t root;
+            memcpy(&root,data+h.tree.offset,4);
+            if(root<8 || root>=h.tree.size)return false;
+
+            auto str_ok = [&](uint32_t s){return s==NO_STRING || s<h.strings.size;};
+            for(auto& node: nodes()){
+                if(node.offset<8 || node.offset>=h.tree.size)return false;
+                if(!str_ok(node.type) || !str_ok(node.label))return false;
+                if((size_t)node.fields_begin+node.fields_items>h.fields.items)return false;
+            }
+            for(auto& field: fields()){if(!str_ok(field.name))return false;}
+            for(auto& name: names()){
+                if(!str_ok(name.label))return false;
+                if(name.offset<8 || name.offset>=h.tree.size)return false;
+            }
+            return true;
+        }
+
+    public:
+        mapped() = default;
+
+        explicit mapped(const char* path){
+            int fd = open(path,O_RDONLY);
+            if(fd<0)return;
+            struct stat st;
+            if(fstat(fd,&st)==0 && st.st_size>0){
+                void* ptr = mmap(nullptr,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+                if(ptr!=MAP_FAILED){data=(uint8_t*)ptr;size=st.st_size;}
+            }
+            close(fd);
+            if(data!=nullptr && !validate()){
+                printf("WARNING: %s is not a valid packed scene\n",path);
+                munmap(data,size);
+                data=nullptr;size=0;
+            }
+        }
+
+        mapped(const mapped&) = delete;
+        mapped& operator=(const mapped&) = delete;
+
+        mapped(mapped&& src):data(src.data),size(src.size),slot(src.slot){
+            src.data=nullptr;src.size=0;src.slot=-1;
+        }
+
+        mapped& operator=(mapped&& src){
+            if(this==&src)return *this;
+            unbind();
+            if(data!=nullptr)munmap(data,size);
+            data=src.data;size=src.size;slot=src.slot;
+            src.data=nullptr;src.size=0;src.slot=-1;
+            return *this;
+        }
+
+        ~mapped(){
+            unbind();
+            if(data!=nullptr)munmap(data,size);
+        }
+
+        inline bool valid() const{return data!=nullptr;}
+        inline const header_t& header() const{return *(const header_t*)data;}
+
+        inline uint8_t* tree(){return data+header().tree.offset;}
+        inline const uint8_t* tree() const{return data+header().tree.offset;}
+        inline size_t tree_size() const{return header().tree.size;}
+
+        inline std::span<const node_t> nodes() const{return {at<node_t>(header().nodes),header().nodes.items};}
+        inline std::span<const field_t> fields() const{return {at<field_t>(header().fields),header().fields.items};}
+        inline std::span<const name_t> names() const{return {at<name_t>(header().names),header().names.items};}
+        inline std::span<const field_t> fields(const node_t& node) const{return fields().subspan(node.fields_begin,node.fields_items);}
+
+        inline const char* str(uint32_t idx) const{
+            if(idx==NO_STRING)return nullptr;
+            return (const char*)data+header().strings.offset+idx;
+        }
+
+        /**
+         * @brief Offset of a named node in the tree.
+         *
+         * @param label
+         * @return uint32_t the offset, 0 if not found.
+         */
+        uint32_t find(std::string_view label) const{
+            for(auto& name: names()){
+                if(label==str(name.label))return name.offset;
+            }
+            return 0;
+        }
+
+        /**
+         * @brief Get the material table, if its records are compatible with T.
+         */
+        template<typename T>
+        std::span<const T> materials() const{
+            auto& section = header().materials;
+            if(section.stride!=sizeof(T) || section.offset%alignof(T)!=0)return {};
+            return {at<T>(section),section.items};
+        }
+
+        /**
+         * @brief Check if the tree was built against attributes compatible with the ones of the consumer.
+         */
+        template<typename Attrs>
+        inline bool compatible() const{return valid() && header().extras_size==sizeof(typename Attrs::extras_t);}
+
+        /**
+         * @brief Expose the tree in a slot of `global_shared`, with no copy on the host side.
+         *
+         * @param idx the slot
+         * @return true on success
+         * @return false else
+         */
+        bool bind(size_t idx){
+            if(!valid())return false;
+            unbind();
+            //The slot could hold memory owned by the table, `assign` takes care of releasing it.
+            if(!global_shared.assign(idx,{tree(),tree_size()}))return false;
+            slot=idx;
+            return true;
+        }
+
+        /**
+         * @brief Remove the tree from the slot it was bound to. The slot must not be reassigned before this, as the table would try to free the mapping.
+         */
+        void unbind(){
+            if(slot<0)return;
+            global_shared.detach(slot);
+            slot=-1;
+        }
+};
+
+}
+}
@@ -76,6 +76,38 @@ struct bbox_t{
     glm::vec3 max = {INFINITY,INFINITY,INFINITY};
 };
 
+/**
+* @brief Range of the values an SDF can take over a region, as returned by `bounds`.
+* It is conservative: every sample taken in the region is within [min,max], but the range can be wider than the real one.
+*/
+struct interval_t{
+    float min = -INFINITY;
+    float max = INFINITY;
+};
+
+/**
+* @brief Bounding box of a box transformed as `linear*pos+offset`.
+*/
+inline bbox_t transform(const bbox_t& box, const glm::mat3& linear, const glm::vec3& offset){
+    if(glm::any(glm::isinf(box.min)) || glm::any(glm::isinf(box.max)))return {};
+    glm::vec3 centre = (box.min+box.max)/2.0f, half = (box.max-box.min)/2.0f;
+    glm::mat3 extent;
+    for(int i=0;i<3;i++)extent[i]=glm::abs(linear[i]);
+    centre = linear*centre+offset;
+    half = extent*half;
+    return {centre-half,centre+half};
+}
+
+/**
+* @brief Bounds over a box for any SDF which is 1-Lipschitz, from a single sample at its centre.
+* Used by nodes which have no better way to bound themselves.
+*/
+inline interval_t lipschitz(float centre, const bbox_t& box){
+    if(glm::any(glm::isinf(box.min)) || glm::any(glm::isinf(box.max)))return {};
+    float radius = glm::length(box.max-box.min)/2.0f;
+    return {centre-radius,centre+radius};
+}
+
 struct traits_t{
     //TODO: replace with tribool array
     glm::ivec3  is_sym;                             //It has symmetries along the main axis
@@ -176,14 +208,15 @@ concept attrs_i = requires(const T& self, const T& self2, xml& oxml, const xml&
 template<typename T>
 concept sdf_i  = attrs_i<typename T::attrs_t> && requires(
     const T self, T mutself,
-    glm::vec2 pos2d, glm::vec3 pos3d, 
-    traits_t traits, xml& oxml, 
+    glm::vec2 pos2d, glm::vec3 pos3d, bbox_t box,
+    traits_t traits, xml& oxml,
     const path_t* paths, tree::builder& otree,
     const visitor_t& visitor, const cvisitor_t& cvisitor
 ){
     {self.operator()(pos3d)} -> std::same_as<typename T::attrs_t>;
     {self.sample(pos3d)} -> std::convertible_to<float>;
-    
+    {self.bounds(box)} -> std::same_as<interval_t>;
+
     {self.name()} -> std::same_as<const char*>;
     {self.fields()}-> std::same_as<fields_t>;
     {self.fields(paths)} -> std::same_as<fields_t> ;
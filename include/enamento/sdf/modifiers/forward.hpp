@@ -36,6 +36,7 @@ namespace sdf{
             constexpr Forward(const Src<Attrs,Args...>& ref):src(ref){}
 
             constexpr inline float sample(const glm::vec3& pos)const {return src.sample(pos);}
+            constexpr inline interval_t bounds(const bbox_t& box)const {return src.bounds(box);}
             constexpr inline Attrs operator()(const glm::vec3& pos)const {return src.operator()(pos);}
 
             constexpr inline void traits(traits_t& t) const{return src.traits(t); };
@@ -88,6 +89,7 @@ namespace sdf{
 
             constexpr inline Attrs operator()(const glm::vec3& pos)const final{return src->operator()(pos);}
             constexpr inline float sample(const glm::vec3& pos)const final{return src->sample(pos);}
+            constexpr inline interval_t bounds(const bbox_t& box)const final{return src->bounds(box);}
 
             constexpr inline void traits(traits_t& t) const final{return src->traits(t); };
 
@@ -33,6 +33,8 @@ namespace sdf{
             using base::base;
 
             constexpr inline float sample(const glm::vec3& pos) const{return base::left().sample(pos);}
+            constexpr inline bbox_t region(const bbox_t& box) const{return box;}
+            constexpr inline interval_t bounds(const bbox_t& box) const{return base::left().bounds(box);}
 
             constexpr inline base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
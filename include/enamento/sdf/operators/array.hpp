@@ -0,0 +1,155 @@
+#pragma once
+
+/**
+ * @file array.hpp
+ * @author karurochari
+ * @brief Linear array (grid) of copies of the same subtree, via domain repetition.
+ * @date 2025-04-16
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ * Copies are placed at `i*spacing` for `i` in `[0,count)` along each axis.
+ * The position is folded into the closest cell, and only the neighbours on the side of the sample are checked,
+ * so the cost is at most 8 evaluations of the child regardless of the number of copies.
+ * The result is exact as long as each copy does not overflow into cells further than its direct neighbours.
+ */
+
+#ifndef SDF_INTERNALS
+#error "Don't import manually, this can only be used internally by the library"
+#endif
+
+#include "../sdf.hpp"
+
+namespace sdf{
+
+    namespace configs{
+        struct Array{
+            glm::vec3 spacing;
+            glm::ivec3 count = {1,1,1};     //Copies along each axis, axes with less than 2 copies are not repeated.
+        };
+    }
+
+    namespace{namespace impl_base{
+
+        template <typename L>
+        struct Array : utils::unary_op<L, configs::Array>{
+            using base = utils::unary_op<L, configs::Array>;
+            using base::base;
+
+            struct fold_t{
+                vec3 id;        //Closest cell
+                vec3 side;      //Direction of the neighbour to check, zero on axes not repeated
+                vec3 last;      //Last cell on each axis
+            };
+
+            constexpr inline fold_t fold(const glm::vec3& pos) const{
+                fold_t ret;
+                auto& cfg = this->cfg;
+                for(int i=0;i<3;i++){
+                    if(cfg.count[i]<2 || cfg.spacing[i]==0.0f){ret.id[i]=0;ret.side[i]=0;ret.last[i]=0;continue;}
+                    ret.last[i]=cfg.count[i]-1;
+                    ret.id[i]=glm::clamp(glm::round(pos[i]/cfg.spacing[i]),0.0f,ret.last[i]);
+                    ret.side[i]=(pos[i]-cfg.spacing[i]*ret.id[i])*cfg.spacing[i]<0.0f?-1.0f:1.0f;
+                }
+                return ret;
+            }
+
+            //Visit the closest cell and its neighbours towards `pos`, skipping the ones outside the array.
+            template<typename F>
+            constexpr inline void cells(const glm::vec3& pos, F&& fn) const{
+                auto f = fold(pos);
+                for(int k=0;k<8;k++){
+                    vec3 step = {(k&1)?f.side.x:0.0f,(k&2)?f.side.y:0.0f,(k&4)?f.side.z:0.0f};
+                    if(((k&1) && step.x==0.0f) || ((k&2) && step.y==0.0f) || ((k&4) && step.z==0.0f))continue;
+                    vec3 cell = f.id+step;
+                    if(any(lessThan(cell,vec3(0.0f))) || any(greaterThan(cell,f.last)))continue;
+                    fn(pos-this->cfg.spacing*cell);
+                }
+            }
+
+            constexpr float sample(const glm::vec3& pos) const{
+                auto& left = base::left();
+                float ret = INFINITY;
+                cells(pos,[&](const glm::vec3& local){ret=min(ret,left.sample(local));});
+                return ret;
+            }
+
+            //Samples in the box come from the closest cell of one of its points, which are in [lo,hi], or from one of their neighbours.
+            constexpr interval_t bounds(const bbox_t& box) const{
+                auto& left = base::left();
+                auto& cfg = this->cfg;
+                vec3 lo, hi, from, to;
+                for(int i=0;i<3;i++){
+                    if(cfg.count[i]<2 || cfg.spacing[i]==0.0f){lo[i]=hi[i]=from[i]=to[i]=0.0f;continue;}
+                    float last = cfg.count[i]-1;
+                    float a = glm::round(box.min[i]/cfg.spacing[i]), b = glm::round(box.max[i]/cfg.spacing[i]);
+                    lo[i]=glm::clamp(min(a,b),0.0f,last);
+                    hi[i]=glm::clamp(max(a,b),0.0f,last);
+                    from[i]=max(lo[i]-1.0f,0.0f);
+                    to[i]=min(hi[i]+1.0f,last);
+                }
+
+                //The box moved into the space of the child, for all cells in [a,b].
+                auto shifted = [&](const vec3& a, const vec3& b)->bbox_t{
+                    auto p = cfg.spacing*a, q = cfg.spacing*b;
+                    return {box.min-max(p,q),box.max-min(p,q)};
+                };
+
+                auto cells = to-from+1.0f;
+                if(cells.x*cells.y*cells.z>27.0f){
+                    //Too many copies to visit, the child is bounded once over all of them.
+                    return {left.bounds(shifted(from,to)).min,left.bounds(shifted(lo,hi)).max};
+                }
+
+                interval_t ret = {INFINITY,-INFINITY};
+                for(float x=from.x;x<=to.x;x++)
+                for(float y=from.y;y<=to.y;y++)
+                for(float z=from.z;z<=to.z;z++){
+                    vec3 cell = {x,y,z};
+                    auto local = left.bounds(shifted(cell,cell));
+                    ret.min=min(ret.min,local.min);
+                    if(all(greaterThanEqual(cell,lo)) && all(lessThanEqual(cell,hi)))ret.max=max(ret.max,local.max);
+                }
+                return ret;
+            }
+
+            constexpr base::attrs_t operator()(const glm::vec3& pos) const{
+                auto& left = base::left();
+                typename base::attrs_t ret = {};
+                ret.distance = INFINITY;
+                cells(pos,[&](const glm::vec3& local){
+                    auto lres = left(local);
+                    if(lres.distance<ret.distance)ret=lres;
+                });
+                return {ret.distance,normals(pos),ret.fields};
+            }
+
+            constexpr inline void traits(const traits_t& from, const traits_t&, traits_t& to) const{
+                to.is_sym={tribool::unknown,tribool::unknown,tribool::unknown};
+                to.is_exact_inner=from.is_exact_inner;
+                to.is_exact_outer=from.is_exact_outer;
+                to.is_bounded_inner=from.is_bounded_inner;
+                to.is_bounded_outer=from.is_bounded_outer;
+                auto span = this->cfg.spacing*vec3(glm::max(this->cfg.count-1,ivec3(0)));
+                to.outer_box={min(from.outer_box.min,from.outer_box.min+span),max(from.outer_box.max,from.outer_box.max+span)};
+            }
+
+            constexpr inline void traits(traits_t& to) const{
+                traits_t ltraits;
+                (base::left()).traits(ltraits);
+                traits(ltraits,ltraits,to);
+            }
+
+            constexpr inline static const char* _name = "Array";
+
+            constexpr inline static field_t _fields[] = {
+                FIELD_OP_R(Array,vec3,deftype,spacing, "Distance between copies"),
+                FIELD_OP_R(Array,ivec3,deftype,count, "Copies along each axis"),
+            };
+
+            PRIMITIVE_NORMAL
+        };
+    }}
+
+    sdf_register_operator_1(Array);
+}
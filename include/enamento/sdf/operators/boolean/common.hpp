@@ -38,6 +38,21 @@ namespace sdf{
                 return max(lres,rres);
             }
 
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return bounds(base::left().bounds(box),base::right().bounds(box));
+            }
+
+            constexpr interval_t bounds(const interval_t& lres, const interval_t& rres) const{
+                return {max(lres.min,rres.min),max(lres.max,rres.max)};
+            }
+
+            //A branch which is never above the other one can be dropped.
+            constexpr path_t prune(const interval_t& lres, const interval_t& rres) const{
+                if(lres.min>=rres.max)return LEFT;
+                if(rres.min>=lres.max)return RIGHT;
+                return END;
+            }
+
             constexpr base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
                 auto& right = base::right();
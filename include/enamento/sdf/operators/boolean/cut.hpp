@@ -3,7 +3,7 @@
 /**
  * @file cut.hpp
  * @author karurochari
- * @brief Cut (A-B). Boolean operation with harsh edges to remove B from A.
+ * @brief Cut (B-A). Boolean operation with harsh edges to remove A from B.
  * @date 2025-03-08
  * 
  * @copyright Copyright (c) 2025
@@ -38,6 +38,20 @@ namespace sdf{
                 return max(-lres,rres);
             }
 
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return bounds(base::left().bounds(box),base::right().bounds(box));
+            }
+
+            constexpr interval_t bounds(const interval_t& lres, const interval_t& rres) const{
+                return {max(-lres.max,rres.min),max(-lres.min,rres.max)};
+            }
+
+            //Only the case in which the cutting shape is not reached can be pruned, as the other branch would need a negation.
+            constexpr path_t prune(const interval_t& lres, const interval_t& rres) const{
+                if(rres.min>=-lres.min)return RIGHT;
+                return END;
+            }
+
             constexpr base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
                 auto& right = base::right();
@@ -57,7 +71,7 @@ namespace sdf{
                 to.is_exact_outer=tribool::unknown;
                 to.is_bounded_inner=(fromA.is_bounded_inner==true && fromB.is_bounded_inner==true)?true:tribool::unknown;
                 to.is_bounded_outer=(fromA.is_bounded_outer==true && fromB.is_bounded_outer==true)?true:tribool::unknown;
-                to.outer_box=fromA.outer_box;
+                to.outer_box=fromB.outer_box;     //The right operand is the one being cut
             }
 
             constexpr inline void traits(traits_t& to) const{
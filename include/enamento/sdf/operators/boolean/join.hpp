@@ -37,6 +37,21 @@ namespace sdf{
                 return min(lres,rres);
             }
 
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return bounds(base::left().bounds(box),base::right().bounds(box));
+            }
+
+            constexpr interval_t bounds(const interval_t& lres, const interval_t& rres) const{
+                return {min(lres.min,rres.min),min(lres.max,rres.max)};
+            }
+
+            //A branch which is never below the other one can be dropped.
+            constexpr path_t prune(const interval_t& lres, const interval_t& rres) const{
+                if(lres.min>=rres.max)return RIGHT;
+                if(rres.min>=lres.max)return LEFT;
+                return END;
+            }
+
             constexpr base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
                 auto& right = base::right();
@@ -38,6 +38,18 @@ namespace sdf{
                 return max(min(lres,rres),-max(lres,rres));
             }
 
+            //The two terms are bounded separately, which ignores that they share the same operands.
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return bounds(base::left().bounds(box),base::right().bounds(box));
+            }
+
+            constexpr interval_t bounds(const interval_t& lres, const interval_t& rres) const{
+                return {
+                    max(min(lres.min,rres.min),-max(lres.max,rres.max)),
+                    max(min(lres.max,rres.max),-max(lres.min,rres.min))
+                };
+            }
+
             constexpr base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
                 auto& right = base::right();
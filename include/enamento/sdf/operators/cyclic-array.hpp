@@ -0,0 +1,158 @@
+#pragma once
+
+/**
+ * @file cyclic-array.hpp
+ * @author karurochari
+ * @brief Copies of the same subtree evenly distributed around the Z axis (bolt circles and similar patterns).
+ * @date 2025-04-16
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ * The child is kept as it is for the first copy, the others are rotated by multiples of `2π/count`.
+ * The position is folded into the closest sector, and the neighbouring sector towards the sample is checked too,
+ * so the cost is two evaluations of the child regardless of the number of copies.
+ */
+
+#ifndef SDF_INTERNALS
+#error "Don't import manually, this can only be used internally by the library"
+#endif
+
+#include <numbers>
+#include "../sdf.hpp"
+
+namespace sdf{
+
+    namespace configs{
+        struct CyclicArray{
+            int count = 1;
+        };
+    }
+
+    namespace{namespace impl_base{
+
+        template <typename L>
+        struct CyclicArray : utils::unary_op<L, configs::CyclicArray>{
+            using base = utils::unary_op<L, configs::CyclicArray>;
+            using base::base;
+
+            constexpr static inline vec3 rotate_z(const glm::vec3& pos, float a){
+                float sa = sin(a); float ca = cos(a);
+                return {ca*pos.x-sa*pos.y,sa*pos.x+ca*pos.y,pos.z};
+            }
+
+            //Visit the closest sector and its neighbour towards `pos`, as positions in the space of the child.
+            template<typename F>
+            constexpr inline void sectors(const glm::vec3& pos, F&& fn) const{
+                if(this->cfg.count<2){fn(pos);return;}
+                float sector = 2.0f*std::numbers::pi_v<float>/this->cfg.count;
+                float angle = atan2(pos.y,pos.x);
+                float id = glm::round(angle/sector);
+                float side = angle-id*sector<0.0f?-1.0f:1.0f;
+                fn(rotate_z(pos,-id*sector));
+                fn(rotate_z(pos,-(id+side)*sector));
+            }
+
+            constexpr float sample(const glm::vec3& pos) const{
+                auto& left = base::left();
+                float ret = INFINITY;
+                sectors(pos,[&](const glm::vec3& local){ret=min(ret,left.sample(local));});
+                return ret;
+            }
+
+            //Box containing the sector of annulus between radii r0 and r1, and angles t0 and t1.
+            constexpr static inline bbox_t sector_box(float r0, float r1, float t0, float t1, float z0, float z1){
+                if(isinf(r1))return {{-INFINITY,-INFINITY,z0},{INFINITY,INFINITY,z1}};
+                vec2 lo = {INFINITY,INFINITY}, hi = {-INFINITY,-INFINITY};
+                auto add = [&](float r, float t){vec2 p = {r*cos(t),r*sin(t)};lo=min(lo,p);hi=max(hi,p);};
+                add(r0,t0);add(r0,t1);add(r1,t0);add(r1,t1);
+                //Extremes on the outer arc are where it crosses the axes.
+                constexpr float quarter = std::numbers::pi_v<float>/2.0f;
+                for(float t=ceil(t0/quarter)*quarter;t<=t1;t+=quarter)add(r1,t);
+                return {{lo.x,lo.y,z0},{hi.x,hi.y,z1}};
+            }
+
+            //Samples are taken in the closest sector, within half a sector from its centre, or in a neighbour, within one and a half.
+            constexpr interval_t bounds(const bbox_t& box) const{
+                auto& left = base::left();
+                if(this->cfg.count<2)return left.bounds(box);
+                constexpr float pi = std::numbers::pi_v<float>;
+                float sector = 2.0f*pi/this->cfg.count;
+
+                vec2 lo = {box.min.x,box.min.y}, hi = {box.max.x,box.max.y};
+                float r0 = length(max(max(lo,-hi),0.0f)), r1 = length(max(abs(lo),abs(hi)));
+                float z0 = box.min.z, z1 = box.max.z;
+
+                bool around = lo.x<=0.0f && hi.x>=0.0f && lo.y<=0.0f && hi.y>=0.0f;
+                if(!around && !isinf(r1)){
+                    //The box does not contain the axis, so it spans less than pi and its extreme angles are at the corners.
+                    float centre = atan2((lo.y+hi.y)/2.0f,(lo.x+hi.x)/2.0f);
+                    float t0 = INFINITY, t1 = -INFINITY;
+                    for(int i=0;i<4;i++){
+                        float t = atan2((i&2)?hi.y:lo.y,(i&1)?hi.x:lo.x)-centre;
+                        t-=glm::round(t/(2.0f*pi))*2.0f*pi;
+                        t0=min(t0,t);t1=max(t1,t);
+                    }
+                    t0+=centre;t1+=centre;
+
+                    float first = glm::round(t0/sector), last = glm::round(t1/sector);
+                    if(last-first<6.0f){
+                        interval_t ret = {INFINITY,-INFINITY};
+                        for(float k=first-1.0f;k<=last+1.0f;k++){
+                            float a = max(t0-k*sector,-1.5f*sector), b = min(t1-k*sector,1.5f*sector);
+                            if(a>b)continue;
+                            ret.min=min(ret.min,left.bounds(sector_box(r0,r1,a,b,z0,z1)).min);
+                            a = max(a,-0.5f*sector); b = min(b,0.5f*sector);
+                            if(k>=first && k<=last && a<=b)ret.max=max(ret.max,left.bounds(sector_box(r0,r1,a,b,z0,z1)).max);
+                        }
+                        return ret;
+                    }
+                }
+
+                return {
+                    left.bounds(sector_box(r0,r1,-1.5f*sector,1.5f*sector,z0,z1)).min,
+                    left.bounds(sector_box(r0,r1,-0.5f*sector,0.5f*sector,z0,z1)).max
+                };
+            }
+
+            constexpr base::attrs_t operator()(const glm::vec3& pos) const{
+                auto& left = base::left();
+                typename base::attrs_t ret = {};
+                ret.distance = INFINITY;
+                sectors(pos,[&](const glm::vec3& local){
+                    auto lres = left(local);
+                    if(lres.distance<ret.distance)ret=lres;
+                });
+                return {ret.distance,normals(pos),ret.fields};
+            }
+
+            constexpr inline void traits(const traits_t& from, const traits_t&, traits_t& to) const{
+                to.is_sym={tribool::unknown,tribool::unknown,tribool::unknown};
+                to.is_exact_inner=from.is_exact_inner;
+                to.is_exact_outer=from.is_exact_outer;
+                to.is_bounded_inner=from.is_bounded_inner;
+                to.is_bounded_outer=from.is_bounded_outer;
+                if(this->cfg.count<2){to.outer_box=from.outer_box;return;}
+                //Any copy is within the cylinder swept by the farthest corner of the child.
+                auto far = max(abs(from.outer_box.min),abs(from.outer_box.max));
+                float radius = length(vec2(far.x,far.y));
+                to.outer_box={{-radius,-radius,from.outer_box.min.z},{radius,radius,from.outer_box.max.z}};
+            }
+
+            constexpr inline void traits(traits_t& to) const{
+                traits_t ltraits;
+                (base::left()).traits(ltraits);
+                traits(ltraits,ltraits,to);
+            }
+
+            constexpr inline static const char* _name = "CyclicArray";
+
+            constexpr inline static field_t _fields[] = {
+                FIELD_OP_R(CyclicArray,int,deftype,count, "Number of copies"),
+            };
+
+            PRIMITIVE_NORMAL
+        };
+    }}
+
+    sdf_register_operator_1(CyclicArray);
+}
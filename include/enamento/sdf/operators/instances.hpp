@@ -0,0 +1,188 @@
+#pragma once
+
+/**
+ * @file instances.hpp
+ * @author karurochari
+ * @brief Many copies of the same subtree, with their transforms stored in a shared slot.
+ * @date 2025-04-15
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * The slot is generated by `sampler::instances::builder`. Since the node only keeps the slot index,
+ * instances can be moved by updating the slot alone, without serializing the tree again.
+ */
+
+#ifndef SDF_INTERNALS
+#error "Don't import manually, this can only be used internally by the library"
+#endif
+
+#include "sampler/instances.hpp"
+#include "../sdf.hpp"
+
+namespace sdf{
+
+    namespace configs{
+        struct Instances{
+            shared_buffer handle;
+        };
+    }
+
+    namespace{namespace impl_base{
+
+        template <typename L>
+        struct Instances : utils::unary_op<L, configs::Instances>{
+            using base = utils::unary_op<L, configs::Instances>;
+            using base::base;
+            using extras_t = typename base::attrs_t::extras_t;
+
+            inline const sampler::instances::header_t* handle() const{
+                return (const sampler::instances::header_t*)global_shared[this->cfg.handle].base;
+            }
+
+            struct search_t{
+                const sampler::instances::header_t* head;
+                uint32_t begin;
+                uint32_t end;
+                float bound;        //Lower bound for the distance from all the instances not in [begin,end)
+            };
+
+            constexpr inline search_t search(const glm::vec3& pos) const{
+                auto head = handle();
+                if(head==nullptr)return {nullptr,0,0,INFINITY};
+
+                auto max = head->min+vec3(head->dims)*head->cell_size;
+                auto q = glm::max(head->min-pos,pos-max);
+                if(q.x>0.0f || q.y>0.0f || q.z>0.0f){
+                    return {head,0,0,length(glm::max(q,0.0f))+head->margin};
+                }
+
+                auto c = glm::clamp(ivec3(floor((pos-head->min)/head->cell_size)),ivec3(0),head->dims-1);
+                auto i = c.x+head->dims.x*(c.y+head->dims.y*c.z);
+                auto cells = sampler::instances::cells(head);
+                auto lo = head->min+vec3(c)*head->cell_size;
+                auto t = glm::min(pos-lo,lo+head->cell_size-pos);
+                return {head,cells[i].begin,cells[i+1].begin,glm::max(glm::min(t.x,glm::min(t.y,t.z)),0.0f)+cells[i].gap};
+            }
+
+            constexpr float sample(const glm::vec3& pos) const{
+                auto& left = base::left();
+                auto found = search(pos);
+                float ret = found.bound;
+                if(found.begin==found.end)return ret;
+
+                auto instances = sampler::instances::instances<extras_t>(found.head);
+                auto items = sampler::instances::items(found.head);
+                for(uint32_t k=found.begin;k<found.end;k++){
+                    auto& instance = instances[items[k]];
+                    ret = glm::min(ret,left.sample(instance.inv_linear*pos+instance.inv_offset)*instance.scale);
+                }
+                return ret;
+            }
+
+            //Only the instances listed in the cells overlapping the box are sampled, anything else is covered by the bound from `search`.
+            constexpr interval_t bounds(const bbox_t& box) const{
+                auto& left = base::left();
+                auto head = handle();
+                if(head==nullptr)return {INFINITY,INFINITY};
+
+                auto max = head->min+vec3(head->dims)*head->cell_size;
+                interval_t ret = {INFINITY,-INFINITY};
+                if(any(lessThan(box.min,head->min)) || any(greaterThan(box.max,max))){
+                    auto near = glm::max(glm::max(head->min-box.max,box.min-max),0.0f);
+                    auto far = glm::max(glm::max(head->min-box.min,box.max-max),0.0f);
+                    ret = {length(near)+head->margin,length(far)+head->margin};
+                }
+                if(any(lessThan(box.max,head->min)) || any(greaterThan(box.min,max)))return ret;
+
+                auto instances = sampler::instances::instances<extras_t>(head);
+                auto items = sampler::instances::items(head);
+                auto cells = sampler::instances::cells(head);
+                auto local = [&](const sampler::instances::instance_t<extras_t>& instance, const bbox_t& part)->interval_t{
+                    auto b = left.bounds(sdf::transform(part,instance.inv_linear,instance.inv_offset));
+                    return {b.min*instance.scale,b.max*instance.scale};
+                };
+
+                bbox_t inner = {glm::max(box.min,head->min),glm::min(box.max,max)};
+                auto from = glm::clamp(ivec3(floor((inner.min-head->min)/head->cell_size)),ivec3(0),head->dims-1);
+                auto to = glm::clamp(ivec3(floor((inner.max-head->min)/head->cell_size)),ivec3(0),head->dims-1);
+                auto span = to-from+1;
+                if(span.x*span.y*span.z>4096){
+                    //Too many cells to visit, so all instances are considered and the bound from `search` is only known to be positive.
+                    ret.min=glm::min(ret.min,0.0f);
+                    ret.max=INFINITY;
+                    for(uint32_t i=0;i<head->count;i++)ret.min=glm::min(ret.min,local(instances[i],inner).min);
+                    return ret;
+                }
+
+                for(int z=from.z;z<=to.z;z++)
+                for(int y=from.y;y<=to.y;y++)
+                for(int x=from.x;x<=to.x;x++){
+                    auto i = x+head->dims.x*(y+head->dims.y*z);
+                    auto lo = head->min+vec3(x,y,z)*head->cell_size;
+                    bbox_t part = {glm::max(inner.min,lo),glm::min(inner.max,lo+head->cell_size)};
+                    //The bound from `search` is the gap plus at most half a cell.
+                    interval_t cell = {cells[i].gap,cells[i].gap+head->cell_size/2.0f};
+                    for(uint32_t k=cells[i].begin;k<cells[i+1].begin;k++){
+                        auto b = local(instances[items[k]],part);
+                        cell.min=glm::min(cell.min,b.min);
+                        cell.max=glm::min(cell.max,b.max);
+                    }
+                    ret.min=glm::min(ret.min,cell.min);
+                    ret.max=glm::max(ret.max,cell.max);
+                }
+                return ret;
+            }
+
+            constexpr base::attrs_t operator()(const glm::vec3& pos) const{
+                auto& left = base::left();
+                auto found = search(pos);
+                typename base::attrs_t ret = {};
+                ret.distance = found.bound;
+                if(found.begin==found.end)return ret;
+
+                auto instances = sampler::instances::instances<extras_t>(found.head);
+                auto items = sampler::instances::items(found.head);
+                for(uint32_t k=found.begin;k<found.end;k++){
+                    auto& instance = instances[items[k]];
+                    auto lres = left(instance.inv_linear*pos+instance.inv_offset);
+                    lres.distance*=instance.scale;
+                    if(lres.distance<ret.distance){
+                        if(instance.flags&sampler::instances::OVERRIDE)lres.fields=instance.extras;
+                        ret=lres;
+                    }
+                }
+                return ret;
+            }
+
+            constexpr inline void traits(const traits_t& from, const traits_t&, traits_t& to) const{
+                to.is_sym={tribool::unknown,tribool::unknown,tribool::unknown};
+                to.is_exact_inner=false;
+                to.is_exact_outer=false;
+                to.is_bounded_inner=from.is_bounded_inner;
+                to.is_bounded_outer=from.is_bounded_outer;
+                auto head = handle();
+                if(head!=nullptr && head->count>0){
+                    //The grid is larger than needed by `margin`, but that is still a valid bounding box.
+                    to.outer_box={head->min,head->min+vec3(head->dims)*head->cell_size};
+                }
+                else to.outer_box={};
+            }
+
+            constexpr inline void traits(traits_t& to) const{
+                traits_t ltraits;
+                (base::left()).traits(ltraits);
+                traits(ltraits,ltraits,to);
+            }
+
+            constexpr inline static const char* _name = "Instances";
+
+            constexpr inline static field_t _fields[] = {
+                FIELD_OP_R(Instances,shared_buffer,deftype,handle, "Instances buffer")
+            };
+
+            PRIMITIVE_NORMAL
+        };
+    }}
+
+    sdf_register_operator_1(Instances);
+}
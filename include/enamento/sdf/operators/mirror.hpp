@@ -0,0 +1,105 @@
+#pragma once
+
+/**
+ * @file mirror.hpp
+ * @author karurochari
+ * @brief Mirror the subtree along the main planes through the origin.
+ * @date 2025-04-16
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ * The position is folded on the positive side of each selected plane, so the child is evaluated once.
+ * Only the part of the child on the positive side is kept (and mirrored).
+ * The field stays exact when the child does not cross the planes, otherwise it is just a lower bound.
+ */
+
+#ifndef SDF_INTERNALS
+#error "Don't import manually, this can only be used internally by the library"
+#endif
+
+#include "../sdf.hpp"
+
+namespace sdf{
+
+    namespace configs{
+        struct Mirror{
+            glm::ivec3 axes = {1,0,0};      //Non-zero to mirror along that axis
+        };
+    }
+
+    namespace{namespace impl_base{
+
+        template <typename L>
+        struct Mirror : utils::unary_op<L, configs::Mirror>{
+            using base = utils::unary_op<L, configs::Mirror>;
+            using base::base;
+
+            constexpr inline vec3 fold(const glm::vec3& pos) const{
+                return {this->cfg.axes.x?abs(pos.x):pos.x,this->cfg.axes.y?abs(pos.y):pos.y,this->cfg.axes.z?abs(pos.z):pos.z};
+            }
+
+            constexpr float sample(const glm::vec3& pos) const{
+                auto& left = base::left();
+                return left.sample(fold(pos));
+            }
+
+            constexpr bbox_t region(const bbox_t& box) const{
+                bbox_t folded = box;
+                for(int i=0;i<3;i++){
+                    if(!this->cfg.axes[i])continue;
+                    folded.min[i]=max(max(box.min[i],-box.max[i]),0.0f);
+                    folded.max[i]=max(abs(box.min[i]),abs(box.max[i]));
+                }
+                return folded;
+            }
+
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return base::left().bounds(region(box));
+            }
+
+            constexpr base::attrs_t operator()(const glm::vec3& pos) const{
+                auto& left = base::left();
+                auto lres = left(fold(pos));
+                return {lres.distance,normals(pos),lres.fields};
+            }
+
+            constexpr inline void traits(const traits_t& from, const traits_t&, traits_t& to) const{
+                bool crossing = false;
+                for(int i=0;i<3;i++){
+                    to.is_sym[i]=this->cfg.axes[i]?true:tribool::unknown;
+                    if(this->cfg.axes[i]){
+                        crossing|=from.outer_box.min[i]<0.0f;
+                        //Only the positive side is kept, and mirrored.
+                        float extent = max(from.outer_box.max[i],0.0f);
+                        to.outer_box.min[i]=-extent;
+                        to.outer_box.max[i]=extent;
+                    }
+                    else{
+                        to.outer_box.min[i]=from.outer_box.min[i];
+                        to.outer_box.max[i]=from.outer_box.max[i];
+                    }
+                }
+                to.is_exact_inner=crossing?tribool::unknown:from.is_exact_inner;
+                to.is_exact_outer=crossing?tribool::unknown:from.is_exact_outer;
+                to.is_bounded_inner=from.is_bounded_inner;
+                to.is_bounded_outer=from.is_bounded_outer;
+            }
+
+            constexpr inline void traits(traits_t& to) const{
+                traits_t ltraits;
+                (base::left()).traits(ltraits);
+                traits(ltraits,ltraits,to);
+            }
+
+            constexpr inline static const char* _name = "Mirror";
+
+            constexpr inline static field_t _fields[] = {
+                FIELD_OP_R(Mirror,ivec3,deftype,axes, "Axes to mirror along"),
+            };
+
+            PRIMITIVE_NORMAL
+        };
+    }}
+
+    sdf_register_operator_1(Mirror);
+}
@@ -46,6 +46,16 @@ namespace sdf{
                 return lres;
             }
 
+            //Box containing the rotated one.
+            constexpr bbox_t region(const bbox_t& box) const{
+                auto rotation = rotate_x(this->cfg.rotation.x)*rotate_y(this->cfg.rotation.y)*rotate_z(this->cfg.rotation.z);
+                return sdf::transform(box,transpose(rotation),vec3(0));
+            }
+
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return base::left().bounds(region(box));
+            }
+
             constexpr base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
                 auto newpos=pos;
@@ -71,16 +81,20 @@ namespace sdf{
                 traits(ltraits,ltraits,to);
             }
 
+            //Box of all the corners, as rotating just min and max does not bound the rotated box.
+            //Samples are rotated into the space of the child, so its corners go through the inverse rotation.
             constexpr inline bbox_t cbbox(bbox_t box) const{
-                box.min = box.min*rotate_x(this->cfg.rotation.x);
-                box.min = box.min*rotate_y(this->cfg.rotation.y);
-                box.min = box.min*rotate_z(this->cfg.rotation.z);
-
-                box.max = box.max*rotate_x(this->cfg.rotation.x);
-                box.max = box.max*rotate_y(this->cfg.rotation.y);
-                box.max = box.max*rotate_z(this->cfg.rotation.z);
-
-                return box;
+                if(any(isinf(box.min)) || any(isinf(box.max)))return {};
+                bbox_t ret = {vec3(INFINITY),vec3(-INFINITY)};
+                for(int i=0;i<8;i++){
+                    vec3 corner = {(i&1)?box.max.x:box.min.x,(i&2)?box.max.y:box.min.y,(i&4)?box.max.z:box.min.z};
+                    corner = rotate_z(this->cfg.rotation.z)*corner;
+                    corner = rotate_y(this->cfg.rotation.y)*corner;
+                    corner = rotate_x(this->cfg.rotation.x)*corner;
+                    ret.min=min(ret.min,corner);
+                    ret.max=max(ret.max,corner);
+                }
+                return ret;
             }
 
             constexpr inline static const char* _name = "Rotate";
@@ -31,6 +31,29 @@ namespace sdf{
                 return mix( rres, lres, h ) - this->cfg.factor*h*(1.0-h);
             }
 
+            constexpr inline float blend(float l, float r) const{
+                //Far apart it is the plain minimum, which also avoids NaNs with infinite bounds.
+                if(isinf(l) || isinf(r) || abs(r-l)>=this->cfg.factor)return min(l,r);
+                float h = clamp(0.5f+0.5f*(r-l)/this->cfg.factor,0.0f,1.0f);
+                return mix(r,l,h)-this->cfg.factor*h*(1.0f-h);
+            }
+
+            //The derivatives of the blend with respect to both operands are within [0,1], so it is monotonic in both.
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return bounds(base::left().bounds(box),base::right().bounds(box));
+            }
+
+            constexpr interval_t bounds(const interval_t& lres, const interval_t& rres) const{
+                return {blend(lres.min,rres.min),blend(lres.max,rres.max)};
+            }
+
+            //Once the operands are at least `factor` apart the blend is the plain minimum.
+            constexpr path_t prune(const interval_t& lres, const interval_t& rres) const{
+                if(lres.min-rres.max>=this->cfg.factor)return RIGHT;
+                if(rres.min-lres.max>=this->cfg.factor)return LEFT;
+                return END;
+            }
+
             constexpr base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
                 auto& right = base::right();
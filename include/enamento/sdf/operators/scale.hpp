@@ -37,6 +37,15 @@ namespace sdf{
                 return lres;
             }
 
+            constexpr bbox_t region(const bbox_t& box) const{
+                auto a = box.min*this->cfg.scale, b = box.max*this->cfg.scale;
+                return {min(a,b),max(a,b)};
+            }
+
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return base::left().bounds(region(box));
+            }
+
             constexpr base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
                 auto lres = left(pos*this->cfg.scale);
@@ -49,7 +58,7 @@ namespace sdf{
                 to.is_exact_outer=from.is_exact_outer;
                 to.is_bounded_inner=from.is_bounded_inner;
                 to.is_bounded_outer=from.is_bounded_outer;
-                to.outer_box={from.outer_box.min*this->cfg.scale,from.outer_box.max*this->cfg.scale};
+                to.outer_box={from.outer_box.min/this->cfg.scale,from.outer_box.max/this->cfg.scale};
             }
 
             constexpr inline void traits(traits_t& to) const{
@@ -37,6 +37,14 @@ namespace sdf{
                 return lres;
             }
 
+            constexpr bbox_t region(const bbox_t& box) const{
+                return {box.min-this->cfg.offset,box.max-this->cfg.offset};
+            }
+
+            constexpr interval_t bounds(const bbox_t& box) const{
+                return base::left().bounds(region(box));
+            }
+
             constexpr base::attrs_t operator()(const glm::vec3& pos) const{
                 auto& left = base::left();
                 auto lres = left(pos-this->cfg.offset);
@@ -49,7 +57,7 @@ namespace sdf{
                 to.is_exact_outer=from.is_exact_outer;
                 to.is_bounded_inner=from.is_bounded_inner;
                 to.is_bounded_outer=from.is_bounded_outer;
-                to.outer_box={from.outer_box.min-this->cfg.offset,from.outer_box.max-this->cfg.offset};
+                to.outer_box={from.outer_box.min+this->cfg.offset,from.outer_box.max+this->cfg.offset};
             }
 
             constexpr inline void traits(traits_t& to) const{
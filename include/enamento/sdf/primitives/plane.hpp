@@ -32,6 +32,7 @@ namespace sdf{
             [[no_unique_address]] Attrs::extras_t cfg;
 
             constexpr inline float sample(const glm::vec3& pos)const {return dot(pos,vec3(0,1,0));}
+            constexpr inline interval_t bounds(const bbox_t& box)const {return {box.min.y,box.max.y};}
 
             constexpr Plane(Attrs::extras_t cfg={}):cfg(cfg){}
 
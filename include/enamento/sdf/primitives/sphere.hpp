@@ -40,6 +40,13 @@ namespace sdf{
 
             constexpr inline float sample(const glm::vec3& pos)const {return glm::length(pos)-radius;}
 
+            //Monotonic in the absolute value of each coordinate, so the extremes are at the closest and farthest points of the box from the origin.
+            constexpr inline interval_t bounds(const bbox_t& box)const {
+                auto near = max(max(box.min,-box.max),0.0f);
+                auto far = max(abs(box.min),abs(box.max));
+                return {sample(near),sample(far)};
+            }
+
             constexpr inline void traits(traits_t& to) const{
                 PRIMITIVE_TRAIT_SYM;
                 PRIMITIVE_TRAIT_GOOD;
@@ -38,6 +38,7 @@ namespace sdf{
             constexpr Zero(Attrs::extras_t cfg={}):cfg(cfg){}
 
             constexpr inline float sample(const glm::vec3&)const {return INFINITY;}
+            constexpr inline interval_t bounds(const bbox_t&)const {return {INFINITY,INFINITY};}
 
             constexpr inline void traits(traits_t& to) const{
                 PRIMITIVE_TRAIT_SYM;
@@ -0,0 +1,184 @@
+#pragma once
+
+/**
+ * @file profile.hpp
+ * @author karurochari
+ * @brief Optional profiler of the evaluation of SDF trees, counting samples and time spent in each node.
+ * @date 2025-04-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * It is only compiled in when `SDF_PROFILE` is defined, otherwise `SDF_PROFILE_SCOPE` expands to nothing and none of this has a cost.
+ * Nodes of dynamic trees and of `tree_idx` trees (and so frozen and interpreted ones) are instrumented, both for `sample` and `operator()`.
+ * Other backends are not, as comptime trees are meant to be inlined as a whole.
+ *
+ * Each thread accumulates into its own table, so sampling in parallel does not contend on shared counters.
+ * Tables are merged when reading, which should only be done while no sampling is in progress, like between frames.
+ * Nodes are identified by their `addr()`, the same address passed to the visitors, so counters can be looked up from `ctree_visit_pre`.
+ * Times are inclusive of children, `collect` derives the time spent in each node alone.
+ * Subtrees shared by the builder are a single node in flat trees, so their counters sum up all the places they are used from.
+ *
+ * Counters are only available on the host, device code is never instrumented.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//SDF_IS_HOST is false for headless builds too, so device passes are told apart by their target.
+#if defined(SDF_PROFILE) && !defined(__NVPTX__) && !defined(__AMDGCN__)
+    #define SDF_PROFILE_ENABLED true
+    #include <chrono>
+    #include <memory>
+    #include <mutex>
+    #include <unordered_map>
+    #define SDF_PROFILE_SCOPE(...) sdf::profile::scope _sdf_profile_scope(__VA_ARGS__)
+#else
+    #define SDF_PROFILE_ENABLED false
+    #define SDF_PROFILE_SCOPE(...)
+#endif
+
+namespace sdf{
+namespace profile{
+
+struct counter_t{
+    uint64_t samples = 0;
+    uint64_t ns = 0;            //Inclusive of the children
+
+    inline counter_t& operator+=(const counter_t& o){samples+=o.samples;ns+=o.ns;return *this;}
+};
+
+#if SDF_PROFILE_ENABLED
+
+//Not in an anonymous namespace, as all translation units must share the same registry.
+namespace internal{
+    struct table_t{
+        std::unordered_map<const void*,counter_t> nodes;
+    };
+
+    struct registry_t{
+        std::mutex mtx;
+        std::vector<std::unique_ptr<table_t>> tables;   //Owned here, so counters survive the threads which wrote them
+    };
+
+    inline registry_t& registry(){
+        static registry_t instance;
+        return instance;
+    }
+
+    inline table_t& local(){
+        thread_local table_t* table = nullptr;
+        if(table==nullptr){
+            auto& reg = registry();
+            std::lock_guard lock(reg.mtx);
+            reg.tables.push_back(std::make_unique<table_t>());
+            table = reg.tables.back().get();
+        }
+        return *table;
+    }
+
+    inline uint64_t now(){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+using namespace internal;
+
+struct scope{
+    private:
+        counter_t& counter;
+        uint64_t start;
+
+    public:
+        //References to elements of unordered maps are stable, so the counter can be held across nested scopes.
+        inline scope(const void* node):counter(local().nodes[node]),start(now()){}
+        inline ~scope(){counter.samples++;counter.ns+=now()-start;}
+};
+
+/**
+ * @brief Counters of a node, summed over all threads.
+ */
+inline counter_t get(const void* node){
+    counter_t ret;
+    auto& reg = registry();
+    std::lock_guard lock(reg.mtx);
+    for(auto& table: reg.tables){
+        auto it = table->nodes.find(node);
+        if(it!=table->nodes.end())ret+=it->second;
+    }
+    return ret;
+}
+
+inline void reset(){
+    auto& reg = registry();
+    std::lock_guard lock(reg.mtx);
+    for(auto& table: reg.tables)table->nodes.clear();
+}
+
+#else
+
+inline counter_t get(const void*){return {};}
+inline void reset(){}
+
+#endif
+
+struct entry_t{
+    const char* name;
+    const void* node;
+    uint32_t    depth;
+    uint32_t    parent;         //Index of the parent entry, or itself for the root
+    counter_t   total;
+    uint64_t    self_ns;        //Time spent in this node alone
+};
+
+/**
+ * @brief Counters of all nodes of a tree, in pre-order.
+ *
+ * @param root
+ * @return std::vector<entry_t>
+ */
+template<typename S>
+std::vector<entry_t> collect(const S& root){
+    std::vector<entry_t> ret;
+    //Entries still expecting children, with how many are left.
+    std::vector<std::pair<uint32_t,size_t>> open;
+    root.ctree_visit_pre([&](const char* name, fields_t, const void* base, size_t children){
+        while(!open.empty() && open.back().second==0)open.pop_back();
+        uint32_t idx = ret.size();
+        uint32_t parent = idx;
+        if(!open.empty()){
+            parent = open.back().first;
+            open.back().second--;
+        }
+        auto total = get(base);
+        ret.push_back({name,base,(uint32_t)open.size(),parent,total,total.ns});
+        open.push_back({idx,children});
+        return true;
+    });
+    for(uint32_t i=0;i<ret.size();i++){
+        if(ret[i].parent==i)continue;
+        auto& parent = ret[ret[i].parent];
+        parent.self_ns-=std::min(parent.self_ns,ret[i].total.ns);
+    }
+    return ret;
+}
+
+/**
+ * @brief Write a report in the folded format used by flame graph tools, one line per node with its path from the root and time in ns spent there alone.
+ *
+ * @param entries as returned by `collect`
+ * @param out
+ */
+inline void flame(const std::vector<entry_t>& entries, std::ostream& out){
+    std::vector<std::string> paths(entries.size());
+    for(uint32_t i=0;i<entries.size();i++){
+        auto& e = entries[i];
+        paths[i] = e.parent==i?std::string(e.name):paths[e.parent]+";"+e.name;
+        if(e.self_ns>0)out<<paths[i]<<" "<<e.self_ns<<"\n";
+    }
+}
+
+}
+}
@@ -20,7 +20,9 @@
 #include <omp.h>
 
 #include "utils/static.hpp"
+#include "utils/arena.hpp"
 #include "commons.hpp"
+#include "profile.hpp"
 
 #define SDF_INTERNALS
 
@@ -78,6 +80,7 @@ namespace sdf{
 
             inline Attrs operator()(const glm::vec3& pos) const;
             inline float sample(const glm::vec3& pos) const;
+            inline interval_t bounds(const bbox_t& box) const;
 
             inline void traits(traits_t&) const;
             inline const char* name() const;
@@ -93,10 +96,43 @@ namespace sdf{
             inline void* addr();
             inline const void* addr() const;
             inline size_t children() const;
+
+            inline uint64_t to_tree(tree::builder& dst) const;
+            inline interval_t region_bounds(tree::builder& dst) const;
         };
 
         struct empty_t{};
 
+        /**
+         * @brief Box in the frame of the child of a unary operator, containing all the points it samples for positions in `box`.
+         * Operators which cannot map it return an infinite box, which disables pruning in their subtree.
+         */
+        template<typename T>
+        constexpr inline bbox_t child_region(const T& op, const bbox_t& box){
+            if constexpr(requires{{op.region(box)} -> std::same_as<bbox_t>;})return op.region(box);
+            else return {};
+        }
+
+        /**
+         * @brief Bounds of a node over the region of `dst`. Binary operators keep theirs in `dst`, so each subtree is only bounded once while serializing.
+         */
+        template<typename T>
+        inline interval_t region_bounds(const T& node, tree::builder& dst){
+            if constexpr(requires{{node.region_bounds(dst)} -> std::same_as<interval_t>;})return node.region_bounds(dst);
+            else return node.bounds(dst.region);
+        }
+
+        /**
+         * @brief Branch of a binary operator which alone gives the same result in the region of `dst`, or END if both are needed.
+         */
+        template<typename T>
+        inline path_t prune_branch(const T& op, tree::builder& dst){
+            auto& box = dst.region;
+            if(glm::any(glm::isinf(box.min)) || glm::any(glm::isinf(box.max)))return END;
+            if constexpr(requires(const interval_t& i){{op.prune(i,i)} -> std::same_as<path_t>;})return op.prune(region_bounds(op.left(),dst),region_bounds(op.right(),dst));
+            else return END;
+        }
+
         template <typename Attrs, template<typename, typename... Args> typename T, typename... Args> requires sdf_i<T<Attrs,Args...>>
         using primitive = T<Attrs, Args...>;
 
@@ -105,6 +141,7 @@ namespace sdf{
             using attrs_t = Attrs;
             virtual constexpr inline Attrs operator()(const glm::vec3& pos) const =0;
             virtual constexpr inline float sample(const glm::vec3& pos) const  =0;
+            virtual constexpr inline interval_t bounds(const bbox_t& box) const  =0;
 
             virtual constexpr inline void traits(traits_t&) const=0;
             virtual constexpr inline const char* name() const=0;
@@ -122,16 +159,19 @@ namespace sdf{
             virtual constexpr size_t children() const=0;
 
             virtual uint64_t to_tree(tree::builder& dst)const=0;
+            virtual interval_t region_bounds(tree::builder& dst)const{return bounds(dst.region);}
 
             virtual ~base_dyn(){}
         };  
 
         template <typename Attrs, template<typename, typename... Args> typename T, typename... Args> requires sdf_i<T<Attrs,Args...>>
         struct dyn : T<Attrs, Args...>, base_dyn<Attrs>{
+            using attrs_t = Attrs;      //Both bases define it
             dyn(const T<Attrs, Args...>& ref):T<Attrs,Args...>(ref){}
 
-            virtual constexpr inline Attrs operator()(const glm::vec3& pos) const override{return static_cast<const T<Attrs, Args...>*>(this)->operator()(pos);}
-            virtual constexpr inline float sample(const glm::vec3& pos) const override{return static_cast<const T<Attrs, Args...>*>(this)->sample(pos);}
+            virtual constexpr inline Attrs operator()(const glm::vec3& pos) const override{SDF_PROFILE_SCOPE(static_cast<const T<Attrs, Args...>*>(this));return static_cast<const T<Attrs, Args...>*>(this)->operator()(pos);}
+            virtual constexpr inline float sample(const glm::vec3& pos) const override{SDF_PROFILE_SCOPE(static_cast<const T<Attrs, Args...>*>(this));return static_cast<const T<Attrs, Args...>*>(this)->sample(pos);}
+            virtual constexpr inline interval_t bounds(const bbox_t& box) const override{return static_cast<const T<Attrs, Args...>*>(this)->bounds(box);}
 
             virtual constexpr inline void traits(traits_t& t) const override{return static_cast<const T<Attrs, Args...>*>(this)->traits(t);}
             virtual constexpr inline const char* name() const override{return static_cast<const T<Attrs, Args...>*>(this)->name();}
@@ -149,12 +189,15 @@ namespace sdf{
             virtual constexpr inline size_t children() const override{return static_cast<const T<Attrs, Args...>*>(this)->children();}
 
             virtual uint64_t to_tree(tree::builder& dst)const override{return static_cast<const T<Attrs, Args...>*>(this)->to_tree(dst);};
+            virtual interval_t region_bounds(tree::builder& dst)const override{return utils::region_bounds(*static_cast<const T<Attrs, Args...>*>(this),dst);};
         };
 
         template <typename Attrs, typename T> requires sdf_i<T> 
         struct dyn_op : T, base_dyn<Attrs>{
-            virtual constexpr inline Attrs operator()(const glm::vec3& pos) const override{return static_cast<const T*>(this)->operator()(pos);}
-            virtual constexpr inline float sample(const glm::vec3& pos) const override{return static_cast<const T*>(this)->sample(pos);}
+            using attrs_t = Attrs;
+            virtual constexpr inline Attrs operator()(const glm::vec3& pos) const override{SDF_PROFILE_SCOPE(static_cast<const T*>(this));return static_cast<const T*>(this)->operator()(pos);}
+            virtual constexpr inline float sample(const glm::vec3& pos) const override{SDF_PROFILE_SCOPE(static_cast<const T*>(this));return static_cast<const T*>(this)->sample(pos);}
+            virtual constexpr inline interval_t bounds(const bbox_t& box) const override{return static_cast<const T*>(this)->bounds(box);}
 
             virtual constexpr inline void traits(traits_t& t) const override{return static_cast<const T*>(this)->traits(t);}
             virtual constexpr inline void traits(const traits_t& l, const traits_t& r, traits_t& t) const {return static_cast<const T*>(this)->traits(l,r,t);}
@@ -173,10 +216,31 @@ namespace sdf{
             virtual constexpr inline size_t children() const override{return static_cast<const T*>(this)->children();}
 
             virtual constexpr uint64_t to_tree(tree::builder& dst)const override{return static_cast<const T*>(this)->to_tree(dst);};
+            virtual interval_t region_bounds(tree::builder& dst)const override{return utils::region_bounds(*static_cast<const T*>(this),dst);};
             
             using T::T;
             using operation = T;
         };
+
+        /**
+         * @brief If set, nodes built by the `dynamic` factories on this thread are allocated from this arena.
+         * Nodes end up contiguous in construction order, control block included. The arena must outlive them, which is asserted when it is released.
+         * Only the allocation changes: handles are still `std::shared_ptr` with atomic counters, and nothing is flattened implicitly.
+         * Trees meant to be evaluated many times, like for rendering, should be flattened with `dynamic::freeze`.
+         */
+        inline thread_local arena* dyn_arena = nullptr;
+
+        struct dyn_arena_scope{
+            arena* prev;
+            dyn_arena_scope(arena& src):prev(dyn_arena){dyn_arena=&src;}
+            ~dyn_arena_scope(){dyn_arena=prev;}
+        };
+
+        template <typename T, typename... Args>
+        inline std::shared_ptr<T> make_dyn(Args&&... args){
+            if(dyn_arena!=nullptr)return std::allocate_shared<T>(arena_allocator<T>(*dyn_arena),std::forward<Args>(args)...);
+            return std::make_shared<T>(std::forward<Args>(args)...);
+        }
       
 
         template <typename L, typename CFG = empty_t>
@@ -386,6 +450,7 @@ namespace{
     struct NAME : impl_base::NAME<Attrs>{                                                                       \
         using attrs_t = Attrs;                                                                                  \
         uint64_t to_tree(tree::builder& dst)const;                                                              \
+        inline interval_t region_bounds(tree::builder& dst)const{return this->bounds(dst.region);}              \
         using impl_base::NAME<Attrs>::fields;                                                                   \
         inline fields_t fields(const path_t* steps) const;                                                      \
         constexpr bool tree_visit_pre(const visitor_t& op);                                                     \
@@ -422,8 +487,9 @@ namespace{
     }                                                                                                           \
     template <typename Attrs>                                                                                   \
     uint64_t  NAME <Attrs> :: to_tree(tree::builder& dst)const {                                                \
-        auto idx= dst.push(tree::op_t:: NAME, (uint8_t*)this, sizeof( NAME<Attrs> ));                           \
-        return idx;                                                                                             \
+        auto start = dst.mark();                                                                                \
+        auto idx= dst.push(tree::op_t:: NAME, (uint8_t*)this, sizeof( NAME<Attrs> ), this->addr());             \
+        return dst.share(start, idx, (const uint8_t*)this, sizeof( NAME<Attrs> ), {});                          \
     }                                                                                                           \
 }                                                                                                               \
 }                                                                                                               \
@@ -449,7 +515,7 @@ namespace dynamic {
     template <typename Attrs=default_attrs>                                                                     \
     constexpr inline std::shared_ptr<utils::base_dyn<Attrs>> NAME (  impl::NAME<Attrs> && ref ){                \
         std::shared_ptr<utils::base_dyn<Attrs>> tmp =                                                           \
-            std::make_shared<utils::dyn<Attrs,impl::NAME>>(utils::dyn<Attrs,impl::NAME>(ref));                  \
+            utils::make_dyn<utils::dyn<Attrs,impl::NAME>>(utils::dyn<Attrs,impl::NAME>(ref));                   \
         return tmp;                                                                                             \
     }                                                                                                           \
 }                                                                                                               \
@@ -470,6 +536,7 @@ namespace impl{
     struct NAME : impl_base::NAME<A,B>{                                                                         \
         using typename impl_base::NAME<A,B>::attrs_t;                                                           \
         uint64_t to_tree(tree::builder& dst)const;                                                              \
+        interval_t region_bounds(tree::builder& dst)const;                                                      \
         using impl_base::NAME<A,B>::fields;                                                                     \
         inline fields_t fields(const path_t* steps) const;                                                      \
         constexpr bool tree_visit_pre(const visitor_t& op);                                                     \
@@ -522,18 +589,38 @@ namespace impl{
         return sval && lval && rval;                                                                            \
     }                                                                                                           \
     template<typename A, typename B>                                                                            \
+    interval_t NAME <A,B> :: region_bounds(tree::builder& dst)const {                                           \
+        /*Operands are bounded once and combined, so a chain of operators is walked once for each region.*/     \
+        if(auto cached = dst.cached_bounds(this->addr()); cached!=nullptr)return *cached;                       \
+        auto ret = this->bounds(utils::region_bounds(this->left(),dst),utils::region_bounds(this->right(),dst));\
+        dst.cache_bounds(this->addr(),ret);                                                                     \
+        return ret;                                                                                             \
+    }                                                                                                           \
+    template<typename A, typename B>                                                                            \
     uint64_t NAME <A,B> :: to_tree(tree::builder& dst)const {                                                   \
+        if(dst.prune){                                                                                          \
+            auto keep = utils::prune_branch(*this,dst);                                                         \
+            if(keep!=END)dst.stats.pruned++;                                                                    \
+            if(keep==LEFT)return base::left().to_tree(dst);                                                     \
+            if(keep==RIGHT)return base::right().to_tree(dst);                                                   \
+        }                                                                                                       \
+        auto start = dst.mark();                                                                                \
         auto lname= base::left().to_tree(dst);                                                                  \
         auto rname = base::right().to_tree(dst);                                                                \
+        using node_t = NAME <utils::tree_idx_ref<utils::tree_idx<typename base::attrs_t>>,utils::tree_idx_ref<utils::tree_idx<typename base::attrs_t>>>;\
+        /*Key for hash-consing: same node with null references, as children are identified by their canonical ids.*/\
+        alignas(node_t) uint8_t key[sizeof(node_t)] = {};                                                       \
         if constexpr(std::is_same<typename base::cfg_t, utils::empty_t>()){                                     \
-            NAME <utils::tree_idx_ref<utils::tree_idx<A>>,utils::tree_idx_ref<utils::tree_idx<B>>> tmp({(uint16_t)(dst.next()-lname)},{(uint16_t)(dst.next()-rname)});          \
-            auto ret = dst.push(tree::op_t:: NAME, (uint8_t*)&tmp, sizeof(decltype(tmp)));                      \
-            return ret;                                                                                         \
+            node_t tmp({(uint16_t)(dst.next()-lname)},{(uint16_t)(dst.next()-rname)});                          \
+            new (key) node_t({0},{0});                                                                          \
+            auto ret = dst.push(tree::op_t:: NAME, (uint8_t*)&tmp, sizeof(decltype(tmp)), this->addr());        \
+            return dst.share(start, ret, key, sizeof(key), {lname, rname});                                     \
         }                                                                                                       \
         else{                                                                                                   \
-            NAME <utils::tree_idx_ref<utils::tree_idx<A>>,utils::tree_idx_ref<utils::tree_idx<B>>> tmp({(uint16_t)(dst.next()-lname)},{(uint16_t)(dst.next()-rname)}, this->cfg);\
-            auto ret = dst.push(tree::op_t:: NAME, (uint8_t*)&tmp, sizeof(decltype(tmp)));                      \
-            return ret;                                                                                         \
+            node_t tmp({(uint16_t)(dst.next()-lname)},{(uint16_t)(dst.next()-rname)}, this->cfg);               \
+            new (key) node_t({0},{0}, this->cfg);                                                               \
+            auto ret = dst.push(tree::op_t:: NAME, (uint8_t*)&tmp, sizeof(decltype(tmp)), this->addr());        \
+            return dst.share(start, ret, key, sizeof(key), {lname, rname});                                     \
         }                                                                                                       \
     }                                                                                                           \
 }}                                                                                                              \
@@ -575,7 +662,7 @@ namespace dynamic {
         std::shared_ptr<utils::base_dyn<Attrs>> a,                                                              \
         std::shared_ptr<utils::base_dyn<Attrs>> b                                                               \
     ){                                                                                                          \
-        return std::make_shared<utils::dyn_op<Attrs,impl::NAME<decltype(a),decltype(b)>>>(a,b);                 \
+        return utils::make_dyn<utils::dyn_op<Attrs,impl::NAME<decltype(a),decltype(b)>>>(a,b);                  \
     }                                                                                                           \
     template<typename Attrs=default_attrs>                                                                      \
     constexpr inline std::shared_ptr<utils::base_dyn<Attrs>> NAME                                               \
@@ -584,7 +671,7 @@ namespace dynamic {
         std::shared_ptr<utils::base_dyn<Attrs>> b,                                                              \
         const typename configs:: NAME& cfg                                                                      \
     ){                                                                                                          \
-        return std::make_shared<utils::dyn_op<Attrs,impl::NAME<decltype(a),decltype(b)>>>(a,b,cfg);             \
+        return utils::make_dyn<utils::dyn_op<Attrs,impl::NAME<decltype(a),decltype(b)>>>(a,b,cfg);              \
     }                                                                                                           \
 }                                                                                                               \
 
@@ -598,6 +685,7 @@ namespace impl{
     struct NAME : impl_base::NAME<A>{                                                                           \
         using typename impl_base::NAME<A>::attrs_t;                                                             \
         uint64_t to_tree(tree::builder& dst)const;                                                              \
+        inline interval_t region_bounds(tree::builder& dst)const{return this->bounds(dst.region);}              \
         using impl_base::NAME<A>::fields;                                                                       \
         inline fields_t fields(const path_t* steps) const;                                                      \
         constexpr bool tree_visit_pre(const visitor_t& op);                                                     \
@@ -646,16 +734,24 @@ namespace impl{
     }                                                                                                           \
     template<typename A>                                                                                        \
     uint64_t NAME <A> :: to_tree(tree::builder& dst)const {                                                     \
+        auto start = dst.mark();                                                                                \
+        auto region = dst.region;                                                                               \
+        if(dst.prune)dst.region = utils::child_region(*this,region);                                            \
         auto lname= base::left().to_tree(dst);                                                                  \
+        dst.region = region;                                                                                    \
+        using node_t = NAME <utils::tree_idx_ref<utils::tree_idx<typename base::attrs_t>>>;                      \
+        alignas(node_t) uint8_t key[sizeof(node_t)] = {};                                                       \
         if constexpr(std::is_same<typename base::cfg_t, utils::empty_t>()){                                     \
-            NAME <utils::tree_idx_ref<utils::tree_idx<A>>> tmp({(uint16_t)(dst.next()-lname)});                 \
-            auto ret = dst.push(tree::op_t:: NAME, (uint8_t*)&tmp, sizeof(decltype(tmp)));                      \
-            return ret;                                                                                         \
+            node_t tmp({(uint16_t)(dst.next()-lname)});                                                         \
+            new (key) node_t({0});                                                                              \
+            auto ret = dst.push(tree::op_t:: NAME, (uint8_t*)&tmp, sizeof(decltype(tmp)), this->addr());        \
+            return dst.share(start, ret, key, sizeof(key), {lname});                                            \
         }                                                                                                       \
         else{                                                                                                   \
-            NAME <utils::tree_idx_ref<utils::tree_idx<A>>> tmp({(uint16_t)(dst.next()-lname)}, this->cfg);      \
-            auto ret = dst.push(tree::op_t:: NAME, (uint8_t*)&tmp, sizeof(decltype(tmp)));                      \
-            return ret;                                                                                         \
+            node_t tmp({(uint16_t)(dst.next()-lname)}, this->cfg);                                              \
+            new (key) node_t({0}, this->cfg);                                                                   \
+            auto ret = dst.push(tree::op_t:: NAME, (uint8_t*)&tmp, sizeof(decltype(tmp)), this->addr());        \
+            return dst.share(start, ret, key, sizeof(key), {lname});                                            \
         }                                                                                                       \
     }                                                                                                           \
 }}                                                                                                              \
@@ -692,7 +788,7 @@ namespace dynamic {
     (                                                                                                           \
         std::shared_ptr<utils::base_dyn<Attrs>> a                                                               \
     ){                                                                                                          \
-        return std::make_shared<utils::dyn_op<Attrs,impl::NAME<decltype(a)>>>(a);                               \
+        return utils::make_dyn<utils::dyn_op<Attrs,impl::NAME<decltype(a)>>>(a);                                \
     }                                                                                                           \
     template<typename Attrs=default_attrs>                                                                      \
     constexpr inline std::shared_ptr<utils::base_dyn<Attrs>> NAME                                               \
@@ -700,7 +796,7 @@ namespace dynamic {
         std::shared_ptr<utils::base_dyn<Attrs>> a,                                                              \
         const typename impl::NAME<std::shared_ptr<utils::base_dyn<Attrs>>>::base::cfg_t& cfg                    \
     ){                                                                                                          \
-        return std::make_shared<utils::dyn_op<Attrs,impl::NAME<decltype(a)>>>(a,cfg);                           \
+        return utils::make_dyn<utils::dyn_op<Attrs,impl::NAME<decltype(a)>>>(a,cfg);                            \
     }                                                                                                           \
 }  
 
@@ -825,11 +921,15 @@ namespace dynamic {
 #include "operators/rotate.hpp"
 #include "operators/scale.hpp"
 
+//Instancing
+#include "operators/instances.hpp"
+
 //TODO: this might be unlocked for not host targets if the global buffers are used to store the actual pointers as it was done in the following data structures.
 #if SDF_IS_HOST==true
 #include "special/dynlib.hpp"
 #endif
 #include "special/interpreted.hpp"
+#include "special/frozen.hpp"
 #include "special/octa-sampled-3d.hpp"
 #include "special/octa-sampled-2d.hpp"
 
@@ -837,12 +937,12 @@ namespace dynamic {
 //Construction
 //#include "operators/extrude.hpp"
 //#include "operators/revolve.hpp"
-//#include "operators/array.hpp"
-//#include "operators/cyclic-array.hpp"
+#include "operators/array.hpp"
+#include "operators/cyclic-array.hpp"
 //#include "operators/elongate.hpp"
 //#include "operators/round.hpp"
 //#include "operators/shell.hpp"
-//#include "operators/mirror.hpp"
+#include "operators/mirror.hpp"
 
 /* #endregion */
 
@@ -901,8 +1001,18 @@ case tree::op_t:: OPCODE : {\
     break;\
 }
 
+//Shared subtrees are transparent, the operation is forwarded to the referenced node.
+#define SDF_TREE_DISPATCH_REF(OPERATION, RET)\
+case tree::op_t::Ref : {\
+    tree_idx<Attrs>& ref= *(tree_idx<Attrs>*)((uint8_t*)this+*(const int32_t*)this);\
+    RET ref. OPERATION ;\
+    break;\
+}
+
 #define SDF_TREE_DISPATCH(OPERATION, RET) \
 switch(*(sdf::tree::op_t::type_t*)((uint8_t*)this-2)){\
+    SDF_TREE_DISPATCH_REF(OPERATION, RET) \
+    \
     SDF_TREE_DISPATCH_PRIMITIVE(Sphere, OPERATION, RET) \
     SDF_TREE_DISPATCH_PRIMITIVE(Box, OPERATION, RET) \
     SDF_TREE_DISPATCH_PRIMITIVE(Plane, OPERATION, RET) \
@@ -916,6 +1026,10 @@ switch(*(sdf::tree::op_t::type_t*)((uint8_t*)this-2)){\
     SDF_TREE_DISPATCH_OPERATOR1(Rotate, OPERATION, RET) \
     SDF_TREE_DISPATCH_OPERATOR1(Scale, OPERATION, RET) \
     SDF_TREE_DISPATCH_OPERATOR2(SmoothJoin, OPERATION, RET) \
+    SDF_TREE_DISPATCH_OPERATOR1(Instances, OPERATION, RET) \
+    SDF_TREE_DISPATCH_OPERATOR1(Array, OPERATION, RET) \
+    SDF_TREE_DISPATCH_OPERATOR1(CyclicArray, OPERATION, RET) \
+    SDF_TREE_DISPATCH_OPERATOR1(Mirror, OPERATION, RET) \
     default:\
     {\
         printf("Fuck you! %d %p %p",*(sdf::tree::op_t::type_t*)((uint8_t*)this-2),(void*)((uint8_t*)this-2), (const void*)this );\
@@ -929,13 +1043,21 @@ namespace sdf{
 namespace utils{
     template <typename Attrs>
     inline float tree_idx<Attrs>::sample(const glm::vec3& pos) const{
+        SDF_PROFILE_SCOPE(this);
         SDF_TREE_DISPATCH(sample(pos),return);
         return {};
     }
 
+    template <typename Attrs>
+    inline interval_t tree_idx<Attrs>::bounds(const bbox_t& box) const{
+        SDF_TREE_DISPATCH(bounds(box),return);
+        return {};
+    }
+
     template <typename Attrs>
     inline Attrs tree_idx<Attrs>::operator()(const glm::vec3& pos) const{
         //printf("[dispatch] %d, %d\n", (sdf::tree::op_t::type_t)*(uint16_t*)((uint8_t*)base+offset-2),offset);
+        SDF_PROFILE_SCOPE(this);
         SDF_TREE_DISPATCH(operator()(pos),return);
         return {};
     }
@@ -1005,12 +1127,25 @@ namespace utils{
         SDF_TREE_DISPATCH(traits(dst),);
         return;
     }
+
+    template <typename Attrs>
+    inline uint64_t tree_idx<Attrs>::to_tree(tree::builder& dst) const{
+        SDF_TREE_DISPATCH(to_tree(dst),return);
+        return 0;
+    }
+
+    template <typename Attrs>
+    inline interval_t tree_idx<Attrs>::region_bounds(tree::builder& dst) const{
+        SDF_TREE_DISPATCH(region_bounds(dst),return);
+        return {};
+    }
 }
 }
 
 #undef SDF_TREE_DISPATCH_PRIMITIVE
 #undef SDF_TREE_DISPATCH_OPERATOR2
 #undef SDF_TREE_DISPATCH_OPERATOR1
+#undef SDF_TREE_DISPATCH_REF
 #undef SDF_TREE_DISPATCH
 
 
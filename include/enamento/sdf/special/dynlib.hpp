@@ -59,6 +59,8 @@ namespace sdf{
         
             inline Attrs operator()(const glm::vec3& pos) const{return _operator(pos);};
             inline float sample(const glm::vec3& pos) const{return _sample(pos);}
+            //Libraries only export point sampling, so the field is assumed to be 1-Lipschitz.
+            inline interval_t bounds(const bbox_t& box) const{return lipschitz(_sample((box.min+box.max)/2.0f),box);}
             inline void traits(traits_t& out) const{return _traits(out);}
             inline const char* name() const{return _name();}
             inline fields_t fields() const{return _fields();}
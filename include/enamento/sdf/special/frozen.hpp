@@ -0,0 +1,182 @@
+#pragma once
+/**
+ * @file frozen.hpp
+ * @author karurochari
+ * @brief Flat copy of a tree owned by the node itself, for fast evaluation of dynamic trees on the host.
+ * @date 2025-04-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Unlike `Interpreted`, it does not need a shared slot, but it cannot be used on offloaded devices.
+ * Evaluation goes through the same switch-based dispatch of `tree_idx`, so there are no virtual calls and nodes are contiguous in memory.
+ *
+ * Copies can also be specialized for a region, dropping the branches which cannot affect it (see `tree::builder::prune`).
+ * `region_cache` keeps one such copy per octree cell or screen tile, so the cost of evaluation follows how crowded each region is.
+ */
+
+#ifndef SDF_INTERNALS
+#error "Don't import manually, this can only be used internally by the library"
+#endif
+
+#include <array>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "../sdf.hpp"
+#include "../tree.hpp"
+
+namespace sdf{
+
+    namespace configs{
+    }
+
+    namespace{namespace impl{
+        template<typename Attrs=default_attrs>
+        struct Frozen{
+            private:
+                std::shared_ptr<uint64_t[]> _data;      //uint64_t to keep the 8 bytes alignment of the builder
+                size_t _size = 0;
+
+                inline utils::tree_idx<Attrs> * handle() const{
+                    uint32_t offset;
+                    memcpy(&offset,_data.get(),4);
+                    return (utils::tree_idx<Attrs> *)((uint8_t*)_data.get()+offset);
+                }
+
+            public:
+            using attrs_t = Attrs;
+
+            Frozen(const uint8_t* tree, size_t size):_data(std::make_shared<uint64_t[]>((size+7)/8)),_size(size){
+                memcpy(_data.get(),tree,size);
+            }
+            Frozen(const tree::builder& src):Frozen(src.bytes.data(),src.bytes.size()){}
+
+            inline Attrs operator()(const glm::vec3& pos) const{return handle()->operator()(pos);};
+            inline float sample(const glm::vec3& pos) const{return handle()->sample(pos);}
+            inline interval_t bounds(const bbox_t& box) const{return handle()->bounds(box);}
+
+            inline const char* name() const{return handle()->name();}
+            inline fields_t fields() const{return handle()->fields();}
+            inline fields_t fields(const path_t* steps) const{return handle()->fields(steps);};
+            inline visibility_t is_visible() const{return visibility_t::VISIBLE;}
+            inline void traits(traits_t& out) const{return handle()->traits(out);}
+
+            inline size_t children() const{return handle()->children();}
+            inline void* addr(){return handle()->addr();}
+            inline const void* addr()const{return handle()->addr();}
+            inline bool tree_visit_pre(const visitor_t& v){return handle()->tree_visit_pre(v);}
+            inline bool tree_visit_post(const visitor_t& v){return handle()->tree_visit_post(v);}
+            inline bool ctree_visit_pre(const cvisitor_t& v) const{return handle()->ctree_visit_pre(v);}
+            inline bool ctree_visit_post(const cvisitor_t& v) const{return handle()->ctree_visit_post(v);}
+
+            //When pruning, nodes are serialized again one by one, else the whole buffer is copied as it is.
+            inline uint64_t to_tree(tree::builder& out)const{
+                if(out.prune)return handle()->to_tree(out);
+                return out.append((const uint8_t*)_data.get(),_size);
+            }
+
+            inline size_t size() const{return _size;}
+        };
+    }}
+
+    namespace comptime {
+        template <typename Attrs=default_attrs>
+        using Frozen_t = utils::primitive<Attrs,impl::Frozen>;
+        template <typename Attrs=default_attrs>
+        constexpr inline Frozen_t<Attrs> Frozen (impl::Frozen<Attrs> && ref ){
+            return ref;
+        }
+    }
+    namespace polymorphic {
+        template <typename Attrs=default_attrs>
+        using Frozen_t = utils::dyn<Attrs,impl::Frozen>;
+        template <typename Attrs=default_attrs>
+        constexpr inline Frozen_t<Attrs> Frozen (impl::Frozen<Attrs> && ref ){
+            return ref;
+        }
+    }
+    namespace dynamic {
+        template <typename Attrs=default_attrs>
+        using Frozen_t =utils::dyn<Attrs,impl::Frozen>;
+        template <typename Attrs=default_attrs>
+        constexpr inline std::shared_ptr<utils::base_dyn<Attrs>> Frozen (impl::Frozen<Attrs> && ref ){
+            std::shared_ptr<utils::base_dyn<Attrs>> tmp = utils::make_dyn<utils::dyn<Attrs,impl::Frozen>>(utils::dyn<Attrs,impl::Frozen>(ref));
+            return tmp;
+        }
+
+        /**
+         * @brief Flatten a dynamic tree for evaluation, dropping virtual dispatch and pointer chasing.
+         * Later changes to the original tree are not reflected, freeze it again if needed.
+         *
+         * @param src the root of the tree
+         * @return comptime::Frozen_t<Attrs>
+         */
+        template <typename Attrs=default_attrs>
+        inline comptime::Frozen_t<Attrs> freeze(const std::shared_ptr<utils::base_dyn<Attrs>>& src){
+            tree::builder builder;
+            builder.close(src->to_tree(builder));
+            return impl::Frozen<Attrs>(builder);
+        }
+
+        /**
+         * @brief Flatten a dynamic tree, only keeping what is needed to evaluate it inside a region.
+         * Samples taken inside `region` match the ones of the full tree, outside they are meaningless.
+         *
+         * @param src the root of the tree
+         * @param region
+         * @return comptime::Frozen_t<Attrs>
+         */
+        template <typename Attrs=default_attrs>
+        inline comptime::Frozen_t<Attrs> freeze(const std::shared_ptr<utils::base_dyn<Attrs>>& src, const bbox_t& region){
+            tree::builder builder;
+            builder.prune = true;
+            builder.region = region;
+            builder.close(src->to_tree(builder));
+            return impl::Frozen<Attrs>(builder);
+        }
+    }
+
+    /**
+     * @brief Copies of a tree specialized for regions, like the cells of an octree or the tiles of a screen.
+     * Each copy is built the first time its region is requested, and kept until the cache is destroyed or cleared.
+     * Regions are matched exactly, so callers must derive them the same way every time.
+     * Lookups can be done from multiple threads.
+     *
+     * @tparam Attrs
+     */
+    template <typename Attrs=default_attrs>
+    struct region_cache{
+        private:
+            impl::Frozen<Attrs> src;
+            std::map<std::array<float,6>,impl::Frozen<Attrs>> entries;
+            mutable std::mutex lock;
+
+        public:
+            region_cache(const impl::Frozen<Attrs>& src):src(src){}
+
+            /**
+             * @brief Tree specialized for a region, built if not already present.
+             * The reference is valid until `clear` is called.
+             */
+            const comptime::Frozen_t<Attrs>& get(const bbox_t& region){
+                std::array<float,6> key = {region.min.x,region.min.y,region.min.z,region.max.x,region.max.y,region.max.z};
+                {
+                    std::lock_guard guard(lock);
+                    auto it = entries.find(key);
+                    if(it!=entries.end())return it->second;
+                }
+                //Built outside the lock, if two threads race on the same region the first copy wins.
+                tree::builder builder;
+                builder.prune = true;
+                builder.region = region;
+                builder.close(src.to_tree(builder));
+                std::lock_guard guard(lock);
+                return entries.try_emplace(key,builder).first->second;
+            }
+
+            inline size_t size() const{std::lock_guard guard(lock);return entries.size();}
+            inline void clear(){std::lock_guard guard(lock);entries.clear();}
+    };
+
+}
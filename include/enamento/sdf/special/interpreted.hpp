@@ -49,6 +49,7 @@ namespace sdf{
             
             inline Attrs operator()(const glm::vec3& pos) const{return handle()->operator()(pos);};
             inline float sample(const glm::vec3& pos) const{return handle()->sample(pos);}
+            inline interval_t bounds(const bbox_t& box) const{return handle()->bounds(box);}
             
             inline const char* name() const{return handle()->name();}
             inline fields_t fields() const{return handle()->fields();}
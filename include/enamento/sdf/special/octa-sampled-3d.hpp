@@ -209,6 +209,9 @@ namespace sdf{
             }
             constexpr inline float sample(const glm::vec3& pos)const {return operator()(pos).distance;}
 
+            //Approximated, as the reconstruction is only close to being 1-Lipschitz.
+            constexpr inline interval_t bounds(const bbox_t& box)const {return lipschitz(sample((box.min+box.max)/2.0f),box);}
+
 
 
             constexpr inline bbox_t bbox() const{return {vec3(-size),vec3(size)};}
@@ -8,7 +8,11 @@
 #include "utils/shared.hpp"
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace sdf{
@@ -46,6 +50,15 @@ namespace op_t {
         Translate,
         
         SmoothJoin,
+
+        Instances,
+
+        Array,
+        CyclicArray,
+        Mirror,
+
+        //Special, last so that the opcodes above stay the ones written in older packed scenes
+        Ref,            //Reference to a shared subtree, as int32 jump relative to its own data
     };
 
     enum mod_t : uint16_t{
@@ -57,10 +70,46 @@ namespace op_t {
 
 struct builder{
     std::vector<uint8_t> bytes = {0,0,0,0,0,0};
-    std::map<std::pair<uint16_t,uint16_t>,uint16_t> named_refs;
+    std::vector<std::pair<const void*,uint64_t>> origins;   //Address of the source node -> offset of its serialized copy, in push order. Used to recover named references after `to_tree`.
+
+    struct stats_t{
+        size_t nodes = 0;           //Nodes visited while serializing
+        size_t shared = 0;          //Subtrees replaced by a reference
+        size_t bytes_saved = 0;
+        size_t pruned = 0;          //Operators replaced by one of their branches
+    };
+
+    ///Hash-consing of subtrees: identical subtrees are stored once, and later copies are replaced by a `Ref` node.
+    ///Only for trees which are never edited, like packed scenes: fields are written by the offset of their node (see `versioned::set`), and that would change every copy.
+    bool share_subtrees = false;
+
+    ///Specialization for a region: boolean operators are replaced by one of their branches when the other cannot affect samples taken in `region`.
+    ///While serializing, `region` is in the frame of the current node, operators map it for their children.
+    bool prune = false;
+    bbox_t region;
+    stats_t stats;
+
+    private:
+        std::unordered_map<std::string,std::pair<uint32_t,uint64_t>> subtrees;    //Structural key -> canonical id, offset of the first copy
+        std::map<uint64_t,uint32_t> canonical;                                      //Offset of a node -> canonical id of its subtree
+        std::vector<uint64_t> refs;                                                 //Offsets of the `Ref` nodes, in push order
+        uint32_t next_id = 0;
+        std::unordered_map<const void*,std::pair<bbox_t,interval_t>> bounds;       //Address of a node -> region and its bounds there, while pruning
+
+        //Drop everything written from `start` on.
+        void rollback(uint64_t start){
+            bytes.resize(start);
+            offset=bytes.size()+2;
+            canonical.erase(canonical.lower_bound(start),canonical.end());
+            while(!origins.empty() && origins.back().second>=start)origins.pop_back();
+            //References inside a subtree which is being replaced are no longer there.
+            while(!refs.empty() && refs.back()>=start){refs.pop_back();stats.shared--;}
+        }
+
+    public:
     uint64_t offset = 8;    //I must be 8 to avoid alignment issues :/. In general I must be **VERY** careful of alignment when packing this data structure.
 
-    uint64_t push(op_t::type_t opcode, const uint8_t* data, size_t len){
+    uint64_t push(op_t::type_t opcode, const uint8_t* data, size_t len, const void* origin = nullptr){
         //printf("\n%d %d - %zu : %d\n", offset%8, offset, len, opcode);
 
         //First hword is the parent address, followed by bytes of data. Return the address of the first byte of data (skip parent address)
@@ -73,18 +122,123 @@ struct builder{
         for(uint i = 0;i<len%8+8-2;i++)bytes.push_back({0xac});
         auto ret = offset;
         offset=bytes.size()+2;
+        if(origin!=nullptr)origins.emplace_back(origin,ret);
+        return ret;
+    }
+
+    /**
+     * @brief Position where the next subtree starts, to be passed to `share` once its root has been pushed.
+     */
+    uint64_t mark() const{
+        return bytes.size();
+    }
+
+    /**
+     * @brief Register the subtree which was just written, and replace it with a reference if an identical one is already present.
+     * 
+     * @param start the value of `mark()` before the subtree was written
+     * @param node the offset of its root
+     * @param key bytes of the root node, with child references zeroed
+     * @param len length of the key
+     * @param children offsets of the children of the root
+     * @return uint64_t the offset to use for the subtree, either `node` or the one of a `Ref` node
+     */
+    uint64_t share(uint64_t start, uint64_t node, const uint8_t* key, size_t len, std::initializer_list<uint64_t> children){
+        return share(start,node,key,len,children.begin(),children.size());
+    }
+
+    uint64_t share(uint64_t start, uint64_t node, const uint8_t* key, size_t len, const uint64_t* children, size_t children_n){
+        stats.nodes++;
+        if(!share_subtrees)return node;
+
+        std::string tmp;
+        tmp.reserve(2+len+children_n*4);
+        tmp.append((const char*)bytes.data()+node-2,2);
+        tmp.append((const char*)key,len);
+        for(size_t i=0;i<children_n;i++){
+            auto it = canonical.find(children[i]);
+            //Subtrees not generated via `share` cannot be compared.
+            if(it==canonical.end()){canonical[node]=next_id++;return node;}
+            tmp.append((const char*)&it->second,4);
+        }
+
+        auto [it,inserted] = subtrees.try_emplace(std::move(tmp),next_id,node);
+        if(inserted){
+            canonical[node]=next_id++;
+            return node;
+        }
+
+        //Already seen: drop the copy just written and reference the first one.
+        const void* origin = (!origins.empty() && origins.back().second==node)?origins.back().first:nullptr;
+        stats.bytes_saved+=bytes.size()-start;
+        rollback(start);
+        int32_t jump = (int64_t)it->second.second-(int64_t)next();
+        auto ret = push(op_t::Ref,(const uint8_t*)&jump,sizeof(jump),origin);
+        stats.bytes_saved-=bytes.size()-start;
+        stats.shared++;
+        refs.push_back(ret);
+        canonical[ret]=it->second.first;
         return ret;
     }
 
+    /**
+     * @brief Append a closed tree (the bytes of another builder) as a subtree.
+     * Child references are relative, so they are still valid after the copy.
+     * 
+     * @param tree 
+     * @param size 
+     * @return uint64_t the offset of the root of the appended tree.
+     */
+    uint64_t append(const uint8_t* tree, size_t size){
+        uint32_t root;
+        memcpy(&root,tree,4);
+        auto shift = bytes.size()-6;
+        bytes.insert(bytes.end(),tree+6,tree+size);
+        offset=bytes.size()+2;
+        return root+shift;
+    }
+
     void close(uint32_t root){
         //Write the offset for the first node in the first position.
         memcpy(bytes.data(),&root,4);
+        bounds.clear();
+    }
+
+    /**
+     * @brief Bounds of a node over the current `region`, if they were already computed.
+     */
+    const interval_t* cached_bounds(const void* node) const{
+        auto it = bounds.find(node);
+        if(it==bounds.end() || memcmp(&it->second.first,&region,sizeof(bbox_t))!=0)return nullptr;
+        return &it->second.second;
+    }
+
+    void cache_bounds(const void* node, const interval_t& value){
+        bounds[node]={region,value};
     }
 
     uint64_t next(){
         return offset;
     }
 
+    /**
+     * @brief Offset at which a node was serialized, if it was part of the last `to_tree`.
+     * 
+     * @param origin the value of `addr()` for the source node
+     * @return uint64_t the offset, 0 if the node was never serialized in this builder.
+     */
+    uint64_t offset_of(const void* origin) const{
+        auto it = std::find_if(origins.rbegin(),origins.rend(),[origin](auto& v){return v.first==origin;});
+        if(it==origins.rend())return 0;
+        return it->second;
+    }
+
+    uint32_t root() const{
+        uint32_t tmp;
+        memcpy(&tmp,bytes.data(),4);
+        return tmp;
+    }
+
     bool build(){
         return true;
     }
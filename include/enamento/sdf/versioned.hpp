@@ -0,0 +1,175 @@
+#pragma once
+
+/**
+ * @file versioned.hpp
+ * @author karurochari
+ * @brief Versions of a flat tree kept in a ring of shared slots, so that edits never wait for frames and frames never see half an edit.
+ * @date 2025-04-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Each version is written to a slot of `global_shared` nobody is reading, and then made current with a single atomic store.
+ * Frames take a `snapshot` when they start, and sample the slot it names until they drop it, regardless of later edits.
+ * Slots are reused once they are neither current nor held by any snapshot, so old versions are reclaimed when their last frame ends.
+ * If all slots are taken, publishing fails and the edit should be retried later, it never blocks.
+ *
+ * Only the flat tree is copied by each version, buffers it references by slot (octrees, textures...) are shared across versions.
+ * Writers are serialized among themselves, readers never lock.
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "sdf/sdf.hpp"
+
+namespace sdf{
+
+struct versioned{
+    static constexpr uint32_t MAX_SLOTS = 8;
+    static constexpr uint32_t NONE = ~0u;
+
+    private:
+        size_t first;
+        uint32_t count;
+
+        std::atomic<uint32_t> refs[MAX_SLOTS] = {};     //Snapshots holding each slot
+        std::atomic<uint32_t> current = NONE;          //Index of the slot with the latest version
+        uint64_t version_of[MAX_SLOTS] = {};           //Only written while a slot is free
+        std::atomic<uint64_t> versions = 0;
+
+        std::mutex writer;
+
+        uint32_t claim() const{
+            for(uint32_t i=0;i<count;i++){
+                if(i!=current.load() && refs[i].load()==0)return i;
+            }
+            return NONE;
+        }
+
+        bool commit(uint32_t i, const void* data, size_t size){
+            if(!global_shared.copy(first+i,{data,size}))return false;
+            version_of[i]=++versions;
+            current.store(i);
+            return true;
+        }
+
+    public:
+        struct snapshot{
+            private:
+                versioned* owner = nullptr;
+                uint32_t idx = NONE;
+
+                snapshot(versioned* owner, uint32_t idx):owner(owner),idx(idx){}
+                friend versioned;
+
+            public:
+                snapshot() = default;
+                snapshot(const snapshot&) = delete;
+                snapshot& operator=(const snapshot&) = delete;
+                snapshot(snapshot&& o):owner(o.owner),idx(o.idx){o.owner=nullptr;o.idx=NONE;}
+                snapshot& operator=(snapshot&& o){
+                    if(this!=&o){release();owner=o.owner;idx=o.idx;o.owner=nullptr;o.idx=NONE;}
+                    return *this;
+                }
+                ~snapshot(){release();}
+
+                void release(){
+                    if(owner!=nullptr)owner->refs[idx].fetch_sub(1);
+                    owner=nullptr;idx=NONE;
+                }
+
+                inline bool valid() const{return owner!=nullptr;}
+                ///Slot of `global_shared` to sample, as in `Interpreted_t(slot())`
+                inline size_t slot() const{assert(valid());return owner->first+idx;}
+                inline uint64_t version() const{assert(valid());return owner->version_of[idx];}
+        };
+
+        /**
+         * @brief Manage the slots from `first` to `first+count`. The previous content of those slots is not preserved.
+         */
+        versioned(size_t first, uint32_t count=3):first(first),count(count<MAX_SLOTS?count:MAX_SLOTS){
+            if(count<2)throw "TooFewSlots";
+        }
+
+        versioned(const versioned&) = delete;
+
+        /**
+         * @brief Hold the current version. Cheap enough to be done at the start of each frame.
+         *
+         * @return snapshot not valid if nothing was published yet
+         */
+        snapshot acquire(){
+            for(;;){
+                auto i = current.load();
+                if(i==NONE)return {};
+                refs[i].fetch_add(1);
+                //The writer only reuses slots which are not current, so if it still is the slot was not touched.
+                if(current.load()==i)return {this,i};
+                refs[i].fetch_sub(1);
+            }
+        }
+
+        /**
+         * @brief Make a new version out of a whole flat tree.
+         *
+         * @return true on success
+         * @return false if all slots are still in use, or the copy failed
+         */
+        bool publish(const uint8_t* data, size_t size){
+            std::lock_guard lock(writer);
+            auto i = claim();
+            if(i==NONE)return false;
+            return commit(i,data,size);
+        }
+
+        bool publish(const tree::builder& builder){
+            return publish(builder.bytes.data(),builder.bytes.size());
+        }
+
+        /**
+         * @brief Make a new version by changing a copy of the current one.
+         *
+         * @param op receives the copy and its size, and returns false to discard it
+         * @return true on success
+         * @return false if nothing was published yet, `op` discarded the edit, or all slots are still in use
+         */
+        bool edit(const std::function<bool(uint8_t*,size_t)>& op){
+            std::lock_guard lock(writer);
+            auto c = current.load();
+            if(c==NONE)return false;
+            auto i = claim();
+            if(i==NONE)return false;
+            //The current slot is never rewritten, and only writers replace it.
+            auto view = global_shared[first+c];
+            std::vector<uint8_t> bytes((const uint8_t*)view.base,(const uint8_t*)view.base+view.size);
+            if(!op(bytes.data(),bytes.size()))return false;
+            return commit(i,bytes.data(),bytes.size());
+        }
+
+        /**
+         * @brief Make a new version with one field of a node changed.
+         *
+         * @param node offset of the node in the tree, as recorded by the builder or the node table of packed scenes
+         * @param field as listed by the `fields()` of the node
+         * @param value `field.length` bytes
+         */
+        bool set(size_t node, const field_t& field, const void* value){
+            if(field.readonly)return false;
+            if(field.validate!=nullptr && !field.validate(value))return false;
+            return edit([&](uint8_t* bytes, size_t size){
+                if(node+field.offset+field.length>size)return false;
+                memcpy(bytes+node+field.offset,value,field.length);
+                return true;
+            });
+        }
+
+        ///Number of versions published so far
+        inline uint64_t version() const{return versions.load();}
+};
+
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+/**
+ * @file contacts.hpp
+ * @author karurochari
+ * @brief Contacts between two SDF objects, each placed in the world by its own rigid transform.
+ * @date 2025-04-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Contacts are searched in the overlap of the bounding boxes of the two objects, via an octree refined only where the objects can touch.
+ * Cells are dropped as soon as the interval bounds of either SDF prove it is away from that object, or that one SDF is always above the other.
+ * What is left are the cells crossing the surface where both SDF are equal, inside or close to both objects, so the work scales with the area of contact and not with the volume of the objects.
+ *
+ * Each leaf projects its centre on that surface and reports it, with the direction separating the objects and how deep they penetrate each other there.
+ * Leaves are visited in parallel, in tiles like for mesh extraction, and the output order is deterministic.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <omp.h>
+#include <vector>
+
+#include "sdf/sdf.hpp"
+
+namespace solver{
+namespace collision{
+
+using namespace glm;
+
+/**
+ * @brief Rigid transform from the space of an object to the world.
+ */
+struct pose_t{
+    mat3 rotation = mat3(1.0f);
+    vec3 translation = {0,0,0};
+
+    inline vec3 to_world(const vec3& p) const{return rotation*p+translation;}
+    inline vec3 to_local(const vec3& p) const{return transpose(rotation)*(p-translation);}
+};
+
+struct contact_t{
+    vec3    position;               //In the world, halfway between the two surfaces
+    vec3    normal;                 //From the first object towards the second
+    float   depth;                  //Penetration, negative if the surfaces are apart but within the margin
+};
+
+struct config_t{
+    float       resolution = 0.05f; //Upper limit for the size of the leaves, and so for the spacing of the contacts
+    float       margin = 0.0f;      //Surfaces closer than this are reported as touching
+    uint32_t    tiles_depth = 3;    //Level of the octree at which work is split across threads
+};
+
+struct stats_t{
+    size_t contacts = 0;
+    size_t cells = 0;               //Octree cells bounded, leaves included
+    size_t leaves = 0;              //Leaves sampled
+};
+
+template <sdf::sdf_i A, sdf::sdf_i B>
+struct detector{
+    private:
+        const A&    a;
+        const B&    b;
+        pose_t      pa, pb;
+        mat3        ia, ib;         //Inverse rotations
+        vec3        origin;
+        float       leaf;
+        uint32_t    depth;
+        float       margin;
+        uint32_t    tiles_depth;
+        bool        overlap = true; //False if the bounding boxes are apart
+
+        inline float sample_a(const vec3& p) const{return a.sample(ia*(p-pa.translation));}
+        inline float sample_b(const vec3& p) const{return b.sample(ib*(p-pb.translation));}
+
+        //Gradients of the difference of the two SDF, in the world.
+        inline vec3 gradient(const vec3& p, float h) const{
+            auto d = [&](const vec3& o){return (sample_a(p+o)-sample_b(p+o))-(sample_a(p-o)-sample_b(p-o));};
+            return vec3(d({h,0,0}),d({0,h,0}),d({0,0,h}))/(2.0f*h);
+        }
+
+        inline vec3 normal(const vec3& p, float h) const{
+            auto d = [&](const vec3& o){return sample_a(p+o)-sample_a(p-o);};
+            auto e = [&](const vec3& o){return sample_b(p+o)-sample_b(p-o);};
+            auto n = vec3(d({h,0,0}),d({0,h,0}),d({0,0,h}))-vec3(e({h,0,0}),e({0,h,0}),e({0,0,h}));
+            auto len = length(n);
+            return len>0.0f?n/len:vec3{0,0,0};
+        }
+
+        inline vec3 at(const uvec3& c) const{return origin+leaf*vec3(c);}
+
+        //Cells are identified by the coordinates of their lower corner on the grid of the leaves.
+        inline bool empty(const uvec3& c, uint32_t level, float margin) const{
+            uint32_t span = 1u<<(depth-level);
+            sdf::bbox_t cell = {at(c),at(c+span)};
+            auto la = a.bounds(sdf::transform(cell,ia,-(ia*pa.translation)));
+            if(la.min>margin)return true;
+            auto lb = b.bounds(sdf::transform(cell,ib,-(ib*pb.translation)));
+            if(lb.min>margin)return true;
+            //One of the two is always above the other, so the cell cannot hold the surface between them.
+            return la.min>lb.max || lb.min>la.max;
+        }
+
+        bool sample(const uvec3& c, float margin, contact_t& out) const{
+            float half = leaf/2.0f;
+            auto centre = at(c)+half;
+            auto p = centre;
+            float h = leaf*1e-2f;
+            //Newton step on the difference of the two SDF, towards the surface where they are equal.
+            for(int i=0;i<2;i++){
+                auto g = gradient(p,h);
+                auto len2 = dot(g,g);
+                if(len2==0.0f)return false;
+                p-=g*((sample_a(p)-sample_b(p))/len2);
+            }
+            //Contacts landing in a neighbour are reported by the neighbour.
+            if(any(greaterThan(abs(p-centre),vec3(half))))return false;
+            float da = sample_a(p), db = sample_b(p);
+            if(glm::max(da,db)>margin)return false;
+            out = {p,normal(p,h),-(da+db)};
+            return true;
+        }
+
+        void visit(const uvec3& c, uint32_t level, float margin, std::vector<contact_t>& out, stats_t& stats) const{
+            stats.cells++;
+            if(empty(c,level,margin))return;
+            if(level==depth){
+                stats.leaves++;
+                contact_t contact;
+                if(sample(c,margin,contact))out.push_back(contact);
+                return;
+            }
+            uint32_t half = 1u<<(depth-level-1);
+            for(uint32_t i=0;i<8;i++){
+                visit(c+half*uvec3{i&1,(i>>1)&1,(i>>2)&1},level+1,margin,out,stats);
+            }
+        }
+
+        struct tile_t{
+            uvec3       c;
+            uint32_t    level;
+        };
+
+        void tiles(const uvec3& c, uint32_t level, uint32_t target, float margin, std::vector<tile_t>& out, stats_t& stats) const{
+            if(level==target){out.push_back({c,level});return;}
+            stats.cells++;
+            if(empty(c,level,margin))return;
+            uint32_t half = 1u<<(depth-level-1);
+            for(uint32_t i=0;i<8;i++){
+                tiles(c+half*uvec3{i&1,(i>>1)&1,(i>>2)&1},level+1,target,margin,out,stats);
+            }
+        }
+
+    public:
+        detector(const A& a, const pose_t& pa, const B& b, const pose_t& pb, const config_t& cfg = {}):a(a),b(b),pa(pa),pb(pb),margin(cfg.margin),tiles_depth(cfg.tiles_depth){
+            ia = transpose(pa.rotation);
+            ib = transpose(pb.rotation);
+
+            sdf::traits_t ta, tb;
+            a.traits(ta);
+            b.traits(tb);
+            auto ba = sdf::transform(ta.outer_box,pa.rotation,pa.translation);
+            auto bb = sdf::transform(tb.outer_box,pb.rotation,pb.translation);
+            if(any(isinf(ba.min)) || any(isinf(ba.max)) || any(isinf(bb.min)) || any(isinf(bb.max))){
+                throw "Contacts require objects with a finite bounding box";
+            }
+            sdf::bbox_t box = {glm::max(ba.min,bb.min)-cfg.margin,glm::min(ba.max,bb.max)+cfg.margin};
+            if(any(greaterThan(box.min,box.max))){
+                overlap=false;
+                box.max=box.min;
+            }
+
+            auto extent = box.max-box.min;
+            float side = glm::max(extent.x,glm::max(extent.y,extent.z))+2.0f*cfg.resolution;
+            depth = side>cfg.resolution?(uint32_t)std::ceil(std::log2(side/cfg.resolution)):0;
+            leaf = cfg.resolution;
+            origin = (box.min+box.max)/2.0f-leaf*std::exp2((float)depth)/2.0f;
+        }
+
+        inline uint32_t levels() const{return depth;}
+
+        /**
+         * @brief Search all contacts, appending them to `out`.
+         *
+         * @param out
+         * @return stats_t
+         */
+        stats_t run(std::vector<contact_t>& out) const{
+            stats_t stats;
+            if(!overlap)return stats;
+
+            std::vector<tile_t> work;
+            tiles({0,0,0},0,std::min(tiles_depth,depth),margin,work,stats);
+
+            std::vector<std::vector<contact_t>> buffers(work.size());
+            size_t cells = 0, leaves = 0;
+
+            #pragma omp parallel for schedule(dynamic,1) reduction(+:cells,leaves)
+            for(size_t i=0;i<work.size();i++){
+                stats_t local;
+                visit(work[i].c,work[i].level,margin,buffers[i],local);
+                cells+=local.cells;
+                leaves+=local.leaves;
+            }
+
+            stats.cells+=cells;
+            stats.leaves+=leaves;
+            for(auto& buffer: buffers){
+                out.insert(out.end(),buffer.begin(),buffer.end());
+                stats.contacts+=buffer.size();
+            }
+            return stats;
+        }
+};
+
+/**
+ * @brief Contacts between two objects.
+ *
+ * @param a any SDF with a finite bounding box
+ * @param pa placement of `a` in the world
+ * @param b any SDF with a finite bounding box
+ * @param pb placement of `b` in the world
+ * @param out contacts are appended here
+ * @param cfg
+ * @return stats_t
+ */
+template <sdf::sdf_i A, sdf::sdf_i B>
+inline stats_t contacts(const A& a, const pose_t& pa, const B& b, const pose_t& pb, std::vector<contact_t>& out, const config_t& cfg = {}){
+    return detector<A,B>(a,pa,b,pb,cfg).run(out);
+}
+
+}
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+/**
+ * @file extract.hpp
+ * @author karurochari
+ * @brief Extraction of a triangle mesh from any SDF, driven by an octree to only visit cells close to the surface.
+ * @date 2025-04-17
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Cells are pruned as soon as the distance sampled at their centre proves no surface can cross them,
+ * so this relies on the SDF being at least a lower bound of the real distance.
+ * Leaves share the same size, and are polygonized via marching tetrahedra. The split of each cube is the same everywhere, so the mesh is free of cracks.
+ *
+ * The volume is split in tiles which are processed in parallel, each with its own triangle buffer.
+ * Buffers are handed over to the sink in tile order, a batch at a time, so the output is deterministic and the full mesh is never held in memory.
+ *
+ * Optionally, each tile is evaluated on a copy of the tree specialized for its region, where the branches which cannot reach it are dropped.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <omp.h>
+#include <span>
+#include <vector>
+
+#include "sdf/sdf.hpp"
+#include "utils/jobs.hpp"
+
+namespace solver{
+namespace mesh{
+
+using namespace glm;
+
+struct triangle_t{
+    vec3 normal;
+    vec3 v[3];
+};
+
+struct config_t{
+    sdf::bbox_t box;                //Region to extract, if not finite the bounding box of the SDF is used
+    float       resolution = 0.05f; //Upper limit for the size of the leaves
+    uint32_t    tiles_depth = 3;    //Level of the octree at which work is split across threads
+    uint32_t    batch = 0;          //Tiles processed before flushing to the sink, if zero four per thread
+    bool        prune = false;      //Specialize the tree for each tile. It must be serializable via `to_tree`, and it pays off on large scenes
+};
+
+struct stats_t{
+    size_t triangles = 0;
+    size_t cells = 0;               //Octree cells sampled, leaves included
+    size_t leaves = 0;              //Leaves polygonized
+};
+
+/**
+ * @brief Sink which only counts triangles, for benchmarks and dry runs.
+ */
+struct counter_t{
+    size_t triangles = 0;
+    inline bool write(std::span<const triangle_t> data){triangles+=data.size();return true;}
+};
+
+template <sdf::sdf_i SDF>
+struct extractor{
+    private:
+        const SDF&  sdf;
+        vec3        origin;
+        float       size;           //Side of the root cube
+        float       leaf;           //Side of the leaves
+        uint32_t    depth;          //Level of the leaves
+
+        //Tetrahedra splitting a cube along its 0-7 diagonal. Corners are indexed with bits x=1, y=2, z=4.
+        constexpr static inline int tetras[6][4] = {{0,1,3,7},{0,3,2,7},{0,2,6,7},{0,6,4,7},{0,4,5,7},{0,5,1,7}};
+
+        constexpr static inline vec3 crossing(const vec3& a, float da, const vec3& b, float db){
+            return a+(b-a)*(da/(da-db));
+        }
+
+        //Emit a triangle facing away from the inner region, which is on the side opposite to `outward`.
+        static inline void emit(std::vector<triangle_t>& out, const vec3& a, const vec3& b, const vec3& c, const vec3& outward){
+            auto n = cross(b-a,c-a);
+            auto len = length(n);
+            //Degenerate triangles are kept, as dropping them would open holes in the connectivity with the neighbours.
+            if(len==0.0f){out.push_back({{0,0,0},{a,b,c}});return;}
+            if(dot(n,outward)<0.0f)out.push_back({-n/len,{a,c,b}});
+            else out.push_back({n/len,{a,b,c}});
+        }
+
+        static void tetra(std::vector<triangle_t>& out, const vec3* p, const float* d){
+            int in[4], outs[4], n_in = 0, n_out = 0;
+            for(int i=0;i<4;i++){
+                if(d[i]<0.0f)in[n_in++]=i;
+                else outs[n_out++]=i;
+            }
+            if(n_in==0 || n_out==0)return;
+
+            vec3 outward = {0,0,0};
+            for(int i=0;i<n_out;i++)outward+=p[outs[i]];
+            outward/=(float)n_out;
+            {
+                vec3 inner = {0,0,0};
+                for(int i=0;i<n_in;i++)inner+=p[in[i]];
+                outward-=inner/(float)n_in;
+            }
+
+            auto e = [&](int a, int b){return crossing(p[a],d[a],p[b],d[b]);};
+            if(n_in==1)emit(out,e(in[0],outs[0]),e(in[0],outs[1]),e(in[0],outs[2]),outward);
+            else if(n_in==3)emit(out,e(in[0],outs[0]),e(in[1],outs[0]),e(in[2],outs[0]),outward);
+            else{
+                //Quad, with vertices in cyclic order.
+                auto q0 = e(in[0],outs[0]), q1 = e(in[0],outs[1]), q2 = e(in[1],outs[1]), q3 = e(in[1],outs[0]);
+                emit(out,q0,q1,q2,outward);
+                emit(out,q0,q2,q3,outward);
+            }
+        }
+
+        //Positions are always derived from integer coordinates on the grid of the leaves, so corners shared by cells match exactly.
+        inline vec3 at(const uvec3& c) const{return origin+leaf*vec3(c);}
+
+        template<typename S>
+        void polygonize(const S& sdf, const uvec3& c, std::vector<triangle_t>& out) const{
+            vec3 p[8];
+            float d[8];
+            bool in = false, outside = false;
+            for(uint32_t i=0;i<8;i++){
+                p[i] = at(c+uvec3{i&1,(i>>1)&1,(i>>2)&1});
+                d[i] = sdf.sample(p[i]);
+                in|=d[i]<0.0f;
+                outside|=d[i]>=0.0f;
+            }
+            if(!in || !outside)return;
+
+            for(auto& t : tetras){
+                vec3 tp[4] = {p[t[0]],p[t[1]],p[t[2]],p[t[3]]};
+                float td[4] = {d[t[0]],d[t[1]],d[t[2]],d[t[3]]};
+                tetra(out,tp,td);
+            }
+        }
+
+        //Cells are identified by the coordinates of their lower corner on the grid of the leaves.
+        template<typename S>
+        inline bool empty(const S& sdf, const uvec3& c, uint32_t level) const{
+            uint32_t span = 1u<<(depth-level);
+            float half = leaf*span/2.0f;
+            return abs(sdf.sample(at(c)+half))>half*std::numbers::sqrt3_v<float>;
+        }
+
+        template<typename S>
+        void visit(const S& sdf, const uvec3& c, uint32_t level, std::vector<triangle_t>& out, stats_t& stats) const{
+            stats.cells++;
+            if(empty(sdf,c,level))return;
+            if(level==depth){
+                stats.leaves++;
+                polygonize(sdf,c,out);
+                return;
+            }
+            uint32_t half = 1u<<(depth-level-1);
+            for(uint32_t i=0;i<8;i++){
+                visit(sdf,c+half*uvec3{i&1,(i>>1)&1,(i>>2)&1},level+1,out,stats);
+            }
+        }
+
+        struct tile_t{
+            uvec3       c;
+            uint32_t    level;
+        };
+
+        void tiles(const uvec3& c, uint32_t level, uint32_t target, std::vector<tile_t>& out, stats_t& stats) const{
+            if(level==target){out.push_back({c,level});return;}
+            stats.cells++;
+            if(empty(sdf,c,level))return;
+            uint32_t half = 1u<<(depth-level-1);
+            for(uint32_t i=0;i<8;i++){
+                tiles(c+half*uvec3{i&1,(i>>1)&1,(i>>2)&1},level+1,target,out,stats);
+            }
+        }
+
+    public:
+        extractor(const SDF& sdf, const config_t& cfg):sdf(sdf){
+            auto box = cfg.box;
+            if(any(isinf(box.min)) || any(isinf(box.max))){
+                sdf::traits_t traits;
+                sdf.traits(traits);
+                box = traits.outer_box;
+            }
+            if(any(isinf(box.min)) || any(isinf(box.max))){
+                throw "Mesh extraction requires a finite region";
+            }
+            //One leaf of padding on each side, or surfaces touching the box would be left open.
+            auto extent = box.max-box.min;
+            float side = glm::max(extent.x,glm::max(extent.y,extent.z))+2.0f*cfg.resolution;
+            depth = side>cfg.resolution?(uint32_t)std::ceil(std::log2(side/cfg.resolution)):0;
+            leaf = cfg.resolution;
+            size = leaf*std::exp2((float)depth);
+            //Centred, with a small offset so that the grid is unlikely to hit symmetric features exactly on the corners.
+            origin = (box.min+box.max)/2.0f-size/2.0f+cfg.resolution*1e-3f;
+        }
+
+        inline uint32_t levels() const{return depth;}
+        inline float leaf_size() const{return leaf;}
+
+        /**
+         * @brief Extract the mesh, passing triangles to the sink as they are ready.
+         *
+         * @param sink anything with `bool write(std::span<const triangle_t>)`, called from a single thread
+         * @param cfg the same configuration used to build the extractor
+         * @param status if set, progress is reported there in tiles, and cancellation is checked for each tile
+         * @return stats_t of the triangles written so far, if cancelled
+         */
+        template<typename Sink>
+        stats_t run(Sink& sink, const config_t& cfg = {}, jobs::status_t* status = nullptr) const{
+            stats_t stats;
+            std::vector<tile_t> work;
+            tiles({0,0,0},0,std::min(cfg.tiles_depth,depth),work,stats);
+            if(status!=nullptr)status->expect(work.size());
+
+            size_t batch = cfg.batch!=0?cfg.batch:4*omp_get_max_threads();
+            std::vector<std::vector<triangle_t>> buffers(batch);
+
+            for(size_t start=0;start<work.size();start+=batch){
+                if(status!=nullptr && status->cancelled())return stats;
+                size_t end = std::min(start+batch,work.size());
+                size_t cells = 0, leaves = 0;
+
+                #pragma omp parallel for schedule(dynamic,1) reduction(+:cells,leaves)
+                for(size_t i=start;i<end;i++){
+                    stats_t local;
+                    auto& buffer = buffers[i-start];
+                    buffer.clear();
+                    if(status!=nullptr && status->cancelled())continue;
+                    auto& tile = work[i];
+                    if(cfg.prune){
+                        //Corners of the cells are sampled too, so the region is the closed cube of the tile.
+                        sdf::tree::builder builder;
+                        builder.prune = true;
+                        builder.region = {at(tile.c),at(tile.c+uvec3(1u<<(depth-tile.level)))};
+                        builder.close(sdf.to_tree(builder));
+                        visit(sdf::comptime::Frozen_t<typename SDF::attrs_t>(builder),tile.c,tile.level,buffer,local);
+                    }
+                    else visit(sdf,tile.c,tile.level,buffer,local);
+                    cells+=local.cells;
+                    leaves+=local.leaves;
+                }
+
+                stats.cells+=cells;
+                stats.leaves+=leaves;
+                for(size_t i=start;i<end;i++){
+                    auto& buffer = buffers[i-start];
+                    stats.triangles+=buffer.size();
+                    if(!buffer.empty() && !sink.write(buffer))return stats;
+                }
+                if(status!=nullptr)status->advance(end-start);
+            }
+            return stats;
+        }
+};
+
+/**
+ * @brief Extract the surface of an SDF into a sink.
+ *
+ * @param sdf any SDF, comptime, dynamic, `Interpreted` or sampled
+ * @param sink anything with `bool write(std::span<const triangle_t>)`
+ * @param cfg
+ * @param status optional, for progress and cancellation
+ * @return stats_t
+ */
+template <sdf::sdf_i SDF, typename Sink>
+inline stats_t extract(const SDF& sdf, Sink& sink, const config_t& cfg = {}, jobs::status_t* status = nullptr){
+    return extractor<SDF>(sdf,cfg).run(sink,cfg,status);
+}
+
+}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+/**
+ * @file writers.hpp
+ * @author karurochari
+ * @brief Streaming sinks for `extract`, writing binary STL or PLY files.
+ * @date 2025-04-17
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Triangles are written as they arrive, and the counts in the headers are patched when the file is closed.
+ * The PLY output is a triangle soup, with three vertices per face and no welding.
+ */
+
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+
+#include "extract.hpp"
+
+namespace solver{
+namespace mesh{
+
+struct stl_writer{
+    private:
+        FILE*       fd = nullptr;
+        uint32_t    count = 0;
+
+    public:
+        stl_writer(const char* path){
+            fd = fopen(path,"wb");
+            if(fd==nullptr)return;
+            uint8_t header[80] = {};
+            strncpy((char*)header,"enamento",sizeof(header));
+            fwrite(header,sizeof(header),1,fd);
+            fwrite(&count,sizeof(count),1,fd);
+        }
+
+        stl_writer(const stl_writer&) = delete;
+        stl_writer& operator=(const stl_writer&) = delete;
+
+        ~stl_writer(){close();}
+
+        inline bool valid() const{return fd!=nullptr;}
+
+        bool write(std::span<const triangle_t> data){
+            if(fd==nullptr)return false;
+            for(auto& t : data){
+                //Records are 50 bytes, normal and vertices as float32 followed by an unused attribute.
+                float record[12] = {
+                    t.normal.x,t.normal.y,t.normal.z,
+                    t.v[0].x,t.v[0].y,t.v[0].z,
+                    t.v[1].x,t.v[1].y,t.v[1].z,
+                    t.v[2].x,t.v[2].y,t.v[2].z,
+                };
+                uint16_t attribute = 0;
+                if(fwrite(record,sizeof(record),1,fd)!=1 || fwrite(&attribute,sizeof(attribute),1,fd)!=1)return false;
+            }
+            count+=data.size();
+            return true;
+        }
+
+        bool close(){
+            if(fd==nullptr)return false;
+            bool ok = fseek(fd,80,SEEK_SET)==0 && fwrite(&count,sizeof(count),1,fd)==1;
+            ok&=fclose(fd)==0;
+            fd=nullptr;
+            return ok;
+        }
+};
+
+struct ply_writer{
+    private:
+        FILE*       fd = nullptr;
+        size_t      count = 0;
+        long        counts_at[2];
+
+        //Counts are printed with a fixed width, so that they can be overwritten in place.
+        constexpr static inline int WIDTH = 12;
+
+    public:
+        ply_writer(const char* path){
+            fd = fopen(path,"wb");
+            if(fd==nullptr)return;
+            fprintf(fd,"ply\nformat binary_%s_endian 1.0\ncomment enamento\nelement vertex ",std::endian::native==std::endian::little?"little":"big");
+            counts_at[0]=ftell(fd);
+            fprintf(fd,"%0*zu\nproperty float x\nproperty float y\nproperty float z\nelement face ",WIDTH,(size_t)0);
+            counts_at[1]=ftell(fd);
+            fprintf(fd,"%0*zu\nproperty list uchar uint vertex_indices\nend_header\n",WIDTH,(size_t)0);
+        }
+
+        ply_writer(const ply_writer&) = delete;
+        ply_writer& operator=(const ply_writer&) = delete;
+
+        ~ply_writer(){close();}
+
+        inline bool valid() const{return fd!=nullptr;}
+
+        //Only vertices are streamed. Face i is always made of vertices 3i, 3i+1 and 3i+2, so faces are appended by `close`.
+        bool write(std::span<const triangle_t> data){
+            if(fd==nullptr)return false;
+            for(auto& t : data){
+                if(fwrite(t.v,sizeof(t.v),1,fd)!=1)return false;
+            }
+            count+=data.size();
+            return true;
+        }
+
+        bool close(){
+            if(fd==nullptr)return false;
+            bool ok = true;
+            for(size_t i=0;i<count && ok;i++){
+                uint8_t n = 3;
+                uint32_t face[3] = {(uint32_t)(3*i),(uint32_t)(3*i+1),(uint32_t)(3*i+2)};
+                ok&=fwrite(&n,sizeof(n),1,fd)==1 && fwrite(face,sizeof(face),1,fd)==1;
+            }
+            ok&=fseek(fd,counts_at[0],SEEK_SET)==0 && fprintf(fd,"%0*zu",WIDTH,count*3)==WIDTH;
+            ok&=fseek(fd,counts_at[1],SEEK_SET)==0 && fprintf(fd,"%0*zu",WIDTH,count)==WIDTH;
+            ok&=fclose(fd)==0;
+            fd=nullptr;
+            return ok;
+        }
+};
+
+}
+}
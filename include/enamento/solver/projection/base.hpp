@@ -11,6 +11,7 @@
  */
 
 #include "sdf/commons.hpp"
+#include "sampler/occupancy.hpp"
 
 
 namespace solver{
@@ -29,6 +30,7 @@ struct base_camera_t{
 struct screen_camera_t:base_camera_t{
     int canvas_width, canvas_height;
     float resolution_scale = 1.0;
+    uint32_t sample = 0;        //Progressive refinement of a still view: 0 for a new frame, then the index of each supersample accumulated over it
 };
 
 //TODO: add arg to define if the source SDF is assumed to be exact,bounded or neither. It will switch a bit the logic of the ray caster.
@@ -43,10 +45,15 @@ struct base{
     vec3 sun_pos = {0,5,6};
     vec4 sky = {1.0,0.9,0.9,1.0};
 
+    //Shared slot of an occupancy grid for the scene (see `sampler::occupancy`), used to skip empty space while marching. Disabled if negative.
+    int occupancy = -1;
+
     base(const SDF& sdf,const vec3& camera_pos):sdf(sdf){camera.pos=camera_pos;}
     base(const SDF& sdf):sdf(sdf){}
 
     constexpr static int MAX_STEPS = 500;
+    //Budget of samples for each ray, rays running out of it are reported as misses. It can be raised when there is time to spare.
+    int max_steps = MAX_STEPS;
     constexpr static float MAX_DIST = 300;
     constexpr static float SURFACE_DIST = sdf::EPS;
 
@@ -65,13 +72,27 @@ struct base{
 
     //Reduced version to avoid spending too much space on useless args.
     std::pair<float, uint> march_schnell(vec3 ro, vec3 rd, float d0=0.0f){
+        const sampler::occupancy::header_t* grid = nullptr;
+        if(occupancy>=0)grid=(const sampler::occupancy::header_t*)global_shared[occupancy].base;
+        return march_schnell(ro,rd,d0,grid);
+    }
+
+    //Steps are only counted for samples of the SDF, jumps across empty cells of the grid are free.
+    //Rays going past `limit` are misses, with a distance of infinity.
+    std::pair<float, uint> march_schnell(vec3 ro, vec3 rd, float d0, const sampler::occupancy::header_t* grid, float limit = MAX_DIST){
         int i=0;
-        for(;i<MAX_STEPS;i++){
+        float dS = 0.0f;
+        for(;i<max_steps;i++){
+            //Steps longer than a cell already cross empty space quickly enough.
+            if(grid!=nullptr && dS<grid->cell_size){
+                d0=sampler::occupancy::skip(grid,ro,rd,d0,limit);
+                if(d0>limit) {d0=INFINITY;i=max_steps;break;}
+            }
             vec3 p = ro+d0*rd;
-            auto dS = sdf.sample(p);
+            dS = sdf.sample(p);
             d0+=dS;
             if(abs(dS)<SURFACE_DIST) break;
-            if(d0>MAX_DIST) {d0=INFINITY;i=MAX_STEPS;break;}
+            if(d0>limit) {d0=INFINITY;i=max_steps;break;}
         }
         return {d0,i};
     }
@@ -79,12 +100,12 @@ struct base{
     //TODO: stop when the sampled value is smaller compared to the radius of the cone at that point.
     std::pair<float, uint> march_cone_schnell(vec3 ro, vec3 rd, float r, float d0=0.0f){
         int i=0;
-        for(;i<MAX_STEPS;i++){
+        for(;i<max_steps;i++){
             vec3 p = ro+d0*rd;
             auto dS = sdf.sample(p);
             if(abs(dS)<d0*r) break;
             else d0+=dS;
-            if(d0>MAX_DIST) {d0=INFINITY;i=MAX_STEPS;break;}
+            if(d0>MAX_DIST) {d0=INFINITY;i=max_steps;break;}
         }
         return {d0,i};
     }
@@ -127,6 +148,171 @@ struct base{
         return march_cone_schnell(ro,rd,radius, hint);
     }
 
+    //Direction of the primary ray through a point of the screen.
+    vec3 direction(vec2 uv){
+        uv.y=-uv.y;
+        vec3 rd = normalize(vec3(uv * (camera.zoom+1.0f),1));
+
+        {auto rot = rot2D(-camera.rot.y);auto td = rd.yz()*rot;rd.y=td.x;rd.z=td.y;}
+        {auto rot = rot2D(-camera.rot.x);auto td = rd.xz()*rot;rd.x=td.x;rd.z=td.y;}
+        {auto rot = rot2D(-camera.rot.z);auto td = rd.xy()*rot;rd.x=td.x;rd.y=td.y;}
+        return rd;
+    }
+
+    constexpr static uint LANES = 4;    //Rays marched in lockstep once a packet has been split down to them
+
+    /**
+     * @brief March rays in lockstep, one lane each, with the same logic of `march_schnell`.
+     * Lanes which are done are masked, so the body of the loop maps onto SIMD units when the SDF allows it.
+     *
+     * @param ro shared origin
+     * @param rd directions
+     * @param t in input the starting distance of each ray, in output the hit one
+     * @param steps in input the samples already spent on each ray, in output the total
+     * @param grid occupancy grid to skip empty space, if any
+     */
+    void march_lanes(vec3 ro, const vec3* rd, float* t, uint* steps, const sampler::occupancy::header_t* grid = nullptr){
+        bool active[LANES];
+        float dS[LANES];
+        for(uint l=0;l<LANES;l++){active[l]=true;dS[l]=0.0f;}
+        for(int i=0;i<max_steps;i++){
+            //Jumps are done lane by lane out of the SIMD body, as in `march_schnell` only while steps are shorter than a cell.
+            if(grid!=nullptr){
+                for(uint l=0;l<LANES;l++){
+                    if(!active[l] || dS[l]>=grid->cell_size)continue;
+                    t[l]=sampler::occupancy::skip(grid,ro,rd[l],t[l],MAX_DIST);
+                    if(t[l]>MAX_DIST){t[l]=INFINITY;steps[l]=max_steps;active[l]=false;}
+                }
+            }
+            bool running = false;
+            #pragma omp simd reduction(||:running)
+            for(uint l=0;l<LANES;l++){
+                if(!active[l])continue;
+                dS[l] = sdf.sample(ro+t[l]*rd[l]);
+                t[l]+=dS[l];
+                if(abs(dS[l])<SURFACE_DIST)active[l]=false;
+                else if(t[l]>MAX_DIST){t[l]=INFINITY;steps[l]=max_steps;active[l]=false;}
+                else steps[l]++;
+                running|=active[l];
+            }
+            if(!running)break;
+        }
+    }
+
+    /**
+     * @brief March a square packet of N×N coherent rays sharing the same origin, like neighbouring primary rays.
+     * The packet is marched as a single cone enclosing all its rays, for as long as its cross-section is free.
+     * When the cone gets close to a surface it is split in four, down to groups of `LANES` rays marched by `march_lanes`.
+     * The result of each ray is the same of `march_schnell` within `SURFACE_DIST`, while far fewer samples are needed in open space.
+     *
+     * @tparam N side of the packet, a power of two
+     * @param ro shared origin
+     * @param rd directions, N×N in row major order
+     * @param out distance and steps for each ray, in the same order. Steps of the cone are counted for each ray taking part in it.
+     * @param grid occupancy grid to skip empty space, if any. It is only used once the packet is split down to lanes.
+     */
+    template<uint N>
+    void march_packet_schnell(vec3 ro, const vec3* rd, std::pair<float,uint>* out, const sampler::occupancy::header_t* grid = nullptr){
+        static_assert(N>=2 && (N&(N-1))==0, "Packets must have a side which is a power of two");
+
+        struct node_t{uint x, y, side; float t; uint steps;};
+        node_t stack[3*N+1];
+        uint top = 0;
+        stack[top++]={0,0,N,0.0f,0};
+
+        while(top>0){
+            auto node = stack[--top];
+            auto at = [&](uint x, uint y)->const vec3&{return rd[(node.y+y)*N+node.x+x];};
+
+            if(node.side*node.side<=LANES){
+                vec3 dirs[LANES];
+                float t[LANES];
+                uint steps[LANES];
+                for(uint l=0;l<LANES;l++){
+                    //Lanes beyond the packet repeat its first ray.
+                    uint k = l<node.side*node.side?l:0;
+                    dirs[l]=at(k%node.side,k/node.side);
+                    t[l]=node.t;
+                    steps[l]=node.steps;
+                }
+                march_lanes(ro,dirs,t,steps,grid);
+                for(uint k=0;k<node.side*node.side;k++){
+                    out[(node.y+k/node.side)*N+node.x+k%node.side]={t[k],steps[k]};
+                }
+                continue;
+            }
+
+            //Cone around the central direction. Rays are within the convex hull of the corners, so those bound its aperture.
+            uint last = node.side-1;
+            vec3 axis = normalize(at(0,0)+at(last,0)+at(0,last)+at(last,last));
+            float k = 0.0f;
+            for(auto& c : {at(0,0),at(last,0),at(0,last),at(last,last)})k=glm::max(k,length(c-axis));
+
+            //At distance s, each ray is within s*k from the axis. So the ball of radius d around the axis at t covers them up to (d+t)/(1+k).
+            bool split = false;
+            for(;node.steps<max_steps;node.steps++){
+                auto dS = sdf.sample(ro+node.t*axis);
+                if(dS<=2.0f*node.t*k+SURFACE_DIST){split=true;break;}
+                node.t=(dS+node.t)/(1.0f+k);
+                if(node.t>MAX_DIST)break;
+            }
+
+            if(!split){
+                //All rays missed, or gave up.
+                for(uint y=0;y<node.side;y++)for(uint x=0;x<node.side;x++){
+                    out[(node.y+y)*N+node.x+x]={node.t>MAX_DIST?INFINITY:node.t,(uint)max_steps};
+                }
+                continue;
+            }
+
+            uint half = node.side/2;
+            for(uint i=0;i<4;i++)stack[top++]={node.x+(i&1)*half,node.y+(i>>1)*half,half,node.t,node.steps};
+        }
+    }
+
+    /**
+     * @brief Render a packet of N×N pixels, as `render` does for each of them.
+     *
+     * @tparam N side of the packet, a power of two
+     * @param uv position on screen of the first pixel
+     * @param duv distance between neighbouring pixels
+     * @param out N×N results in row major order
+     */
+    template<uint N>
+    void render_packet(vec2 uv, float duv, output_t* out){
+        vec3 ro = camera.pos;
+        vec3 rd[N*N];
+        std::pair<float,uint> res[N*N];
+        for(uint y=0;y<N;y++)for(uint x=0;x<N;x++)rd[y*N+x]=direction(uv+duv*vec2(x,y));
+        const sampler::occupancy::header_t* grid = nullptr;
+        if(occupancy>=0)grid=(const sampler::occupancy::header_t*)global_shared[occupancy].base;
+        march_packet_schnell<N>(ro,rd,res,grid);
+
+        for(uint i=0;i<N*N;i++){
+            auto [d,steps] = res[i];
+            //Not infinity or it breaks computation of sobel there.
+            if(d>MAX_DIST){out[i]={SDF::attrs_t::SKY(),MAX_DIST,{0,0,0},steps};continue;}
+            auto tmp = sdf(ro+d*rd[i]);
+            out[i]={{tmp.fields},d,tmp.normals,steps};
+        }
+    }
+
+    /**
+     * @brief As `render`, but rays give up past `limit`, like the depth of a layer already rendered in front of this one.
+     * Misses are reported as sky, with a depth of `MAX_DIST`.
+     */
+    output_t render_bounded(vec2 uv, float limit){
+        const sampler::occupancy::header_t* grid = nullptr;
+        if(occupancy>=0)grid=(const sampler::occupancy::header_t*)global_shared[occupancy].base;
+
+        vec3 ro = camera.pos;
+        vec3 rd = direction(uv);
+        auto [d,i] = march_schnell(ro,rd,0.0f,grid,glm::min(limit,MAX_DIST));
+        if(d>MAX_DIST)return {SDF::attrs_t::SKY(),MAX_DIST,{0,0,0},i};
+        auto tmp = sdf(ro+d*rd);
+        return {{tmp.fields},d,tmp.normals,i};
+    }
+
     output_t render(vec2 uv, float hint = 0.0f){
         uv.y=-uv.y;
         vec3 rd = normalize(vec3(uv * (camera.zoom+1.0f),1));
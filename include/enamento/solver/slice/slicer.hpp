@@ -0,0 +1,286 @@
+#pragma once
+
+/**
+ * @file slicer.hpp
+ * @author karurochari
+ * @brief Slicing of any SDF into planar layers of closed contours, as needed for 3D printing.
+ * @date 2025-04-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Each layer is the plane `z=const`, explored by a quadtree which drops cells that the sampled distance proves empty.
+ * Leaves are polygonized by marching squares, and segments are chained into loops by the grid edge they cross, so no tolerance is involved.
+ * The inner region is always on the left of contours: outer boundaries are counter-clockwise and holes are clockwise.
+ *
+ * Layers are processed in parallel, and passed to the sink in order a batch at a time.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <omp.h>
+#include <unordered_map>
+#include <vector>
+
+#include "sdf/commons.hpp"
+
+namespace solver{
+namespace slice{
+
+using namespace glm;
+
+struct contour_t{
+    std::vector<vec2>   points;
+    float               area = 0;       //Signed, negative for holes
+    bool                closed = true;  //False if the chain was broken, which only happens if the SDF is not a bound of the real distance
+
+    inline bool hole() const{return area<0.0f;}
+};
+
+struct layer_t{
+    uint32_t                index;
+    float                   z;
+    std::vector<contour_t>  contours;
+};
+
+struct config_t{
+    sdf::bbox_t box;                    //Region to slice, if not finite the bounding box of the SDF is used
+    float       layer_height = 0.2f;
+    float       resolution = 0.025f;    //Upper limit for the size of the leaves on the XY plane
+    uint32_t    batch = 0;              //Layers processed before flushing to the sink, if zero two per thread
+};
+
+struct stats_t{
+    size_t layers = 0;
+    size_t contours = 0;
+    size_t segments = 0;
+    size_t cells = 0;                   //Quadtree cells sampled, leaves included
+};
+
+/**
+ * @brief Sink which only counts, for benchmarks and dry runs.
+ */
+struct counter_t{
+    size_t layers = 0;
+    size_t points = 0;
+    inline bool write(const layer_t& layer){
+        layers++;
+        for(auto& contour : layer.contours)points+=contour.points.size();
+        return true;
+    }
+};
+
+template <sdf::sdf_i SDF>
+struct slicer{
+    private:
+        const SDF&  sdf;
+        vec2        origin;
+        float       leaf;               //Side of the leaves
+        uint32_t    depth;              //Level of the leaves
+        float       z0;
+        uint32_t    count;              //Number of layers
+
+        struct segment_t{
+            uint64_t    from;
+            uint64_t    to;
+            vec2        point;          //Position of `from`
+        };
+
+        struct context_t{
+            float                   z;
+            std::vector<segment_t>  segments;
+            size_t                  cells = 0;
+        };
+
+        //Grid edges are identified by the grid corner they start from and their direction, 0 along X and 1 along Y.
+        constexpr static inline uint64_t key(uint32_t x, uint32_t y, uint32_t dir){return ((uint64_t)x<<33)|((uint64_t)y<<1)|dir;}
+
+        inline vec2 at(const uvec2& c) const{return origin+leaf*vec2(c);}
+
+        inline float sample(const vec2& p, float z) const{return sdf.sample({p.x,p.y,z});}
+
+        void polygonize(const uvec2& c, context_t& ctx) const{
+            //Corners and edges counter-clockwise, starting from the lower left corner.
+            const uvec2 corners[4] = {c,c+uvec2{1,0},c+uvec2{1,1},c+uvec2{0,1}};
+            const uint64_t edges[4] = {key(c.x,c.y,0),key(c.x+1,c.y,1),key(c.x,c.y+1,0),key(c.x,c.y,1)};
+
+            vec2 p[4];
+            float d[4];
+            uint32_t inside = 0;
+            for(int i=0;i<4;i++){
+                p[i]=at(corners[i]);
+                d[i]=sample(p[i],ctx.z);
+                if(d[i]<0.0f)inside|=1u<<i;
+            }
+            if(inside==0 || inside==0xf)return;
+
+            //Crossings along the boundary, in counter-clockwise order.
+            struct crossing_t{uint64_t edge; vec2 point; bool leaving;};
+            crossing_t crossings[4];
+            int n = 0;
+            for(int i=0;i<4;i++){
+                int j = (i+1)%4;
+                bool in_i = inside&(1u<<i), in_j = inside&(1u<<j);
+                if(in_i==in_j)continue;
+                //Interpolated starting from the lower corner on the grid, so both cells sharing the edge get the same point.
+                constexpr int lower[4] = {0,1,3,0}, upper[4] = {1,2,2,3};
+                int a = lower[i], b = upper[i];
+                crossings[n++]={edges[i],p[a]+(p[b]-p[a])*(d[a]/(d[a]-d[b])),in_i};
+            }
+
+            if(n==2){
+                auto& from = crossings[0].leaving?crossings[0]:crossings[1];
+                auto& to = crossings[0].leaving?crossings[1]:crossings[0];
+                ctx.segments.push_back({from.edge,to.edge,from.point});
+            }
+            else{
+                //Saddle, the centre decides if the inner corners are connected.
+                bool connected = sample(at(c)+leaf/2.0f,ctx.z)<0.0f;
+                for(int i=0;i<4;i++){
+                    if(!crossings[i].leaving)continue;
+                    auto& to = crossings[(i+(connected?1:3))%4];
+                    ctx.segments.push_back({crossings[i].edge,to.edge,crossings[i].point});
+                }
+            }
+        }
+
+        void visit(const uvec2& c, uint32_t level, context_t& ctx) const{
+            ctx.cells++;
+            uint32_t span = 1u<<(depth-level);
+            float half = leaf*span/2.0f;
+            if(abs(sample(at(c)+half,ctx.z))>half*std::numbers::sqrt2_v<float>)return;
+            if(level==depth){
+                polygonize(c,ctx);
+                return;
+            }
+            span/=2;
+            for(uint32_t i=0;i<4;i++){
+                visit(c+span*uvec2{i&1,(i>>1)&1},level+1,ctx);
+            }
+        }
+
+        static void chain(const std::vector<segment_t>& segments, std::vector<contour_t>& out){
+            std::unordered_map<uint64_t,uint32_t> starts;
+            starts.reserve(segments.size());
+            for(uint32_t i=0;i<segments.size();i++)starts.emplace(segments[i].from,i);
+
+            std::vector<bool> used(segments.size(),false);
+            for(uint32_t i=0;i<segments.size();i++){
+                if(used[i])continue;
+                contour_t contour;
+                uint32_t current = i;
+                for(;;){
+                    used[current]=true;
+                    contour.points.push_back(segments[current].point);
+                    auto it = starts.find(segments[current].to);
+                    if(it==starts.end()){contour.closed=false;break;}
+                    current = it->second;
+                    if(current==i)break;
+                    if(used[current]){contour.closed=false;break;}
+                }
+                for(size_t k=0;k<contour.points.size();k++){
+                    auto& a = contour.points[k];
+                    auto& b = contour.points[(k+1)%contour.points.size()];
+                    contour.area+=(a.x*b.y-b.x*a.y)/2.0f;
+                }
+                out.push_back(std::move(contour));
+            }
+        }
+
+    public:
+        slicer(const SDF& sdf, const config_t& cfg):sdf(sdf){
+            auto box = cfg.box;
+            if(any(isinf(box.min)) || any(isinf(box.max))){
+                sdf::traits_t traits;
+                sdf.traits(traits);
+                box = traits.outer_box;
+            }
+            if(any(isinf(box.min)) || any(isinf(box.max))){
+                throw "Slicing requires a finite region";
+            }
+            //One leaf of padding on each side, or contours touching the box would be left open.
+            auto extent = vec2(box.max-box.min);
+            float side = glm::max(extent.x,extent.y)+2.0f*cfg.resolution;
+            depth = side>cfg.resolution?(uint32_t)std::ceil(std::log2(side/cfg.resolution)):0;
+            leaf = cfg.resolution;
+            origin = (vec2(box.min)+vec2(box.max))/2.0f-leaf*std::exp2((float)depth)/2.0f+leaf*1e-3f;
+
+            //Layers are sampled in the middle of their thickness.
+            count = (uint32_t)glm::max(std::ceil((box.max.z-box.min.z)/cfg.layer_height),1.0f);
+            z0 = box.min.z+cfg.layer_height/2.0f;
+        }
+
+        inline uint32_t layers() const{return count;}
+        inline float leaf_size() const{return leaf;}
+
+        /**
+         * @brief Slice a single plane.
+         *
+         * @param z height of the plane
+         * @param out where contours are appended
+         * @return stats_t
+         */
+        stats_t plane(float z, std::vector<contour_t>& out) const{
+            context_t ctx;
+            ctx.z=z;
+            visit({0,0},0,ctx);
+            size_t before = out.size();
+            chain(ctx.segments,out);
+            return {1,out.size()-before,ctx.segments.size(),ctx.cells};
+        }
+
+        /**
+         * @brief Slice all layers, passing them to the sink in order.
+         *
+         * @param sink anything with `bool write(const layer_t&)`, called from a single thread
+         * @param cfg the same configuration used to build the slicer
+         * @return stats_t
+         */
+        template<typename Sink>
+        stats_t run(Sink& sink, const config_t& cfg = {}) const{
+            stats_t stats;
+            size_t batch = cfg.batch!=0?cfg.batch:2*omp_get_max_threads();
+            std::vector<layer_t> buffers(batch);
+            std::vector<stats_t> partial(batch);
+
+            for(size_t start=0;start<count;start+=batch){
+                size_t end = std::min(start+batch,(size_t)count);
+
+                #pragma omp parallel for schedule(dynamic,1)
+                for(size_t i=start;i<end;i++){
+                    auto& layer = buffers[i-start];
+                    layer.index=i;
+                    layer.z=z0+i*cfg.layer_height;
+                    layer.contours.clear();
+                    partial[i-start]=plane(layer.z,layer.contours);
+                }
+
+                for(size_t i=start;i<end;i++){
+                    auto& local = partial[i-start];
+                    stats.layers+=local.layers;
+                    stats.contours+=local.contours;
+                    stats.segments+=local.segments;
+                    stats.cells+=local.cells;
+                    if(!sink.write(buffers[i-start]))return stats;
+                }
+            }
+            return stats;
+        }
+};
+
+/**
+ * @brief Slice an SDF into layers.
+ *
+ * @param sdf any SDF, comptime, dynamic, `Interpreted` or sampled
+ * @param sink anything with `bool write(const layer_t&)`
+ * @param cfg
+ * @return stats_t
+ */
+template <sdf::sdf_i SDF, typename Sink>
+inline stats_t slice(const SDF& sdf, Sink& sink, const config_t& cfg = {}){
+    return slicer<SDF>(sdf,cfg).run(sink,cfg);
+}
+
+}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * @file writers.hpp
+ * @author karurochari
+ * @brief Streaming sinks for `slice`.
+ * @date 2025-04-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <cstdio>
+#include <string>
+
+#include "slicer.hpp"
+
+namespace solver{
+namespace slice{
+
+/**
+ * @brief One SVG file per layer, named `<prefix><index>.svg`. Coordinates are kept as they are, with Y pointing up.
+ */
+struct svg_writer{
+    private:
+        std::string prefix;
+        sdf::bbox_t box;
+
+    public:
+        svg_writer(const char* prefix, const sdf::bbox_t& box):prefix(prefix),box(box){}
+
+        bool write(const layer_t& layer){
+            char path[32];
+            snprintf(path,sizeof(path),"%05u.svg",layer.index);
+            FILE* fd = fopen((prefix+path).c_str(),"w");
+            if(fd==nullptr)return false;
+
+            auto extent = box.max-box.min;
+            fprintf(fd,"<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"%f %f %f %f\">\n",box.min.x,-box.max.y,extent.x,extent.y);
+            fprintf(fd,"<!-- layer %u, z=%f -->\n<path fill-rule=\"evenodd\" transform=\"scale(1,-1)\" d=\"",layer.index,layer.z);
+            for(auto& contour : layer.contours){
+                for(size_t i=0;i<contour.points.size();i++){
+                    fprintf(fd,"%c%f %f ",i==0?'M':'L',contour.points[i].x,contour.points[i].y);
+                }
+                if(contour.closed)fprintf(fd,"Z ");
+            }
+            fprintf(fd,"\"/>\n</svg>\n");
+            return fclose(fd)==0;
+        }
+};
+
+}
+}
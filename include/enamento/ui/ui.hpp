@@ -18,7 +18,13 @@
 #include <SDL3/SDL_render.h>
 #include <SDL3/SDL_keycode.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
 
 #include <cstdlib>
 #include <print>
@@ -26,6 +32,8 @@
 #include "solver/projection/base.hpp"
 
 #include "utils/time-series.hpp"
+#include "utils/trace.hpp"
+#include "utils/triple-buffer.hpp"
 
 struct App{
     using camera_t = solver::projection::screen_camera_t;
@@ -34,7 +42,8 @@ struct App{
 
     enum struct commander_action_t {SELECT, HIDE, SHOW};  //TODO: Maybe consider moving it out in case other things will require actions later on
 
-    typedef std::function<int(const camera_t&, void* buffer)> render_t;
+    //Called on the render thread. `cancel` is raised when the frame is no longer needed, and it can be dropped early.
+    typedef std::function<int(const camera_t&, void* buffer, const std::atomic<bool>& cancel)> render_t;
     typedef std::function<glm::vec3(const camera_t&, const glm::vec2& point)> caster_t;
     typedef std::function<bool(uint64_t,commander_action_t)> commander_t;
 
@@ -86,6 +95,9 @@ struct App{
 
     int run(scene_t scene, uint fps=30);
 
+    //Render again even if the camera did not move, to be called when the scene changes.
+    inline void refresh(){refresh_pending=true;}
+
     ~App();
 
     private:
@@ -99,11 +111,48 @@ struct App{
 
         void resize(int width, int height);
 
+        void start_worker(const render_t& render);
+        void stop_worker();
+        void submit(const camera_t& camera, uint64_t input_ns);
+        std::optional<glm::vec3> raycast(const scene_t& scene, const glm::vec2& point, bool wait);
+
         SDL_Window*     window = nullptr;
         SDL_Renderer*   renderer = nullptr;
         SDL_Texture*    texture = nullptr;
-        uint8_t*        buffer = nullptr;
         int             width, height;
+
+        struct frame_t{
+            std::vector<uint8_t> pixels;
+            camera_t    camera;
+            uint64_t    input_ns = 0;   //Earliest input not yet on screen when the frame was submitted, 0 if none
+            uint64_t    start_ns = 0;
+            uint64_t    done_ns = 0;
+        };
+
+        //Frames are rendered on their own thread, so that a slow frame does not hold back the UI.
+        //The UI submits the camera when it changes, and presents the latest completed frame.
+        //While nothing changes, the same view is rendered again as refinements of the first frame (see `screen_camera_t::sample`).
+        struct worker_t{
+            std::thread             thread;
+            std::mutex              mtx;            //Guards the submission
+            std::condition_variable cv;
+            camera_t                camera;
+            uint64_t                input_ns = 0;
+            uint64_t                generation = 0;
+            camera_t                in_flight;
+            bool                    rendering = false;
+            bool                    quit = false;
+
+            std::mutex              busy;           //Held while rendering, as the scene cannot be raycast at the same time
+            std::atomic<bool>       cancel = false;
+            std::atomic<int>        error = 0;
+            triple_buffer<frame_t>  frames;
+
+            //Supersamples accumulated while the view is still, after which the thread sleeps. Zero to disable refinement.
+            std::atomic<uint32_t>   refine = 16;
+        }worker;
+
+        std::atomic<bool> refresh_pending = true;
         
         bool            ready = false;
 
@@ -123,8 +172,15 @@ struct App{
             ScrollingBuffer<2048> fps;
             ScrollingBuffer<2048> fps_avg;
             ScrollingBuffer<2048> resdiv;
+            ScrollingBuffer<2048> latency;     //From the input to the frame showing it, in ms
             size_t frames = 0;
 
+            //Breakdown of the last frame presented, from the trace.
+            uint64_t frame_ns = 0;
+            uint32_t sample = 0;                //Refinement of the frame on screen
+            std::vector<std::pair<const char*,uint64_t>> passes;
+            std::vector<std::pair<const char*,uint64_t>> transfers;
+
         }stats;
 };
 
@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ * @file arena.hpp
+ * @author karurochari
+ * @brief Bump allocator for transient data, which is released all at once.
+ * @date 2025-04-13
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/**
+ * @brief Memory is taken from large blocks, and only given back when the arena is reset or destroyed.
+ * Destructors of objects allocated in here are never called, so only use it for trivially destructible data,
+ * or via `arena_allocator` with containers which are dropped before the arena itself.
+ * Allocations made via `arena_allocator` are counted until deallocated, and releasing the arena while any is left is asserted against.
+ */
+struct arena{
+    private:
+        struct block_t{
+            block_t* next;
+            size_t   size;
+            size_t   used;
+            alignas(std::max_align_t) uint8_t data[];
+        };
+
+        block_t* head = nullptr;
+        size_t   block_size;
+        size_t   total = 0;
+        size_t   live = 0;     //Allocations of `arena_allocator` not deallocated yet
+
+        template<typename> friend struct arena_allocator;
+
+        //Blocks linked behind the head are only kept to be released, allocations always go to the head.
+        block_t* make_block(size_t size, bool behind = false){
+            auto block = (block_t*)malloc(sizeof(block_t)+size);
+            if(block==nullptr)throw std::bad_alloc();
+            block->size=size;
+            block->used=0;
+            if(behind && head!=nullptr){
+                block->next=head->next;
+                head->next=block;
+            }
+            else{
+                block->next=head;
+                head=block;
+            }
+            return block;
+        }
+
+    public:
+        arena(size_t block_size = 1<<20):block_size(block_size){}
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        ~arena(){
+            assert(live==0);
+            release();
+        }
+
+        void* alloc(size_t size, size_t align = alignof(std::max_align_t)){
+            if(head!=nullptr){
+                size_t start = (head->used+align-1)/align*align;
+                if(start+size<=head->size){
+                    head->used=start+size;
+                    total+=size;
+                    return head->data+start;
+                }
+            }
+            //Oversized requests get their own block behind the current one, which can still be used.
+            bool oversized = size+align>block_size;
+            auto block = make_block(oversized?size+align:block_size,oversized);
+            size_t start = (align-(uintptr_t)block->data%align)%align;
+            block->used=start+size;
+            total+=size;
+            return block->data+start;
+        }
+
+        template<typename T, typename... Args>
+        T* make(Args&&... args){
+            return new (alloc(sizeof(T),alignof(T))) T(static_cast<Args&&>(args)...);
+        }
+
+        //Drop all blocks but the last one allocated, which is recycled.
+        void reset(){
+            assert(live==0);
+            if(head==nullptr)return;
+            auto keep = head;
+            head=head->next;
+            release();
+            head=keep;
+            head->next=nullptr;
+            head->used=0;
+            total=0;
+        }
+
+        void release(){
+            while(head!=nullptr){
+                auto next = head->next;
+                free(head);
+                head=next;
+            }
+            total=0;
+        }
+
+        inline size_t used() const{return total;}
+        ///Objects allocated via `arena_allocator` which are still alive, like nodes of dynamic trees
+        inline size_t alive() const{return live;}
+};
+
+/**
+ * @brief Allocator to use an arena with standard containers. Deallocation gives no memory back, it only updates the count of live allocations.
+ */
+template<typename T>
+struct arena_allocator{
+    using value_type = T;
+
+    arena* src;
+
+    arena_allocator(arena& src):src(&src){}
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& other):src(other.src){}
+
+    inline T* allocate(size_t n){src->live++;return (T*)src->alloc(sizeof(T)*n,alignof(T));}
+    inline void deallocate(T*, size_t){src->live--;}
+
+    template<typename U>
+    inline bool operator==(const arena_allocator<U>& other) const{return src==other.src;}
+};
@@ -0,0 +1,312 @@
+#pragma once
+
+/**
+ * @file jobs.hpp
+ * @author karurochari
+ * @brief Pool of background threads for long operations like baking, compiling and meshing, with progress, cancellation and priorities.
+ * @date 2025-04-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Each worker owns a queue for each priority, and takes from its own queue first, then steals from the others, always starting from the highest priority.
+ * Jobs submitted from within a job end up in the queue of the worker running it.
+ *
+ * Jobs are free to open OpenMP parallel regions, the pool only owns a few threads to feed them.
+ * `omp_threads` caps the team of the regions started by jobs, so that they do not oversubscribe the cores used for rendering.
+ *
+ * A job is split in two steps. `run` does the work on a worker, and reports progress and checks for cancellation via `status_t`.
+ * `publish` moves the result where it is used, like a slot of `global_shared`, and it is only called by `flush`.
+ * This way results are exposed from a thread and at a time chosen by the application, like the render thread between two frames.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <omp.h>
+#include <thread>
+#include <vector>
+
+#include "trace.hpp"
+
+namespace jobs{
+
+/**
+ * @brief Shared by an operation and whoever is watching it. Long operations accept an optional pointer to one.
+ */
+struct status_t{
+    std::atomic<bool>     cancel = false;
+    std::atomic<uint64_t> done = 0;
+    std::atomic<uint64_t> total = 0;            //Zero if not known (yet)
+
+    inline bool cancelled() const{return cancel.load(std::memory_order_relaxed);}
+    inline void expect(uint64_t n){total.store(n,std::memory_order_relaxed);}
+    inline void advance(uint64_t n=1){done.fetch_add(n,std::memory_order_relaxed);}
+
+    inline float progress() const{
+        auto t = total.load(std::memory_order_relaxed);
+        return t==0?0.0f:(float)done.load(std::memory_order_relaxed)/t;
+    }
+};
+
+enum class priority_t : uint8_t{
+    HIGH, NORMAL, LOW
+};
+
+enum class state_t : uint8_t{
+    QUEUED,
+    RUNNING,
+    READY,          //Done running, waiting for `flush` to publish it
+    DONE,
+    CANCELLED,
+    FAILED,
+};
+
+namespace internal{
+    struct job_t : status_t{
+        std::function<bool(status_t&)> run;
+        std::function<bool()> publish;
+        priority_t priority;
+
+        std::atomic<state_t> state = state_t::QUEUED;
+        const char* error = nullptr;
+
+        std::mutex mtx;
+        std::condition_variable cv;
+
+        void finish(state_t s){
+            {
+                std::lock_guard lock(mtx);
+                state.store(s);
+            }
+            cv.notify_all();
+        }
+    };
+
+    struct queue_t{
+        std::mutex mtx;
+        std::deque<std::shared_ptr<job_t>> items[3];
+        std::shared_ptr<job_t> running;     //Job being run by the worker owning the queue
+    };
+}
+
+/**
+ * @brief Handle to a submitted job. Dropping it does not cancel the job.
+ */
+struct job{
+    private:
+        std::shared_ptr<internal::job_t> ptr;
+
+    public:
+        job() = default;
+        job(const std::shared_ptr<internal::job_t>& ptr):ptr(ptr){}
+
+        inline bool valid() const{return ptr!=nullptr;}
+        inline state_t state() const{return ptr->state.load();}
+        inline float progress() const{return ptr->progress();}
+        ///Message thrown by the job, if it failed with one
+        inline const char* error() const{return ptr->error;}
+
+        ///The job stops at its next check, or is dropped if not started or not published yet.
+        inline void cancel(){ptr->cancel.store(true);}
+
+        ///Block until the job is no longer queued or running. Publication still needs a `flush`.
+        inline state_t wait() const{
+            std::unique_lock lock(ptr->mtx);
+            ptr->cv.wait(lock,[&]{return ptr->state.load()>=state_t::READY;});
+            return ptr->state.load();
+        }
+
+        inline bool finished() const{return ptr->state.load()>=state_t::DONE;}
+};
+
+struct pool{
+    private:
+        std::vector<std::thread> workers;
+        std::unique_ptr<internal::queue_t[]> queues;
+        int omp_threads;
+
+        std::mutex mtx;                 //Guards the sleep of the workers
+        std::condition_variable cv;
+        std::atomic<size_t> pending = 0;
+        std::atomic<size_t> next = 0;   //Queue for jobs submitted from outside the pool
+        bool quit = false;
+
+        std::mutex ready_mtx;
+        std::vector<std::shared_ptr<internal::job_t>> ready;
+
+        static inline thread_local const pool* current_pool = nullptr;
+        static inline thread_local size_t current_worker = 0;
+
+        std::shared_ptr<internal::job_t> take(size_t self){
+            for(int p=0;p<3;p++){
+                //Own queue from the back, as the latest jobs are the most likely to be warm.
+                {
+                    auto& q = queues[self];
+                    std::lock_guard lock(q.mtx);
+                    if(!q.items[p].empty()){
+                        auto ret = std::move(q.items[p].back());
+                        q.items[p].pop_back();
+                        return ret;
+                    }
+                }
+                //Others from the front.
+                for(size_t i=1;i<workers.size();i++){
+                    auto& q = queues[(self+i)%workers.size()];
+                    std::lock_guard lock(q.mtx);
+                    if(!q.items[p].empty()){
+                        auto ret = std::move(q.items[p].front());
+                        q.items[p].pop_front();
+                        return ret;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        void execute(const std::shared_ptr<internal::job_t>& item){
+            if(item->cancelled()){item->finish(state_t::CANCELLED);return;}
+            item->state.store(state_t::RUNNING);
+            bool ok = false;
+            {
+                trace::scope _trace("job","jobs");
+                try{ok = item->run(*item);}
+                catch(const char* e){item->error=e;}
+                catch(...){item->error="UnknownError";}
+            }
+            if(item->cancelled())item->finish(state_t::CANCELLED);
+            else if(!ok)item->finish(state_t::FAILED);
+            else if(!item->publish)item->finish(state_t::DONE);
+            else{
+                {
+                    std::lock_guard lock(ready_mtx);
+                    ready.push_back(item);
+                }
+                item->finish(state_t::READY);
+            }
+        }
+
+        void loop(size_t self){
+            current_pool = this;
+            current_worker = self;
+            if(omp_threads>0)omp_set_num_threads(omp_threads);
+            for(;;){
+                {
+                    std::unique_lock lock(mtx);
+                    cv.wait(lock,[&]{return quit || pending.load()>0;});
+                    if(quit)return;
+                }
+                auto item = take(self);
+                //Another worker got it first.
+                if(item==nullptr)continue;
+                pending--;
+                {
+                    std::lock_guard lock(queues[self].mtx);
+                    queues[self].running = item;
+                }
+                {
+                    //The pool started closing before the job was recorded as running, so it was not cancelled.
+                    std::lock_guard lock(mtx);
+                    if(quit)item->cancel.store(true);
+                }
+                execute(item);
+                {
+                    std::lock_guard lock(queues[self].mtx);
+                    queues[self].running = nullptr;
+                }
+            }
+        }
+
+    public:
+        /**
+         * @param threads workers in the pool
+         * @param omp_threads threads of the OpenMP regions opened by jobs, if zero the default is kept
+         */
+        pool(size_t threads = std::max(1u,std::thread::hardware_concurrency()/4), int omp_threads = 0):omp_threads(omp_threads){
+            if(threads==0)threads=1;
+            queues = std::make_unique<internal::queue_t[]>(threads);
+            workers.reserve(threads);
+            for(size_t i=0;i<threads;i++)workers.emplace_back([this,i](){loop(i);});
+        }
+
+        pool(const pool&) = delete;
+
+        /**
+         * @brief Cancel queued and running jobs, and wait for the running ones to stop. Results not flushed yet are dropped.
+         */
+        ~pool(){
+            {
+                std::lock_guard lock(mtx);
+                quit = true;
+            }
+            for(size_t i=0;i<workers.size();i++){
+                std::lock_guard lock(queues[i].mtx);
+                for(auto& items : queues[i].items)
+                    for(auto& item : items){item->cancel.store(true);item->finish(state_t::CANCELLED);}
+                if(queues[i].running!=nullptr)queues[i].running->cancel.store(true);
+            }
+            cv.notify_all();
+            for(auto& worker : workers)worker.join();
+            for(auto& item : ready)item->finish(state_t::CANCELLED);
+        }
+
+        /**
+         * @brief Queue a job.
+         *
+         * @param run does the work, returning false or throwing on failure. It should check `cancelled()` often and report its progress.
+         * @param publish if set, called by `flush` once `run` succeeded, returning false on failure
+         * @param priority
+         * @return job
+         */
+        job submit(std::function<bool(status_t&)>&& run, std::function<bool()>&& publish = {}, priority_t priority = priority_t::NORMAL){
+            auto item = std::make_shared<internal::job_t>();
+            item->run = std::move(run);
+            item->publish = std::move(publish);
+            item->priority = priority;
+
+            size_t target = current_pool==this?current_worker:next++%workers.size();
+            {
+                std::lock_guard lock(queues[target].mtx);
+                queues[target].items[(int)priority].push_back(item);
+            }
+            {
+                std::lock_guard lock(mtx);
+                pending++;
+            }
+            cv.notify_one();
+            return item;
+        }
+
+        /**
+         * @brief Publish the results of jobs which are done running, on the calling thread.
+         *
+         * @return size_t jobs published
+         */
+        size_t flush(){
+            std::vector<std::shared_ptr<internal::job_t>> items;
+            {
+                std::lock_guard lock(ready_mtx);
+                items.swap(ready);
+            }
+            size_t count = 0;
+            for(auto& item : items){
+                if(item->cancelled()){item->finish(state_t::CANCELLED);continue;}
+                bool ok = false;
+                try{ok = item->publish();}
+                catch(const char* e){item->error=e;}
+                catch(...){item->error="UnknownError";}
+                item->finish(ok?state_t::DONE:state_t::FAILED);
+                count+=ok;
+            }
+            return count;
+        }
+
+        inline size_t threads() const{return workers.size();}
+        ///Jobs waiting for a worker
+        inline size_t queued() const{return pending.load();}
+};
+
+}
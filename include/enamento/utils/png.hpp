@@ -0,0 +1,196 @@
+#pragma once
+
+/**
+ * @file png.hpp
+ * @author karurochari
+ * @brief Minimal encoder for 8 bit grayscale and color PNG images, with no external dependencies.
+ * @date 2025-04-19
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Compression only uses runs (deflate matches at distance 1) coded with the fixed Huffman table.
+ * It is far from optimal for generic images, but masks made of long runs of the same value shrink to a few bytes per run, and it is fast.
+ * Color rows are stored as differences from the pixel on their left, so flat regions become runs of zeros as well.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace png{
+
+namespace impl{
+    inline uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0){
+        static const auto table = [](){
+            struct{uint32_t v[256];} t;
+            for(uint32_t n=0;n<256;n++){
+                uint32_t c = n;
+                for(int k=0;k<8;k++)c = (c&1)?0xedb88320u^(c>>1):c>>1;
+                t.v[n]=c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for(size_t i=0;i<size;i++)crc = table.v[(crc^data[i])&0xff]^(crc>>8);
+        return ~crc;
+    }
+
+    struct bit_writer{
+        std::vector<uint8_t>& out;
+        uint32_t buffer = 0;
+        int bits = 0;
+
+        //Values are packed starting from the least significant bit.
+        inline void put(uint32_t value, int n){
+            buffer|=value<<bits;
+            bits+=n;
+            while(bits>=8){
+                out.push_back(buffer&0xff);
+                buffer>>=8;
+                bits-=8;
+            }
+        }
+
+        //Huffman codes are stored starting from the most significant bit.
+        inline void code(uint32_t value, int n){
+            uint32_t reversed = 0;
+            for(int i=0;i<n;i++)reversed|=((value>>i)&1)<<(n-1-i);
+            put(reversed,n);
+        }
+
+        inline void flush(){
+            if(bits>0)out.push_back(buffer&0xff);
+            buffer=0;bits=0;
+        }
+    };
+
+    inline void literal(bit_writer& w, uint32_t v){
+        if(v<144)w.code(0x30+v,8);
+        else if(v<256)w.code(0x190+(v-144),9);
+        else if(v<280)w.code(v-256,7);
+        else w.code(0xc0+(v-280),8);
+    }
+
+    //Match of `length` bytes (3 to 258) at distance 1.
+    inline void run(bit_writer& w, uint32_t length){
+        constexpr uint16_t base[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+        constexpr uint8_t extra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+        int i = 28;
+        while(base[i]>length)i--;
+        literal(w,257+i);
+        if(extra[i]>0)w.put(length-base[i],extra[i]);
+        w.code(0,5);
+    }
+
+    inline void chunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data){
+        uint32_t size = data.size();
+        uint8_t head[8] = {(uint8_t)(size>>24),(uint8_t)(size>>16),(uint8_t)(size>>8),(uint8_t)size,(uint8_t)type[0],(uint8_t)type[1],(uint8_t)type[2],(uint8_t)type[3]};
+        out.insert(out.end(),head,head+8);
+        out.insert(out.end(),data.begin(),data.end());
+        uint32_t crc = crc32(data.data(),data.size(),crc32(head+4,4));
+        uint8_t tail[4] = {(uint8_t)(crc>>24),(uint8_t)(crc>>16),(uint8_t)(crc>>8),(uint8_t)crc};
+        out.insert(out.end(),tail,tail+4);
+    }
+}
+
+/**
+ * @brief Encode an image.
+ *
+ * @param pixels row major, `channels` bytes per pixel
+ * @param width
+ * @param height
+ * @param channels 1 for grayscale, 2 for grayscale with alpha, 3 for RGB, 4 for RGBA
+ * @param out the PNG file content, replaced
+ */
+inline void encode(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t>& out){
+    using namespace impl;
+    constexpr uint8_t color_types[5] = {0,0,4,2,6};
+    out.clear();
+    const uint8_t signature[8] = {0x89,'P','N','G','\r','\n',0x1a,'\n'};
+    out.insert(out.end(),signature,signature+8);
+
+    std::vector<uint8_t> data;
+    {
+        uint8_t ihdr[13] = {
+            (uint8_t)(width>>24),(uint8_t)(width>>16),(uint8_t)(width>>8),(uint8_t)width,
+            (uint8_t)(height>>24),(uint8_t)(height>>16),(uint8_t)(height>>8),(uint8_t)height,
+            8,color_types[channels],0,0,0   //8 bit, no interlacing
+        };
+        data.assign(ihdr,ihdr+13);
+        chunk(out,"IHDR",data);
+    }
+
+    data.clear();
+    data.push_back(0x78);data.push_back(0x01);   //zlib header, no preset dictionary
+    {
+        bit_writer w{data};
+        w.put(1,1);     //Final block
+        w.put(1,2);     //Fixed Huffman codes
+
+        uint32_t a = 1, b = 0;  //Adler32
+        int last = -1;          //Previous byte in the stream, for runs
+        uint32_t pending = 0;   //Bytes equal to `last` not emitted yet
+
+        auto drain = [&](){
+            while(pending>=3){
+                uint32_t n = pending>258?258:pending;
+                if(pending-n>0 && pending-n<3)n=pending-3;   //Never leave a tail shorter than a match
+                run(w,n);
+                pending-=n;
+            }
+            for(;pending>0;pending--)literal(w,last);
+        };
+
+        auto emit = [&](uint8_t v){
+            a=(a+v)%65521;
+            b=(b+a)%65521;
+            if(v==last){pending++;return;}
+            drain();
+            literal(w,v);
+            last=v;
+        };
+
+        size_t stride = (size_t)width*channels;
+        for(uint32_t y=0;y<height;y++){
+            const uint8_t* row = pixels+(size_t)y*stride;
+            if(channels==1){
+                emit(0);    //No filter
+                for(size_t x=0;x<stride;x++)emit(row[x]);
+            }
+            else{
+                emit(1);    //Sub filter
+                for(size_t x=0;x<stride;x++)emit(row[x]-(x>=channels?row[x-channels]:0));
+            }
+        }
+        drain();
+        literal(w,256);
+        w.flush();
+
+        uint32_t adler = (b<<16)|a;
+        uint8_t tail[4] = {(uint8_t)(adler>>24),(uint8_t)(adler>>16),(uint8_t)(adler>>8),(uint8_t)adler};
+        data.insert(data.end(),tail,tail+4);
+    }
+    chunk(out,"IDAT",data);
+
+    data.clear();
+    chunk(out,"IEND",data);
+}
+
+inline void encode_gray(const uint8_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& out){
+    encode(pixels,width,height,1,out);
+}
+
+inline bool write(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels){
+    std::vector<uint8_t> out;
+    encode(pixels,width,height,channels,out);
+    FILE* fd = fopen(path,"wb");
+    if(fd==nullptr)return false;
+    bool ok = fwrite(out.data(),out.size(),1,fd)==1;
+    return (fclose(fd)==0) && ok;
+}
+
+inline bool write_gray(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height){
+    return write(path,pixels,width,height,1);
+}
+
+}
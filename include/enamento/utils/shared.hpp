@@ -7,6 +7,8 @@
 #include <cstring>
 #include <omp.h>
 
+#include "trace.hpp"
+
 template<size_t ITEMS=2048, size_t ENTRY=0>
 struct shared_map{
     struct view_t{
@@ -74,9 +76,33 @@ struct shared_map{
         else return false;
     }
 
+    //Drop an entry from the table without releasing its host buffer (for memory not owned by omp_alloc, like mmapped files)
+    //The copies made by `sync` on each device are released, as those are always owned by the table.
+    static view_t detach(size_t i){
+        assert(omp_get_device_num()==omp_get_initial_device());
+        assert(i<ITEMS);
+        if(i>=ITEMS)return {nullptr,0};
+        auto tmp = shared_entries[i];
+        shared_entries[i]={nullptr,0};
+
+        auto devs = omp_get_num_devices();
+        for(int dev=0;dev<devs;dev++){
+            void* tmp_base = nullptr;
+            #pragma omp target device(dev) map(from: tmp_base)
+            {
+                tmp_base=shared_entries[i].base;
+                shared_entries[i].base=nullptr;
+                shared_entries[i].size=0;
+            }
+            omp_target_free(tmp_base,dev);
+        }
+        return tmp;
+    }
+
     //Force sync of an entry
     static bool sync(size_t i){
         assert(omp_get_device_num()==omp_get_initial_device());
+        trace::scope _trace("sync","transfer");
         assert(i<ITEMS);
         if(i>=ITEMS)return false;
         auto devs = omp_get_num_devices();
@@ -103,6 +129,7 @@ struct shared_map{
     //Force sync of a slice in an entry
     static bool sync(size_t i,size_t start, size_t end){
         assert(omp_get_device_num()==omp_get_initial_device());
+        trace::scope _trace("sync","transfer");
         assert(i<ITEMS);
         if(i>=ITEMS)return false;
         assert(end<start);
@@ -0,0 +1,166 @@
+#pragma once
+
+/**
+ * @file trace.hpp
+ * @author karurochari
+ * @brief Lightweight timeline of what happens in a frame, exported in the trace event format of Chrome and Perfetto.
+ * @date 2025-04-23
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Scopes record a complete event when they end, with their name, a category and their interval.
+ * Each thread writes into its own ring buffer without locks, older events are overwritten once it is full.
+ * Buffers are only locked when a thread records its first event and when reading them back.
+ * Reading while other threads are recording is safe, but events being overwritten in the meanwhile may come out torn, so it is best done between frames.
+ *
+ * Recording is off until `enable` is called, and then it costs two clock reads per scope.
+ * Names and categories are not copied, so they must be string literals.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace trace{
+
+struct event_t{
+    const char* name;
+    const char* category;
+    uint64_t    begin;          //ns
+    uint64_t    end;            //ns
+    uint32_t    thread;
+};
+
+constexpr size_t CAPACITY = 1<<14;     //Events kept for each thread
+
+//Not in an anonymous namespace, as all translation units must share the same buffers.
+namespace internal{
+    struct ring_t{
+        event_t                 events[CAPACITY];
+        std::atomic<uint64_t>   head = 0;       //Events written so far
+        uint32_t                thread;
+    };
+
+    struct registry_t{
+        std::mutex mtx;
+        std::vector<std::unique_ptr<ring_t>> rings;     //Owned here, so events survive the threads which wrote them
+        std::atomic<bool> enabled = false;
+    };
+
+    inline registry_t& registry(){
+        static registry_t instance;
+        return instance;
+    }
+
+    inline ring_t& local(){
+        thread_local ring_t* ring = nullptr;
+        if(ring==nullptr){
+            auto& reg = registry();
+            std::lock_guard lock(reg.mtx);
+            reg.rings.push_back(std::make_unique<ring_t>());
+            ring = reg.rings.back().get();
+            ring->thread = reg.rings.size()-1;
+        }
+        return *ring;
+    }
+}
+
+inline uint64_t now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void enable(bool value=true){internal::registry().enabled.store(value,std::memory_order_relaxed);}
+inline bool enabled(){return internal::registry().enabled.load(std::memory_order_relaxed);}
+
+inline void record(const char* name, const char* category, uint64_t begin, uint64_t end){
+    auto& ring = internal::local();
+    auto head = ring.head.load(std::memory_order_relaxed);
+    ring.events[head%CAPACITY]={name,category,begin,end,ring.thread};
+    ring.head.store(head+1,std::memory_order_release);
+}
+
+struct scope{
+    private:
+        const char* name;
+        const char* category;
+        uint64_t    begin;
+
+    public:
+        inline scope(const char* name, const char* category):name(name),category(category),begin(enabled()?now():0){}
+        inline ~scope(){close();}
+
+        //End the event before the scope does.
+        inline void close(){
+            if(begin!=0)record(name,category,begin,now());
+            begin=0;
+        }
+};
+
+/**
+ * @brief Events still in the buffers of all threads, sorted by their start.
+ *
+ * @param since only events ending after this time are returned
+ * @return std::vector<event_t>
+ */
+inline std::vector<event_t> collect(uint64_t since = 0){
+    std::vector<event_t> ret;
+    auto& reg = internal::registry();
+    std::lock_guard lock(reg.mtx);
+    for(auto& ring: reg.rings){
+        auto head = ring->head.load(std::memory_order_acquire);
+        for(auto i = head>CAPACITY?head-CAPACITY:0;i<head;i++){
+            auto& e = ring->events[i%CAPACITY];
+            if(e.end>=since)ret.push_back(e);
+        }
+    }
+    std::sort(ret.begin(),ret.end(),[](const event_t& a, const event_t& b){return a.begin<b.begin;});
+    return ret;
+}
+
+inline void clear(){
+    auto& reg = internal::registry();
+    std::lock_guard lock(reg.mtx);
+    for(auto& ring: reg.rings)ring->head.store(0,std::memory_order_release);
+}
+
+/**
+ * @brief Time spent under each name, in the order they first appear.
+ *
+ * @param events as returned by `collect`
+ * @param category if not null, only events of this category are counted
+ * @return std::vector<std::pair<const char*,uint64_t>> ns for each name
+ */
+inline std::vector<std::pair<const char*,uint64_t>> totals(const std::vector<event_t>& events, const char* category = nullptr){
+    std::vector<std::pair<const char*,uint64_t>> ret;
+    for(auto& e: events){
+        if(category!=nullptr && std::string_view(category)!=e.category)continue;
+        auto it = std::find_if(ret.begin(),ret.end(),[&](auto& t){return std::string_view(t.first)==e.name;});
+        if(it==ret.end())ret.push_back({e.name,e.end-e.begin});
+        else it->second+=e.end-e.begin;
+    }
+    return ret;
+}
+
+/**
+ * @brief Write events as a JSON trace, which can be opened by chrome://tracing and Perfetto.
+ *
+ * @param events as returned by `collect`
+ * @param out
+ */
+inline void write_chrome(const std::vector<event_t>& events, std::ostream& out){
+    out<<"{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for(size_t i=0;i<events.size();i++){
+        auto& e = events[i];
+        out<<"  {\"name\": \""<<e.name<<"\", \"cat\": \""<<e.category<<"\", \"ph\": \"X\", \"pid\": 0, \"tid\": "<<e.thread
+           <<", \"ts\": "<<e.begin/1000<<"."<<e.begin%1000/100<<", \"dur\": "<<(e.end-e.begin)/1000<<"."<<(e.end-e.begin)%1000/100<<"}"<<(i+1<events.size()?",":"")<<"\n";
+    }
+    out<<"]}\n";
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+ * @file triple-buffer.hpp
+ * @author karurochari
+ * @brief Mailbox between one producer and one consumer, where the consumer only cares about the latest value.
+ * @date 2025-04-23
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * The producer fills `back()` and publishes it, the consumer calls `update()` and reads `front()`.
+ * Neither of them ever waits for the other: a third slot holds the latest published value between the two,
+ * and values published while the consumer is not looking are simply replaced by newer ones.
+ */
+
+#include <atomic>
+#include <cstdint>
+
+template<typename T>
+struct triple_buffer{
+    private:
+        T slots[3];
+        //Index of the slot in the middle, with FRESH set if it was published and not yet taken by the consumer.
+        std::atomic<uint8_t> middle = 1;
+        uint8_t front_idx = 0;      //Owned by the consumer
+        uint8_t back_idx = 2;       //Owned by the producer
+
+        static constexpr uint8_t FRESH = 4;
+
+    public:
+        inline T& back(){return slots[back_idx];}
+        inline T& front(){return slots[front_idx];}
+        inline const T& front() const{return slots[front_idx];}
+
+        //Producer side, hand over the back slot and get a free one in exchange.
+        inline void publish(){
+            back_idx = middle.exchange(back_idx|FRESH,std::memory_order_acq_rel)&3;
+        }
+
+        //Consumer side, move to the latest published slot if there is a new one.
+        inline bool update(){
+            if((middle.load(std::memory_order_relaxed)&FRESH)==0)return false;
+            front_idx = middle.exchange(front_idx,std::memory_order_acq_rel)&3;
+            return true;
+        }
+};
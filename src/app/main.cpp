@@ -13,6 +13,8 @@
 #include "shared-slots.hpp"
 #include <sdf/sdf.hpp>
 #include <sdf/serialize.hpp>
+#include <sdf/versioned.hpp>
+#include <utils/jobs.hpp>
 
 #include <ui/ui.hpp>
 
@@ -22,8 +24,12 @@ const int WINDOW_HEIGHT = 800;
 
 
 #include <pipeline/basic.hpp>
+#include <scene-import/packed.hpp>
 
 #include "xml.hpp"
+#include "xml-tree.hpp"
+#include "tree-view.hpp"
+#include "materials.hpp"
 #include "lua-script.hpp"
 
 using namespace glm;
@@ -72,27 +78,54 @@ int main(int argc, const char** argv) {
 
     App::treeview_t treeview;
 
-    std::shared_ptr<sdf::utils::base_dyn<sdf::default_attrs>> fromXML;
-    {
-        auto doc = pugi::xml_document();
-        auto ret = doc.load_file(argc>=2?argv[1]:"./examples/test-0.xml");
-        std::cout<<ret;
+    const char* scene_path = argc>=2?argv[1]:"./examples/test-0.xml";
+    std::string_view scene_ext = scene_path;
+    scene_ext = scene_ext.substr(std::min(scene_ext.size(),scene_ext.rfind('.')));
+
+    //Packed scenes are mapped and used in place, no parsing involved.
+    sdf::packed::mapped packed;
+    pugi::xml_document doc;
+    sdf::tree::builder builder;     //Referenced by the loader, so it must live as long as it
+    std::unique_ptr<parse_xml_tree<sdf::default_attrs>> loader;
+    std::span<const pipeline::material_t> materials = default_materials;
+
+    if(scene_ext==".enpack"){
+        packed = sdf::packed::mapped(scene_path);
+        if(!packed.compatible<sdf::default_attrs>())throw "CannotLoad";
+        if(!packed.bind(2))throw "CannotBuild";
+        if(packed.materials<pipeline::material_t>().size()!=0)materials=packed.materials<pipeline::material_t>();
+
+        //Rebuild the hierarchy for the UI from the pre-order node table.
+        size_t cursor = 0;
+        std::function<App::treeview_t::entry_t()> rebuild = [&](){
+            auto& node = packed.nodes()[cursor++];
+            auto label = packed.str(node.label);
+            App::treeview_t::entry_t entry = {std::format("{}({})##{}",label!=nullptr?std::format("{} ",label):std::string(""),packed.str(node.type),node.offset),node.offset};
+            for(uint i=0;i<node.children && cursor<packed.nodes().size();i++)entry.children.push_back(rebuild());
+            return entry;
+        };
+        if(packed.nodes().size()!=0)treeview.children.push_back(rebuild());
+    }
+    else{
+        //Nodes are streamed into the builder, the dynamic graph is only built for the subtrees being inspected.
+        auto ret = doc.load_file(scene_path);
+        if(!ret){
+            printf("ERROR: unable to load %s: %s\n",scene_path,ret.description());
+            return 1;
+        }
         try{
-            parse_xml<sdf::default_attrs> testxml(doc.first_child());
-            fromXML = testxml.sdf_root();
-            std::cout<<(fromXML->operator()({0.0,0.0,0.0})).distance<<"\n";
-
-            treeview = testxml.ui_root();
-        }catch(...){}
+            loader = std::make_unique<parse_xml_tree<sdf::default_attrs>>(doc.first_child(),builder);
+            treeview = ui_root(*loader);
+        }catch(...){
+            printf("ERROR: unable to parse %s\n",scene_path);
+            return 1;
+        }
+        std::print("Scene: {} nodes, {} shared subtrees, {} of {} bytes saved ({:.1f}%)\n",
+            builder.stats.nodes,builder.stats.shared,builder.stats.bytes_saved,builder.bytes.size()+builder.stats.bytes_saved,
+            100.0*builder.stats.bytes_saved/(builder.bytes.size()+builder.stats.bytes_saved));
+        if(!builder.make_shared(2))throw "CannotBuild";
     }
 
-    sdf::serialize::sdf2cpp(*fromXML,std::cout); 
-    std::print("\n");
- 
-    sdf::tree::builder builder; 
-    builder.close(fromXML->to_tree(builder));
-    if(!builder.make_shared(2))throw "CannotBuild";
-
     App app(WINDOW_WIDTH,WINDOW_HEIGHT);
 
     App::contextual_menu_t menu = {
@@ -113,6 +146,18 @@ int main(int argc, const char** argv) {
         switch(action){
             case App::commander_action_t::SELECT:
                 std::print("Select {}\n",ctx);
+                if(auto node = loader!=nullptr?loader->dynamic(ctx):nullptr; node!=nullptr){
+                    details.name=node->name();
+                    details.fields=node->fields();
+                    node->traits(details.traits);
+                }
+                //Packed scenes have no dynamic graph, the flat node is inspected in place. The context is its offset in the tree.
+                else if(packed.valid() && ctx<packed.tree_size()){
+                    auto node = (const sdf::utils::tree_idx<sdf::default_attrs>*)(packed.tree()+ctx);
+                    details.name=node->name();
+                    details.fields=node->fields();
+                    node->traits(details.traits);
+                }
                 break;
             case App::commander_action_t::HIDE:
                 std::print("Hide {}\n",ctx);
@@ -130,35 +175,39 @@ int main(int argc, const char** argv) {
     sdf::comptime::Interpreted_t<sdf::default_attrs> SDF_MIX_ALL(2);
 
     sampler::octatree3D::builder sparseA(SDF_MIX_ALL,/*10*/3);
-    sparseA.build();
-    if(!sparseA.make_shared(3))throw "CannotBuild";
-    auto octadata1 = sparseA.stats();
 
-    auto SDF_BASE_W1 = sdf::comptime::OctaSampled3D({3}); 
-
-    static pipeline::material_t materials[10] = {
-            {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={vec3{1.0,1.0,1.0},1.0}}},
-            {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={vec3{0.5,0.3,1.0},1.0}}},
-            {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={vec3{0.2,0.9,0.5},1.0}}},
-            {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={vec3{0.8,0.8,0.5},1.0}}},
-            {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={vec3{0.8,0.2,0.2},1.0}}},
-            {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={vec3{0.2,0.8,0.2},1.0}}}
+    //Long operations run in the background, and their results are published by the render thread between frames.
+    jobs::pool background;
+    background.submit(
+        [&sparseA](jobs::status_t& status){return sparseA.build(&status);},
+        [&sparseA](){return sparseA.make_shared(3);},
+        jobs::priority_t::LOW
+    );
 
-    };
+    auto SDF_BASE_W1 = sdf::comptime::OctaSampled3D({3}); 
 
 
     sdf::serialize::sdf2cpp(SDF_MIX_ALL,std::cout);
 
-    //pipeline::demo<decltype(SDF_BASE_W1)> PIPERINE(DEVICE,SDF_BASE_W1,materials,sizeof(materials)/sizeof(pipeline::material_t));
-    pipeline::demo<decltype(SDF_MIX_ALL)> PIPERINE(DEVICE,SDF_MIX_ALL,materials,sizeof(materials)/sizeof(pipeline::material_t));
+    //pipeline::demo<decltype(SDF_BASE_W1)> PIPERINE(DEVICE,SDF_BASE_W1,materials.data(),materials.size());
+    pipeline::demo<decltype(SDF_MIX_ALL)> PIPERINE(DEVICE,SDF_MIX_ALL,materials.data(),materials.size());
+
+    //Edits are published as new versions of the tree, frames pick the latest one when they start.
+    sdf::versioned versions(8,3);
+    if(auto view = global_shared[2]; !versions.publish((const uint8_t*)view.base,view.size))throw "CannotBuild";
 
     app.run({
-        [&PIPERINE](const App::camera_t& camera, void* buffer){
+        [&PIPERINE,&versions,&background](const App::camera_t& camera, void* buffer, const std::atomic<bool>& cancel){
+            background.flush();
+            auto snapshot = versions.acquire();
+            PIPERINE.set_sdf(sdf::comptime::Interpreted_t<sdf::default_attrs>(snapshot.slot()));
             PIPERINE.set_camera(camera);
-            PIPERINE.render((glm::u8vec4*)buffer);
+            PIPERINE.render((glm::u8vec4*)buffer,&cancel);
             return 0;
         },
-        [&PIPERINE](const App::camera_t& camera, const glm::vec2& point){
+        [&PIPERINE,&versions](const App::camera_t& camera, const glm::vec2& point){
+            auto snapshot = versions.acquire();
+            PIPERINE.set_sdf(sdf::comptime::Interpreted_t<sdf::default_attrs>(snapshot.slot()));
             PIPERINE.set_camera(camera);
             return PIPERINE.raycast(point);
         },
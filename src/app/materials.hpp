@@ -0,0 +1,22 @@
+#pragma once
+
+/**
+ * @file materials.hpp
+ * @author karurochari
+ * @brief Default material palette, used when the scene does not provide its own.
+ * @date 2025-04-12
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#include <pipeline/basic.hpp>
+
+inline pipeline::material_t default_materials[10] = {
+        {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={glm::vec3{1.0,1.0,1.0},1.0}}},
+        {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={glm::vec3{0.5,0.3,1.0},1.0}}},
+        {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={glm::vec3{0.2,0.9,0.5},1.0}}},
+        {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={glm::vec3{0.8,0.8,0.5},1.0}}},
+        {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={glm::vec3{0.8,0.2,0.2},1.0}}},
+        {.albedo={.type=pipeline::material_t::albedo_t::COLOR,.color={glm::vec3{0.2,0.8,0.2},1.0}}}
+};
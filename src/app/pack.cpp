@@ -0,0 +1,61 @@
+/**
+ * @file pack.cpp
+ * @author karurochari
+ * @brief Convert XML scenes into the memory-mappable packed format.
+ * @date 2025-04-12
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#include <cstdio>
+#include <span>
+
+#define GLM_FORCE_INLINE
+#define GLM_FORCE_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "shared-slots.hpp"
+#include <sdf/sdf.hpp>
+#include <scene-import/packed.hpp>
+
+#include "xml-tree.hpp"
+#include "materials.hpp"
+
+int main(int argc, const char** argv){
+    if(argc<3){
+        printf("Usage: %s <scene.xml> <scene.enpack>\n",argv[0]);
+        return 1;
+    }
+
+    auto doc = pugi::xml_document();
+    auto ret = doc.load_file(argv[1]);
+    if(!ret){
+        printf("ERROR: unable to load %s: %s\n",argv[1],ret.description());
+        return 1;
+    }
+
+    try{
+        sdf::tree::builder builder;
+        builder.share_subtrees = true;
+        parse_xml_tree<sdf::default_attrs> scene(doc.first_child(),builder);
+
+        sdf::packed::writer<sdf::default_attrs> packed(builder);
+        scene.for_each_named([&](const auto& entry){
+            packed.name(entry.label,(uint32_t)entry.offset);
+        });
+        packed.material(std::span<const pipeline::material_t>(default_materials));
+
+        if(!packed.save(argv[2])){
+            printf("ERROR: unable to write %s\n",argv[2]);
+            return 1;
+        }
+        printf("Packed %zu bytes of tree into %s\n",builder.bytes.size(),argv[2]);
+        printf("%zu nodes, %zu shared subtrees, %zu bytes saved\n",builder.stats.nodes,builder.stats.shared,builder.stats.bytes_saved);
+    }catch(...){
+        printf("ERROR: unable to parse %s\n",argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
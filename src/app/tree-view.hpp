@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * @file tree-view.hpp
+ * @author karurochari
+ * @brief Hierarchy shown by the tree view of the editor for scenes streamed from XML.
+ * @date 2025-04-13
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <format>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <ui/ui.hpp>
+
+#include "xml-tree.hpp"
+
+/**
+ * @brief Generate the ui tree of a loaded scene. Context values are entries in the index of the loader.
+ */
+template<typename Attrs>
+App::treeview_t ui_root(const parse_xml_tree<Attrs>& loader){
+    //Entries are in post-order, so children are always on the stack when their parent is met.
+    std::vector<App::treeview_t::entry_t> stack;
+    for(uint32_t i=0;i<loader.size();i++){
+        auto& entry = loader.entry(i);
+        auto n = entry.children;
+        App::treeview_t::entry_t item;
+        item.label = std::format("{}({})##{}",entry.label!=nullptr?std::format("{} ",entry.label):std::string(""), entry.xml.name(),i);
+        item.ctx = i;
+        item.children.assign(std::make_move_iterator(stack.end()-n),std::make_move_iterator(stack.end()));
+        stack.resize(stack.size()-n);
+        stack.push_back(std::move(item));
+    }
+    App::treeview_t ret;
+    ret.children = std::move(stack);
+    return ret;
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+/**
+ * @file xml-tree.hpp
+ * @author karurochari
+ * @brief Streaming loader from XML scenes straight into a `tree::builder`, with no dynamic graph in between.
+ * @date 2025-04-13
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Nodes are written in post-order as soon as their children are done, using the same layout `to_tree` would generate.
+ * Transient state (the index of nodes and the stack of inherited extras) lives in an arena, and attributes are parsed in place.
+ * The dynamic graph for a subtree is only built when it is requested, for example when the editor opens it.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <vector>
+
+#include <pugixml.hpp>
+
+#include "sdf/sdf.hpp"
+#include "sdf/serialize.hpp"
+#include "utils/arena.hpp"
+
+#include "xml.hpp"
+
+template<typename Attrs>
+struct parse_xml_tree{
+    struct entry_t{
+        uint64_t                    offset;     //Position of the node in the builder
+        sdf::tree::op_t::type_t     opcode;
+        uint32_t                    children;
+        pugi::xml_node              xml;
+        const char*                 label;      //Owned by the xml document, nullptr if anonymous
+        typename Attrs::extras_t    extras;     //Inherited from the enclosing groups
+        bool                        pinned;     //If it or any node in its subtree is labelled. Pinned subtrees are never shared.
+    };
+    //Offsets are only reliable for pinned entries, as unlabelled subtrees can be replaced by references to an identical copy.
+
+    private:
+    using base = parse_xml<Attrs>;
+
+    sdf::tree::builder& dst;
+    arena transient;
+
+    std::vector<entry_t,arena_allocator<entry_t>> index;
+    std::vector<uint32_t,arena_allocator<uint32_t>> named;      //Entries with a label, sorted by it
+    std::vector<typename Attrs::extras_t,arena_allocator<typename Attrs::extras_t>> tmp_extras;
+
+    std::map<uint64_t,std::shared_ptr<sdf::utils::base_dyn<Attrs>>> expanded;
+
+    uint32_t root_entry = 0;
+
+    using ref_t = sdf::utils::tree_idx_ref<sdf::utils::tree_idx<Attrs>>;
+
+    /**
+     * @brief Add a node which was just pushed to the index, and let the builder share it if it is a copy of an existing subtree.
+     */
+    uint32_t record(const pugi::xml_node& root, uint64_t start, uint64_t offset, const uint8_t* key, size_t len, std::initializer_list<uint32_t> children){
+        auto label = root.attribute("label").as_string(nullptr);
+        bool pinned = label!=nullptr;
+        uint64_t offsets[2];
+        size_t n = 0;
+        for(auto child : children){
+            pinned|=index[child].pinned;
+            offsets[n++]=index[child].offset;
+        }
+        sdf::tree::op_t::type_t opcode;
+        memcpy(&opcode,dst.bytes.data()+offset-2,2);
+        if(!pinned)offset=dst.share(start,offset,key,len,offsets,n);
+        index.push_back({offset,opcode,(uint32_t)children.size(),root,label,tmp_extras.back(),pinned});
+        return index.size()-1;
+    }
+
+    #define XML_PRIMITIVE(NAME) \
+        else if(strcmp(root.name(),toLower(#NAME))==0){\
+            auto start = dst.mark();\
+            sdf::impl::NAME<Attrs> tmp{};\
+            base::template parse_attrs<false>(root,(uint8_t*)&tmp.cfg,tmp._fields,sizeof(tmp._fields)/sizeof(sdf::field_t),tmp_extras.back());\
+            return record(root,start,dst.push(sdf::tree::op_t::NAME,(uint8_t*)&tmp,sizeof(tmp)),(uint8_t*)&tmp,sizeof(tmp),{});\
+        }
+
+    #define XML_OP2(NAME)\
+        else if(strcmp(root.name(),toLower(#NAME))==0){\
+            auto start = dst.mark();\
+            auto first_child =  root.first_child();\
+            auto second_child = first_child.next_sibling();\
+            \
+            auto left = emit(first_child);\
+            auto right = emit(second_child);\
+            \
+            using node_t = sdf::impl::NAME<ref_t,ref_t>;\
+            node_t tmp({(uint16_t)(dst.next()-index[left].offset)},{(uint16_t)(dst.next()-index[right].offset)});\
+            base::template parse_attrs<true>(root,(uint8_t*)&tmp.cfg,tmp._fields,sizeof(tmp._fields)/sizeof(sdf::field_t),tmp_extras.back());\
+            if(second_child!=root.last_child()){\
+                base::warning("Residual children in binary operator detected");\
+            }\
+            alignas(node_t) uint8_t key[sizeof(node_t)] = {};\
+            new (key) node_t({0},{0});\
+            ((node_t*)key)->cfg = tmp.cfg;\
+            return record(root,start,dst.push(sdf::tree::op_t::NAME,(uint8_t*)&tmp,sizeof(tmp)),key,sizeof(key),{left,right});\
+        }
+
+    #define XML_OP1(NAME)\
+        else if(strcmp(root.name(),toLower(#NAME))==0){\
+            auto start = dst.mark();\
+            auto first_child =  root.first_child();\
+            \
+            auto left = emit(first_child);\
+            \
+            using node_t = sdf::impl::NAME<ref_t>;\
+            node_t tmp({(uint16_t)(dst.next()-index[left].offset)});\
+            base::template parse_attrs<true>(root,(uint8_t*)&tmp.cfg,tmp._fields,sizeof(tmp._fields)/sizeof(sdf::field_t),tmp_extras.back());\
+            if(first_child!=root.last_child()){\
+                base::warning("Residual children in binary operator detected");\
+            }\
+            alignas(node_t) uint8_t key[sizeof(node_t)] = {};\
+            new (key) node_t({0});\
+            ((node_t*)key)->cfg = tmp.cfg;\
+            return record(root,start,dst.push(sdf::tree::op_t::NAME,(uint8_t*)&tmp,sizeof(tmp)),key,sizeof(key),{left});\
+        }
+
+    /**
+     * @brief Write a node and its subtree in the builder.
+     *
+     * @param root
+     * @return uint32_t the entry in the index for this node.
+     */
+    uint32_t emit(const pugi::xml_node& root){
+        if(false){}
+        XML_PRIMITIVE(Sphere)
+        XML_PRIMITIVE(Box)
+        XML_PRIMITIVE(Plane)
+        XML_PRIMITIVE(Zero)
+
+        XML_OP2(Join)
+        XML_OP2(Cut)
+        XML_OP2(Common)
+        XML_OP2(Xor)
+
+        XML_OP2(SmoothJoin)
+
+        XML_OP1(Translate)
+        XML_OP1(Rotate)
+        XML_OP1(Scale)
+        XML_OP1(Instances)
+        XML_OP1(Array)
+        XML_OP1(CyclicArray)
+        XML_OP1(Mirror)
+
+        else if(strcmp(root.name(),"group")==0){
+            typename Attrs::extras_t current;
+            sdf::serialize::xml2attrs<Attrs>(root,current,tmp_extras.back());
+            tmp_extras.push_back(current);
+            auto ret = emit(root.first_child());
+            if(root.first_child()!=root.last_child()){
+                base::warning("Objects skipped as they were not part of any expression.");
+            }
+            tmp_extras.pop_back();
+            return ret;
+        }
+
+        //Unknown entities (including the ones not supported yet, like forward) are replaced by an empty node.
+        base::warning("Unknown entity, skip");
+        auto start = dst.mark();
+        sdf::impl::Zero<Attrs> tmp{};
+        return record(root,start,dst.push(sdf::tree::op_t::Zero,(uint8_t*)&tmp,sizeof(tmp)),(uint8_t*)&tmp,sizeof(tmp),{});
+    }
+
+    #undef XML_PRIMITIVE
+    #undef XML_OP1
+    #undef XML_OP2
+
+    public:
+        /**
+         * @brief Load the tree selected as root of the forest into a builder, and close it.
+         *
+         * @param root the forest
+         * @param dst the builder
+         */
+        parse_xml_tree(const pugi::xml_node& root, sdf::tree::builder& dst):dst(dst),index(transient),named(transient),tmp_extras(transient){
+            if(strcmp(root.name(),"forest")!=0){base::error("No forest root found.");}
+            auto root_label = root.attribute("root").as_string("$");
+
+            pugi::xml_node tree;
+            for(auto& child: root.children()){
+                auto label = child.attribute("label").as_string(nullptr);
+                if(label==nullptr)base::error("Trees must have a label");
+                if(strcmp(label,root_label)==0){tree=child;break;}
+            }
+            if(!tree)base::error("root not found");
+
+            tmp_extras.push_back({});
+            root_entry = emit(tree);
+            dst.close(index[root_entry].offset);
+
+            for(uint32_t i=0;i<index.size();i++){
+                if(index[i].label!=nullptr)named.push_back(i);
+            }
+            std::sort(named.begin(),named.end(),[this](uint32_t a, uint32_t b){return strcmp(index[a].label,index[b].label)<0;});
+        }
+
+        inline size_t size() const{return index.size();}
+        inline const entry_t& entry(uint64_t ctx) const{return index[ctx];}
+        inline const entry_t& root() const{return index[root_entry];}
+
+        /**
+         * @brief Look for a named node.
+         *
+         * @param label
+         * @return const entry_t* nullptr if not found.
+         */
+        const entry_t* find(const char* label) const{
+            auto it = std::lower_bound(named.begin(),named.end(),label,[this](uint32_t a, const char* b){return strcmp(index[a].label,b)<0;});
+            if(it==named.end() || strcmp(index[*it].label,label)!=0)return nullptr;
+            return &index[*it];
+        }
+
+        template<typename F>
+        void for_each_named(F&& fn) const{
+            for(auto i : named)fn(index[i]);
+        }
+
+        /**
+         * @brief Dynamic graph for the subtree of an entry, built on first request.
+         *
+         * @param ctx the entry (as used in the ui tree)
+         * @return std::shared_ptr<sdf::utils::base_dyn<Attrs>>
+         */
+        std::shared_ptr<sdf::utils::base_dyn<Attrs>> dynamic(uint64_t ctx){
+            if(ctx>=index.size())return nullptr;
+            auto it = expanded.find(ctx);
+            if(it!=expanded.end())return it->second;
+            auto ret = base::subtree(index[ctx].xml,index[ctx].extras);
+            expanded.emplace(ctx,ret);
+            return ret;
+        }
+};
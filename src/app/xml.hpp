@@ -29,9 +29,6 @@ TODO:
 #include <charconv>
 #include <string_view>
 #include <stack>
-#include <format>
-
-#include <ui/ui.hpp>
 
 #include "sdf/sdf.hpp"
 
@@ -71,17 +68,6 @@ constexpr const_str<N> toLower(const char(&str)[N]) {
     return {str, std::make_integer_sequence<unsigned, N>()};
 }
 
-static std::vector<std::string_view> split_string (const char* str, char delim) {
-    if(str==nullptr)return {};
-    std::vector<std::string_view> result;
-    size_t i = 0, last = 0;
-    for(;; i++){
-        if(str[i]==delim){result.emplace_back(str+last,i-last);i++;last=i;}
-        if(str[i]==0){result.emplace_back(str+last,i-last);break;}
-    }
-    return result;
-}
-
 template<typename Attrs>
 struct parse_xml{
     private:
@@ -93,65 +79,74 @@ struct parse_xml{
 
     std::string root_label;
 
-    App::treeview_t ui_tree;
     uint64_t next_uid=0;
 
     struct nodes_t{
         std::shared_ptr<sdf::utils::base_dyn<Attrs>> sdf;
-        App::treeview_t::entry_t ui;
     };
 
-    void warning(const char* str){printf("WARNING: %s\n",str);}
-    void error(const char* str){printf("ERROR:  %s\n",str);throw "Error";}
+    static void warning(const char* str){printf("WARNING: %s\n",str);}
+    static void error(const char* str){printf("ERROR:  %s\n",str);throw "Error";}
 
-    template<typename T, uint N>
-    void handle_field(const pugi::xml_node& root, const sdf::field_t& field, uint8_t* base){ 
-        T tmp[N];
-        auto str = split_string(root.attribute(field.name).as_string(nullptr),'|');
-        
-        {
-            auto tk_0 = root.attribute((std::string(field.name)+".0").c_str()).as_string(nullptr);
-            auto tk_x = root.attribute((std::string(field.name)+".x").c_str()).as_string(nullptr);
-            auto tk_r = root.attribute((std::string(field.name)+".r").c_str()).as_string(nullptr);
-            auto tk_u = root.attribute((std::string(field.name)+".u").c_str()).as_string(nullptr);
-
-            auto tk = !tk_0?tk_0:(!tk_x?tk_x:(!tk_r?tk_r:(tk_u)));
-            if(tk!=nullptr){str[0]=tk;}
-        }
+    template<typename> friend struct parse_xml_tree;
 
-        {
-            auto tk_0 = root.attribute((std::string(field.name)+".1").c_str()).as_string(nullptr);
-            auto tk_x = root.attribute((std::string(field.name)+".y").c_str()).as_string(nullptr);
-            auto tk_r = root.attribute((std::string(field.name)+".g").c_str()).as_string(nullptr);
-            auto tk_u = root.attribute((std::string(field.name)+".v").c_str()).as_string(nullptr);
+    //Attribute suffixes accepted for each component of a field, first match taken.
+    static constexpr const char* field_aliases[4][4] = {
+        {"0","x","r","u"},
+        {"1","y","g","v"},
+        {"2","z","b",nullptr},
+        {"3","w","a",nullptr},
+    };
 
-            auto tk = !tk_0?tk_0:(!tk_x?tk_x:(!tk_r?tk_r:(tk_u)));
-            if(tk!=nullptr){str[1]=tk;}
+    template<typename T, uint N>
+    static void handle_field(const pugi::xml_node& root, const sdf::field_t& field, uint8_t* base){ 
+        //Components which are not given keep their current value.
+        T tmp[N];
+        memcpy(tmp,base+field.offset,field.length);
+        std::string_view str[4];
+        size_t str_n = 0;
+        bool named = false;
+
+        if(auto value = root.attribute(field.name).as_string(nullptr); value!=nullptr){
+            std::string_view rest = value;
+            for(;;){
+                auto pos = rest.find('|');
+                if(str_n<4)str[str_n]=rest.substr(0,pos);
+                str_n++;
+                if(pos==std::string_view::npos)break;
+                rest=rest.substr(pos+1);
+            }
         }
 
-        {
-            auto tk_0 = root.attribute((std::string(field.name)+".2").c_str()).as_string(nullptr);
-            auto tk_x = root.attribute((std::string(field.name)+".z").c_str()).as_string(nullptr);
-            auto tk_r = root.attribute((std::string(field.name)+".b").c_str()).as_string(nullptr);
-
-            auto tk = !tk_0?tk_0:(!tk_x?tk_x:(tk_r));
-            if(tk!=nullptr){str[2]=tk;}
+        for(uint n=0;n<N && n<4;n++){
+            char key[128];
+            for(auto alias : field_aliases[n]){
+                if(alias==nullptr)break;
+                snprintf(key,sizeof(key),"%s.%s",field.name,alias);
+                auto tk = root.attribute(key).as_string(nullptr);
+                if(tk!=nullptr){
+                    str[n]=tk;
+                    named=true;
+                    break;
+                }
+            }
         }
 
-        {
-            auto tk_0 = root.attribute((std::string(field.name)+".3").c_str()).as_string(nullptr);
-            auto tk_x = root.attribute((std::string(field.name)+".w").c_str()).as_string(nullptr);
-            auto tk_r = root.attribute((std::string(field.name)+".a").c_str()).as_string(nullptr);
-
-            auto tk = !tk_0?tk_0:(!tk_x?tk_x:(tk_r));
-            if(tk!=nullptr){str[3]=tk;}
+        if(named){
+            //Single components are never wrapped around.
+            str_n=N;
         }
-
-        if(str.size()!=0){
-            if(str.size()!=N)warning(std::format("Size of input {} not matching dimensionality. Modulo wrapping",str.size()).c_str());
+        if(str_n!=0){
+            if(str_n!=N){
+                char msg[96];
+                snprintf(msg,sizeof(msg),"Size of input %zu not matching dimensionality. Modulo wrapping",str_n);
+                warning(msg);
+            }
+            if(str_n>4)str_n=4;
             for(uint n=0;n<N;n++){
-                std::string_view segment = str[n%str.size()];
-                std::from_chars(segment.begin(),segment.end(),*(tmp+n));
+                std::string_view segment = str[n%str_n];
+                if(segment.empty())continue;
+                std::from_chars(segment.data(),segment.data()+segment.size(),*(tmp+n));
                 if(field.min!=nullptr && tmp[n]<((T*)field.min)[n]){error("value low");}
                 else if(field.max!=nullptr && tmp[n]>((T*)field.max)[n]){error("value high");}
                 else if(field.validate!=nullptr && !field.validate(&tmp)){error("validation failed");}
@@ -167,16 +162,15 @@ struct parse_xml{
     }
 
     template<bool IS_OPERATOR>
-    void parse_attrs(const pugi::xml_node& root, uint8_t* base, const sdf::field_t fields[], size_t fields_i){
+    static void parse_attrs(const pugi::xml_node& root, uint8_t* base, const sdf::field_t fields[], size_t fields_i, const typename Attrs::extras_t& inherited){
         //Assumption: cfg is at the root of the object by construction.
         if constexpr(!IS_OPERATOR){
             typename Attrs::extras_t* cfg = (typename Attrs::extras_t*)base;
             auto cfg_node=root.child("cfg");
-            sdf::serialize::xml2attrs<Attrs>(cfg_node, *cfg, tmp_extras.top());
+            sdf::serialize::xml2attrs<Attrs>(cfg_node, *cfg, inherited);
         }
 
         for(size_t i=0;i<fields_i;i++){
-            printf(">> %d--%s\n",i,fields[i].name);
             auto& field = fields[i];
             switch(field.type){
                 case sdf::field_t::type_unknown:
@@ -186,40 +180,40 @@ struct parse_xml{
                     //Separate handling
                     break;
                 case sdf::field_t::type_float:
-                    this->handle_field<float,1>(root,field,base);
+                    handle_field<float,1>(root,field,base);
                     break;
                 case sdf::field_t::type_vec2:
-                    this->handle_field<float,2>(root,field,base);
+                    handle_field<float,2>(root,field,base);
                     break;
                 case sdf::field_t::type_vec3:
-                    this->handle_field<float,3>(root,field,base);
+                    handle_field<float,3>(root,field,base);
                     break;
                 case sdf::field_t::type_int:
-                    this->handle_field<int,1>(root,field,base);
+                    handle_field<int,1>(root,field,base);
                     break;
                 case sdf::field_t::type_ivec2:
-                    this->handle_field<int,2>(root,field,base);
+                    handle_field<int,2>(root,field,base);
                     break;
                 case sdf::field_t::type_ivec3:
-                    this->handle_field<int,3>(root,field,base);
+                    handle_field<int,3>(root,field,base);
                     break;
                 case sdf::field_t::type_bool:
                     //TODO: Support true and false
-                    this->handle_field<int,1>(root,field,base);
+                    handle_field<int,1>(root,field,base);
                     break;
                 case sdf::field_t::type_tribool:
                 {
                     //TODO: temporary implementation before triboolean are supported.
-                    this->handle_field<int,1>(root,field,base);
+                    handle_field<int,1>(root,field,base);
                     break;
                 }
                 case sdf::field_t::type_enum:
                     //TODO: temporary implementation before enum entries are supported.
-                    this->handle_field<int,1>(root,field,base);
+                    handle_field<int,1>(root,field,base);
                     break;
                 case sdf::field_t::type_shared_buffer:
                     //TODO: Support true and false
-                    this->handle_field<size_t,1>(root,field,base);
+                    handle_field<size_t,1>(root,field,base);
                     break;
                 break;
             }
@@ -231,7 +225,7 @@ struct parse_xml{
             base.sdf = sdf::dynamic::NAME({});\
             auto real_base = (uint8_t*) &(dynamic_cast<sdf::impl_base::NAME<Attrs>*>(dynamic_cast<sdf::dynamic::NAME##_t<Attrs>*>(&*(base.sdf)))->cfg);\
             \
-            parse_attrs<false>(root,real_base,sdf::dynamic::NAME##_t<Attrs>::_fields,sizeof(sdf::dynamic::NAME##_t<Attrs>::_fields)/sizeof(sdf::field_t));\
+            parse_attrs<false>(root,real_base,sdf::dynamic::NAME##_t<Attrs>::_fields,sizeof(sdf::dynamic::NAME##_t<Attrs>::_fields)/sizeof(sdf::field_t),tmp_extras.top());\
         }
 
     #define XML_OP2(NAME)\
@@ -243,11 +237,10 @@ struct parse_xml{
             nodes_t right = parse_node(second_child);\
             \
             base.sdf = sdf::dynamic::NAME(left.sdf,right.sdf);\
-            base.ui.children = {left.ui, right.ui};\
             \
             auto real_base = (uint8_t*) &((dynamic_cast<sdf::utils::dyn_op<Attrs,sdf::impl::NAME<decltype(left.sdf),decltype(right.sdf)>>::operation*>(&*(base.sdf)))->cfg);\
             \
-            parse_attrs<true>(root,real_base,sdf::dynamic::NAME##_t<Attrs>::_fields,sizeof(sdf::dynamic::NAME##_t<Attrs>::_fields)/sizeof(sdf::field_t));\
+            parse_attrs<true>(root,real_base,sdf::dynamic::NAME##_t<Attrs>::_fields,sizeof(sdf::dynamic::NAME##_t<Attrs>::_fields)/sizeof(sdf::field_t),tmp_extras.top());\
             if(second_child!=root.last_child()){\
                 warning("Residual children in binary operator detected");\
             }\
@@ -260,11 +253,10 @@ struct parse_xml{
             nodes_t left = parse_node(first_child);\
             \
             base.sdf = sdf::dynamic::NAME(left.sdf);\
-            base.ui.children = {left.ui};\
             \
             auto real_base = (uint8_t*) &((dynamic_cast<sdf::utils::dyn_op<Attrs,sdf::impl::NAME<decltype(left.sdf)>>::operation*>(&*(base.sdf)))->cfg);\
             \
-            parse_attrs<true>(root,real_base,sdf::dynamic::NAME##_t<Attrs>::_fields,sizeof(sdf::dynamic::NAME##_t<Attrs>::_fields)/sizeof(sdf::field_t));\
+            parse_attrs<true>(root,real_base,sdf::dynamic::NAME##_t<Attrs>::_fields,sizeof(sdf::dynamic::NAME##_t<Attrs>::_fields)/sizeof(sdf::field_t),tmp_extras.top());\
             if(first_child!=root.last_child()){\
                 warning("Residual children in binary operator detected");\
             }\
@@ -279,9 +271,6 @@ struct parse_xml{
             //sdf_tree
             nodes_t node_ref = parse_node(child);
             forest.emplace(std::string(label),node_ref.sdf);
-
-            //ui_tree
-            ui_tree.children.push_back(node_ref.ui);
         }
     }
 
@@ -303,6 +292,10 @@ struct parse_xml{
         XML_OP1(Translate)
         XML_OP1(Rotate)
         XML_OP1(Scale)
+        XML_OP1(Instances)
+        XML_OP1(Array)
+        XML_OP1(CyclicArray)
+        XML_OP1(Mirror)
         //XML_OP1(Material) Disabled for now, support for shared_ptr needed.
 
         else if(strcmp(root.name(),"group")==0){
@@ -334,10 +327,8 @@ struct parse_xml{
 
         auto node_label = root.attribute("label").as_string(nullptr);
         next_uid++;
-        base.ui.label=std::format("{}({})##{}",node_label!=nullptr?std::format("{} ",node_label):std::string(""), root.name(),next_uid);
         if(node_label!=nullptr)named.emplace(std::string(node_label),next_uid);
         index.emplace(next_uid,base.sdf);
-        base.ui.ctx=next_uid;
         return base;
     }
 
@@ -345,7 +336,22 @@ struct parse_xml{
     #undef XML_OP1
     #undef XML_OP2
 
+    parse_xml() = default;
+
     public:
+        /**
+         * @brief Build the dynamic graph for a single subtree.
+         * 
+         * @param root the xml node of the subtree
+         * @param inherited extras inherited from the enclosing groups
+         * @return std::shared_ptr<sdf::utils::base_dyn<Attrs>> 
+         */
+        static std::shared_ptr<sdf::utils::base_dyn<Attrs>> subtree(const pugi::xml_node& root, const typename Attrs::extras_t& inherited){
+            parse_xml tmp;
+            tmp.tmp_extras.push(inherited);
+            return tmp.parse_node(root).sdf;
+        }
+
         parse_xml(const pugi::xml_node& root){
             tmp_extras.push({});
             parse_forest(root);
@@ -358,10 +364,6 @@ struct parse_xml{
             return it->second;
         }
 
-        App::treeview_t& ui_root(){
-            return ui_tree;
-        }
-
 
         //TODO: Add compile to generate its C++ code.
 
@@ -1,4 +1,338 @@
+/**
+ * @file main.cpp
+ * @author karurochari
+ * @brief Batch renderer with no display, for turntables, datasets and regression images.
+ * @date 2025-04-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * The scene is loaded and uploaded once, then all cameras are rendered in sequence.
+ * Encoding and writing frames is done by a pool of background threads, so the next frame is rendered in the meanwhile.
+ * Only a few frames can be waiting for their writer, rendering stalls once they are all taken.
+ */
 
-int main(){
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <string>
+#include <vector>
 
-}
\ No newline at end of file
+#define GLM_FORCE_INLINE
+#define GLM_FORCE_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "shared-slots.hpp"
+#include <sdf/sdf.hpp>
+#include <pipeline/basic.hpp>
+#include <scene-import/packed.hpp>
+#include <utils/jobs.hpp>
+#include <utils/png.hpp>
+#include <utils/trace.hpp>
+
+#include "xml-tree.hpp"
+#include "materials.hpp"
+
+using sdf_t = sdf::comptime::Interpreted_t<sdf::default_attrs>;
+using pipeline_t = pipeline::demo<sdf_t>;
+using fields_t = pipeline_t::output_t;
+
+constexpr size_t SLOT_SCENE = 2;
+constexpr float  ELEVATION = 0.3f;          //Height of the turntable over its radius
+
+struct options_t{
+    const char* scene = nullptr;
+    const char* cameras = nullptr;
+    std::string output = "frame-";
+    enum{PNG,RAW,NONE} format = PNG;
+    bool depth = false;
+    bool ids = false;
+    int width = 800, height = 800;
+    float scale = 1.0f;
+    int device = omp_get_default_device();
+    size_t in_flight = 3;
+    size_t writers = 2;
+    size_t turntable = 0;
+    float radius = 0.0f;
+    const char* trace = nullptr;
+    const char* profile = nullptr;
+};
+
+struct frame_t{
+    std::vector<glm::u8vec4> color;
+    std::vector<fields_t> fields;
+    glm::ivec2 size, fields_size;
+    jobs::job job;
+};
+
+static void usage(const char* name){
+    printf("Usage: %s <scene.xml|scene.enpack> [options]\n",name);
+    printf("  --cameras <file>        one camera per line, as `px py pz rx ry rz [zoom]`, # for comments\n");
+    printf("  --turntable <n>         n views around the scene, if no camera file is given (default 1)\n");
+    printf("  --radius <r>            distance of the turntable from the centre of the scene (default from its bounding box)\n");
+    printf("  --size <w>x<h>          size of the frames (default 800x800)\n");
+    printf("  --scale <s>             the first pass is rendered at 1/s of the size (default 1)\n");
+    printf("  --output <prefix>       frames are written as <prefix>00000.png and so on (default frame-)\n");
+    printf("  --format png|raw|none   raw is 8 bit RGBA with no header\n");
+    printf("  --depth                 also write the depth of each pixel, as a PFM image at the size of the first pass\n");
+    printf("  --ids                   also write the object identifier of each pixel, as a 16 bit PGM image at the size of the first pass\n");
+    printf("  --device <n>            OpenMP device used for rendering (default %d)\n",omp_get_default_device());
+    printf("  --in-flight <n>         frames which can wait for their writer while rendering (default 3)\n");
+    printf("  --writers <n>           threads encoding and writing frames (default 2)\n");
+    printf("  --trace <file.json>     timeline of the run, for chrome://tracing or Perfetto\n");
+    printf("  --profile <file>        time spent in each node of the scene, in the folded format of flame graphs (needs SDF_PROFILE)\n");
+}
+
+static bool parse(int argc, const char** argv, options_t& opts){
+    for(int i=1;i<argc;i++){
+        auto is = [&](const char* flag, int args = 1){return strcmp(argv[i],flag)==0 && i+args<argc;};
+        if(argv[i][0]!='-' && opts.scene==nullptr)opts.scene=argv[i];
+        else if(is("--cameras"))opts.cameras=argv[++i];
+        else if(is("--turntable"))opts.turntable=atoi(argv[++i]);
+        else if(is("--radius"))opts.radius=atof(argv[++i]);
+        else if(is("--size")){if(sscanf(argv[++i],"%dx%d",&opts.width,&opts.height)!=2)return false;}
+        else if(is("--scale"))opts.scale=atof(argv[++i]);
+        else if(is("--output"))opts.output=argv[++i];
+        else if(is("--format")){
+            i++;
+            if(strcmp(argv[i],"png")==0)opts.format=options_t::PNG;
+            else if(strcmp(argv[i],"raw")==0)opts.format=options_t::RAW;
+            else if(strcmp(argv[i],"none")==0)opts.format=options_t::NONE;
+            else return false;
+        }
+        else if(is("--depth",0))opts.depth=true;
+        else if(is("--ids",0))opts.ids=true;
+        else if(is("--device"))opts.device=atoi(argv[++i]);
+        else if(is("--in-flight"))opts.in_flight=atoi(argv[++i]);
+        else if(is("--writers"))opts.writers=atoi(argv[++i]);
+        else if(is("--trace"))opts.trace=argv[++i];
+        else if(is("--profile"))opts.profile=argv[++i];
+        else return false;
+    }
+    return opts.scene!=nullptr && opts.width>0 && opts.height>0 && opts.scale>=1.0f && opts.in_flight>0 && opts.writers>0;
+}
+
+static bool load_cameras(const char* path, std::vector<solver::projection::base_camera_t>& cameras){
+    std::ifstream in(path);
+    if(!in)return false;
+    std::string line;
+    while(std::getline(in,line)){
+        if(auto comment = line.find('#'); comment!=std::string::npos)line.resize(comment);
+        solver::projection::base_camera_t camera;
+        camera.zoom = 0.0f;
+        int n = sscanf(line.c_str(),"%f %f %f %f %f %f %f",&camera.pos.x,&camera.pos.y,&camera.pos.z,&camera.rot.x,&camera.rot.y,&camera.rot.z,&camera.zoom);
+        if(n<=0)continue;
+        if(n<6)return false;
+        cameras.push_back(camera);
+    }
+    return true;
+}
+
+//Angles for a camera in `pos` looking at `target`, as used by the projection: yaw in `rot.x`, pitch in `rot.y`.
+static solver::projection::base_camera_t look_at(const glm::vec3& pos, const glm::vec3& target){
+    auto d = glm::normalize(target-pos);
+    solver::projection::base_camera_t camera;
+    camera.pos = pos;
+    camera.rot = {std::atan2(d.x,d.z),std::asin(d.y),0.0f};
+    camera.zoom = 0.0f;
+    return camera;
+}
+
+static void turntable(const sdf_t& sdf, const options_t& opts, std::vector<solver::projection::base_camera_t>& cameras){
+    sdf::traits_t traits;
+    sdf.traits(traits);
+    auto box = traits.outer_box;
+    glm::vec3 centre = {0,0,0};
+    float radius = opts.radius;
+    if(std::isfinite(box.min.x) && std::isfinite(box.max.x)){
+        centre = (box.min+box.max)/2.0f;
+        if(radius<=0.0f)radius = glm::length(box.max-box.min)*1.2f;
+    }
+    if(radius<=0.0f)radius = 10.0f;
+
+    size_t n = opts.turntable>0?opts.turntable:1;
+    for(size_t i=0;i<n;i++){
+        float angle = 2.0f*std::numbers::pi_v<float>*i/n;
+        glm::vec3 pos = centre+radius*glm::vec3{std::sin(angle),ELEVATION,-std::cos(angle)};
+        cameras.push_back(look_at(pos,centre));
+    }
+}
+
+static bool write_file(const std::string& path, const void* data, size_t size){
+    FILE* fd = fopen(path.c_str(),"wb");
+    if(fd==nullptr)return false;
+    bool ok = fwrite(data,size,1,fd)==1;
+    return (fclose(fd)==0) && ok;
+}
+
+//Encode and write a frame, on a writer thread.
+static bool write_frame(const options_t& opts, size_t index, const frame_t& frame){
+    char suffix[32];
+    snprintf(suffix,sizeof(suffix),"%05zu",index);
+    std::string base = opts.output+suffix;
+
+    if(opts.format!=options_t::NONE){
+        //Frames are stored as ABGR bytes, as expected by the textures of the editor.
+        std::vector<uint8_t> rgba(frame.color.size()*4);
+        for(size_t i=0;i<frame.color.size();i++){
+            auto& p = frame.color[i];
+            rgba[i*4+0]=p.w;rgba[i*4+1]=p.z;rgba[i*4+2]=p.y;rgba[i*4+3]=p.x;
+        }
+        if(opts.format==options_t::PNG){
+            if(!png::write((base+".png").c_str(),rgba.data(),frame.size.x,frame.size.y,4))return false;
+        }
+        else if(!write_file(base+".rgba",rgba.data(),rgba.size()))return false;
+    }
+
+    if(opts.depth){
+        //PFM rows go from the bottom up.
+        auto [w,h] = frame.fields_size;
+        std::string head = "Pf\n"+std::to_string(w)+" "+std::to_string(h)+"\n-1.0\n";
+        std::vector<uint8_t> out(head.begin(),head.end());
+        out.resize(head.size()+(size_t)w*h*sizeof(float));
+        float* depth = (float*)(out.data()+head.size());
+        for(int y=0;y<h;y++)
+            for(int x=0;x<w;x++)depth[(size_t)(h-1-y)*w+x]=frame.fields[(size_t)y*w+x].depth;
+        if(!write_file(base+".depth.pfm",out.data(),out.size()))return false;
+    }
+
+    if(opts.ids){
+        auto [w,h] = frame.fields_size;
+        std::string head = "P5\n"+std::to_string(w)+" "+std::to_string(h)+"\n65535\n";
+        std::vector<uint8_t> out(head.begin(),head.end());
+        out.reserve(head.size()+(size_t)w*h*2);
+        for(size_t i=0;i<(size_t)w*h;i++){
+            uint16_t uid = frame.fields[i].uid;
+            out.push_back(uid>>8);
+            out.push_back(uid&0xff);
+        }
+        if(!write_file(base+".ids.pgm",out.data(),out.size()))return false;
+    }
+    return true;
+}
+
+int main(int argc, const char** argv){
+    options_t opts;
+    if(!parse(argc,argv,opts)){
+        usage(argv[0]);
+        return 1;
+    }
+    if(opts.trace!=nullptr)trace::enable();
+
+    //Scenes are uploaded once, packed ones are used in place.
+    sdf::packed::mapped packed;
+    std::span<const pipeline::material_t> materials = default_materials;
+    std::string_view ext = opts.scene;
+    ext = ext.substr(std::min(ext.size(),ext.rfind('.')));
+
+    try{
+        if(ext==".enpack"){
+            packed = sdf::packed::mapped(opts.scene);
+            if(!packed.compatible<sdf::default_attrs>() || !packed.bind(SLOT_SCENE)){
+                printf("ERROR: unable to load %s\n",opts.scene);
+                return 1;
+            }
+            if(packed.materials<pipeline::material_t>().size()!=0)materials=packed.materials<pipeline::material_t>();
+        }
+        else{
+            pugi::xml_document doc;
+            auto ret = doc.load_file(opts.scene);
+            if(!ret){
+                printf("ERROR: unable to load %s: %s\n",opts.scene,ret.description());
+                return 1;
+            }
+            sdf::tree::builder builder;
+            builder.share_subtrees = true;     //Never edited
+            parse_xml_tree<sdf::default_attrs> scene(doc.first_child(),builder);
+            if(!builder.make_shared(SLOT_SCENE)){
+                printf("ERROR: unable to upload %s\n",opts.scene);
+                return 1;
+            }
+        }
+    }catch(...){
+        printf("ERROR: unable to parse %s\n",opts.scene);
+        return 1;
+    }
+
+    sdf_t sdf(SLOT_SCENE);
+
+    std::vector<solver::projection::base_camera_t> cameras;
+    if(opts.cameras!=nullptr){
+        if(!load_cameras(opts.cameras,cameras)){
+            printf("ERROR: unable to read cameras from %s\n",opts.cameras);
+            return 1;
+        }
+    }
+    else turntable(sdf,opts,cameras);
+
+    pipeline_t renderer(opts.device,sdf,materials.data(),materials.size());
+    jobs::pool writers(opts.writers);
+    std::vector<frame_t> frames(opts.in_flight);
+
+    size_t failed = 0;
+    double render_s = 0.0, stall_s = 0.0;
+    auto clock = [](){return std::chrono::steady_clock::now();};
+    auto seconds = [](auto a, auto b){return std::chrono::duration<double>(b-a).count();};
+    auto start = clock();
+
+    for(size_t i=0;i<cameras.size();i++){
+        auto& frame = frames[i%frames.size()];
+
+        //Wait for the writer still holding this frame.
+        auto t0 = clock();
+        if(frame.job.valid() && frame.job.wait()!=jobs::state_t::DONE)failed++;
+        auto t1 = clock();
+
+        solver::projection::screen_camera_t camera;
+        static_cast<solver::projection::base_camera_t&>(camera) = cameras[i];
+        camera.canvas_width = opts.width;
+        camera.canvas_height = opts.height;
+        camera.resolution_scale = opts.scale;
+        renderer.set_camera(camera);
+
+        frame.size = {opts.width,opts.height};
+        frame.color.resize((size_t)opts.width*opts.height);
+        renderer.render(frame.color.data());
+        if(opts.depth || opts.ids){
+            frame.fields_size = renderer.render_size();
+            frame.fields.resize((size_t)frame.fields_size.x*frame.fields_size.y);
+            renderer.download_fields(frame.fields.data());
+        }
+        auto t2 = clock();
+
+        frame.job = writers.submit([&opts,&frame,i](jobs::status_t&){return write_frame(opts,i,frame);});
+        stall_s+=seconds(t0,t1);
+        render_s+=seconds(t1,t2);
+    }
+    for(auto& frame : frames){
+        if(frame.job.valid() && frame.job.wait()!=jobs::state_t::DONE)failed++;
+    }
+    auto total_s = seconds(start,clock());
+
+    size_t n = cameras.size();
+    printf("%zu frames in %.2fs, %.1f frames/s\n",n,total_s,n/total_s);
+    if(n>0)printf("render %.2f ms/frame, waiting for writers %.2f ms/frame\n",render_s*1e3/n,stall_s*1e3/n);
+
+    if(opts.trace!=nullptr){
+        std::ofstream out(opts.trace);
+        trace::write_chrome(trace::collect(),out);
+        if(!out){printf("ERROR: unable to write %s\n",opts.trace);failed++;}
+    }
+
+    if(opts.profile!=nullptr){
+        if(!SDF_PROFILE_ENABLED)printf("WARNING: built without SDF_PROFILE, the profile is empty\n");
+        std::ofstream out(opts.profile);
+        sdf::profile::flame(sdf::profile::collect(sdf),out);
+        if(!out){printf("ERROR: unable to write %s\n",opts.profile);failed++;}
+    }
+
+    if(failed>0){
+        printf("ERROR: %zu frames or reports could not be written\n",failed);
+        return 1;
+    }
+    return 0;
+}
@@ -1 +1,4 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+//Same palette as the editor, so that scenes with no materials of their own look the same in both.
+#include "../app/materials.hpp"
\ No newline at end of file
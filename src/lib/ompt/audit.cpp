@@ -0,0 +1,278 @@
+/**
+ * @file audit.cpp
+ * @author karurochari
+ * @brief OMPT tool auditing offloading, to find where time and bandwidth go in moving data around.
+ * @date 2025-04-23
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * It is loaded by the OpenMP runtime when listed in `OMP_TOOL_LIBRARIES`, no change to the application is needed.
+ * Every target region, data mapping and `omp_target_memcpy` is recorded with its kind, device, size, duration and call site.
+ * When the runtime exits, a report grouped by call site is written to stderr, or to the file named by `ENAMENTO_OMPT_AUDIT`.
+ *
+ * A transfer is redundant when it writes to the same destination exactly the same content as the previous transfer there,
+ * for example entries of `shared_map` synced again without changes.
+ * This is detected by hashing the host side of each transfer, so it slows down the application and it is only meant for diagnostics.
+ *
+ * The OpenMP 5.1 `_emi` callbacks are preferred, as they come with both endpoints and so with durations.
+ * Runtimes only offering the older callbacks are supported, but transfers are reported without their duration.
+ * Host offloading (like `amd64-linux-unknown`) emits the same events, so reports can be taken on machines without a GPU.
+ */
+
+#include <omp-tools.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace{
+
+enum struct kind_t{TARGET, ENTER_DATA, EXIT_DATA, UPDATE, ALLOC, TO_DEVICE, FROM_DEVICE, DELETE, ASSOCIATE, DISASSOCIATE, OTHER};
+
+constexpr const char* kind_names[] = {"target", "enter data", "exit data", "update", "alloc", "to device", "from device", "delete", "associate", "disassociate", "other"};
+
+kind_t kind_of(ompt_target_t kind){
+    switch(kind){
+        case ompt_target: case ompt_target_nowait: return kind_t::TARGET;
+        case ompt_target_enter_data: case ompt_target_enter_data_nowait: return kind_t::ENTER_DATA;
+        case ompt_target_exit_data: case ompt_target_exit_data_nowait: return kind_t::EXIT_DATA;
+        case ompt_target_update: case ompt_target_update_nowait: return kind_t::UPDATE;
+    }
+    return kind_t::OTHER;
+}
+
+kind_t kind_of(ompt_target_data_op_t op){
+    switch(op){
+        case ompt_target_data_alloc: case ompt_target_data_alloc_async: return kind_t::ALLOC;
+        case ompt_target_data_transfer_to_device: case ompt_target_data_transfer_to_device_async: return kind_t::TO_DEVICE;
+        case ompt_target_data_transfer_from_device: case ompt_target_data_transfer_from_device_async: return kind_t::FROM_DEVICE;
+        case ompt_target_data_delete: case ompt_target_data_delete_async: return kind_t::DELETE;
+        case ompt_target_data_associate: return kind_t::ASSOCIATE;
+        case ompt_target_data_disassociate: return kind_t::DISASSOCIATE;
+    }
+    return kind_t::OTHER;
+}
+
+struct site_t{
+    size_t      count = 0;
+    size_t      bytes = 0;
+    uint64_t    ns = 0;
+    size_t      redundant = 0;
+    size_t      redundant_bytes = 0;
+};
+
+//Transfers between the begin and end endpoints.
+struct pending_t{
+    uint64_t        start;
+    kind_t          kind;
+    const void*     codeptr;
+    int             device;
+    const void*     dest;
+    int             dest_device;
+    size_t          bytes;
+    uint64_t        hash;
+};
+
+struct state_t{
+    std::mutex  mtx;
+    int         host = -1;          //Device number of the host, as given by the runtime
+
+    //By call site, kind and device.
+    std::map<std::tuple<const void*,kind_t,int>,site_t> sites;
+    std::unordered_map<ompt_id_t,pending_t> pending;
+    std::unordered_map<ompt_id_t,uint64_t> regions;
+    //Hash of the last content written, by device and address.
+    std::map<std::pair<int,const void*>,uint64_t> last;
+    ompt_id_t   next_id = 1;
+}* state = nullptr;
+
+uint64_t now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t hash(const void* data, size_t bytes){
+    uint64_t h = 0xcbf29ce484222325ull^bytes;
+    auto ptr = (const uint8_t*)data;
+    size_t i = 0;
+    for(;i+8<=bytes;i+=8){
+        uint64_t w;
+        memcpy(&w,ptr+i,8);
+        h=(h^w)*0x100000001b3ull;
+        h^=h>>29;
+    }
+    for(;i<bytes;i++)h=(h^ptr[i])*0x100000001b3ull;
+    return h;
+}
+
+//Only the side of a transfer living on the host can be read.
+uint64_t content(kind_t kind, const void* src, int src_device, const void* dest, int dest_device, size_t bytes, bool done){
+    if(kind==kind_t::TO_DEVICE && !done && src!=nullptr && src_device==state->host)return hash(src,bytes);
+    if(kind==kind_t::FROM_DEVICE && done && dest!=nullptr && dest_device==state->host)return hash(dest,bytes);
+    return 0;
+}
+
+void account(const pending_t& op, uint64_t ns){
+    auto& site = state->sites[{op.codeptr,op.kind,op.device}];
+    site.count++;
+    site.bytes+=op.bytes;
+    site.ns+=ns;
+
+    if(op.kind==kind_t::DELETE){
+        state->last.erase({op.dest_device,op.dest});
+        return;
+    }
+    if(op.hash==0)return;
+    auto [it,fresh] = state->last.try_emplace({op.dest_device,op.dest},op.hash);
+    if(!fresh){
+        if(it->second==op.hash){
+            site.redundant++;
+            site.redundant_bytes+=op.bytes;
+        }
+        it->second=op.hash;
+    }
+}
+
+void on_data_op(ompt_scope_endpoint_t endpoint, ompt_id_t* host_op_id, ompt_target_data_op_t optype, void* src, int src_device, void* dest, int dest_device, size_t bytes, const void* codeptr, bool paired = true){
+    std::lock_guard lock(state->mtx);
+    auto kind = kind_of(optype);
+    int device = kind==kind_t::FROM_DEVICE?src_device:dest_device;
+    //Deletions only name the memory released.
+    if(kind==kind_t::DELETE){dest=src;dest_device=src_device;device=src_device;}
+
+    if(endpoint==ompt_scope_begin){
+        *host_op_id = state->next_id++;
+        state->pending[*host_op_id]={now(),kind,codeptr,device,dest,dest_device,bytes,content(kind,src,src_device,dest,dest_device,bytes,false)};
+        return;
+    }
+
+    auto it = state->pending.find(*host_op_id);
+    if(it==state->pending.end())return;
+    auto op = it->second;
+    state->pending.erase(it);
+    if(op.kind==kind_t::FROM_DEVICE && paired)op.hash=content(kind,src,src_device,dest,dest_device,bytes,true);
+    account(op,now()-op.start);
+}
+
+void on_data_op_emi(ompt_scope_endpoint_t endpoint, ompt_data_t*, ompt_data_t*, ompt_id_t* host_op_id, ompt_target_data_op_t optype,
+                    void* src, int src_device, void* dest, int dest_device, size_t bytes, const void* codeptr){
+    on_data_op(endpoint,host_op_id,optype,src,src_device,dest,dest_device,bytes,codeptr);
+}
+
+//Without endpoints, the transfer is accounted when announced, before it happens, so downloads cannot be hashed.
+void on_data_op_legacy(ompt_id_t, ompt_id_t, ompt_target_data_op_t optype, void* src, int src_device, void* dest, int dest_device, size_t bytes, const void* codeptr){
+    ompt_id_t id;
+    on_data_op(ompt_scope_begin,&id,optype,src,src_device,dest,dest_device,bytes,codeptr,false);
+    on_data_op(ompt_scope_end,&id,optype,src,src_device,dest,dest_device,bytes,codeptr,false);
+}
+
+void on_target(ompt_target_t kind, ompt_scope_endpoint_t endpoint, int device, ompt_id_t id, const void* codeptr){
+    std::lock_guard lock(state->mtx);
+    if(endpoint==ompt_scope_begin){
+        state->regions[id]=now();
+        return;
+    }
+    auto it = state->regions.find(id);
+    if(it==state->regions.end())return;
+    pending_t op = {it->second,kind_of(kind),codeptr,device,nullptr,device,0,0};
+    state->regions.erase(it);
+    account(op,now()-op.start);
+}
+
+void on_target_emi(ompt_target_t kind, ompt_scope_endpoint_t endpoint, int device, ompt_data_t*, ompt_data_t*, ompt_data_t* target_data, const void* codeptr){
+    if(endpoint==ompt_scope_begin){
+        std::lock_guard lock(state->mtx);
+        target_data->value = state->next_id++;
+    }
+    on_target(kind,endpoint,device,target_data->value,codeptr);
+}
+
+void on_target_legacy(ompt_target_t kind, ompt_scope_endpoint_t endpoint, int device, ompt_data_t*, ompt_id_t target_id, const void* codeptr){
+    on_target(kind,endpoint,device,target_id,codeptr);
+}
+
+std::string describe(const void* codeptr){
+    if(codeptr==nullptr)return "(unknown)";
+    Dl_info info;
+    if(dladdr(codeptr,&info)==0)return std::to_string((uintptr_t)codeptr);
+    std::string ret;
+    if(info.dli_sname!=nullptr){
+        int status;
+        char* name = abi::__cxa_demangle(info.dli_sname,nullptr,nullptr,&status);
+        ret = status==0?name:info.dli_sname;
+        free(name);
+        ret+="+"+std::to_string((uintptr_t)codeptr-(uintptr_t)info.dli_saddr);
+    }
+    else{
+        ret = std::string(info.dli_fname)+"+"+std::to_string((uintptr_t)codeptr-(uintptr_t)info.dli_fbase);
+    }
+    return ret;
+}
+
+void report(FILE* out){
+    std::vector<std::pair<std::tuple<const void*,kind_t,int>,site_t>> sites(state->sites.begin(),state->sites.end());
+    std::sort(sites.begin(),sites.end(),[](auto& a, auto& b){return a.second.ns>b.second.ns;});
+
+    fprintf(out,"[ompt-audit] %zu call sites, sorted by time\n",sites.size());
+    fprintf(out,"%-12s %6s %8s %12s %10s %10s %12s  %s\n","kind","device","count","bytes","ms","redundant","wasted bytes","call site");
+
+    size_t up = 0, down = 0, wasted = 0, redundant = 0;
+    for(auto& [key,site] : sites){
+        auto& [codeptr,kind,device] = key;
+        fprintf(out,"%-12s %6d %8zu %12zu %10.3f %10zu %12zu  %s\n",kind_names[(int)kind],device,site.count,site.bytes,site.ns/1e6,site.redundant,site.redundant_bytes,describe(codeptr).c_str());
+        if(kind==kind_t::TO_DEVICE)up+=site.bytes;
+        if(kind==kind_t::FROM_DEVICE)down+=site.bytes;
+        redundant+=site.redundant;
+        wasted+=site.redundant_bytes;
+    }
+    fprintf(out,"[ompt-audit] %zu bytes to devices, %zu bytes from devices, %zu redundant transfers for %zu bytes\n",up,down,redundant,wasted);
+}
+
+int initialize(ompt_function_lookup_t lookup, int initial_device, ompt_data_t*){
+    state = new state_t;
+    state->host = initial_device;
+
+    auto set = (ompt_set_callback_t)lookup("ompt_set_callback");
+    if(set==nullptr)return 0;
+
+    if(set(ompt_callback_target_emi,(ompt_callback_t)&on_target_emi)<=ompt_set_never){
+        set(ompt_callback_target,(ompt_callback_t)&on_target_legacy);
+    }
+    if(set(ompt_callback_target_data_op_emi,(ompt_callback_t)&on_data_op_emi)<=ompt_set_never){
+        set(ompt_callback_target_data_op,(ompt_callback_t)&on_data_op_legacy);
+    }
+    return 1;
+}
+
+void finalize(ompt_data_t*){
+    auto path = getenv("ENAMENTO_OMPT_AUDIT");
+    FILE* out = path!=nullptr?fopen(path,"w"):stderr;
+    if(out==nullptr){
+        fprintf(stderr,"[ompt-audit] Unable to write %s\n",path);
+        out=stderr;
+    }
+    {
+        std::lock_guard lock(state->mtx);
+        report(out);
+    }
+    if(out!=stderr)fclose(out);
+    delete state;
+    state = nullptr;
+}
+
+}
+
+extern "C" __attribute__((visibility("default"))) ompt_start_tool_result_t* ompt_start_tool(unsigned int, const char*){
+    static ompt_start_tool_result_t result = {&initialize,&finalize,{.value=0}};
+    return &result;
+}
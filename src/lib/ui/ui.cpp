@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <fstream>
 
 #include <SDL3/SDL_keyboard.h>
 #include <SDL3/SDL_keycode.h>
@@ -27,6 +28,11 @@
 
 #include "ui/panels/details.hpp"
 
+//If two cameras show the same view, regardless of the resolution.
+static bool same_view(const App::camera_t& a, const App::camera_t& b){
+    return a.pos==b.pos && a.rot==b.rot && a.zoom==b.zoom && a.projection==b.projection && a.canvas_width==b.canvas_width && a.canvas_height==b.canvas_height;
+}
+
 static glm::mat2 rot2D(float angle){
     float s = sin(angle);
     float c = cos(angle);
@@ -69,13 +75,6 @@ App::App(int width,int height):width(width),height(height){
         return;
     }
 
-    buffer = (uint8_t *)malloc(width*height*4);
-    
-    if (buffer == nullptr) {
-        std::print(stderr,"Unable to allocate buffer size for the `app`\n");
-        return;
-    }
-
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
 
     IMGUI_CHECKVERSION();
@@ -286,19 +285,50 @@ int App::run(scene_t scene, uint fps){
     SDL_RenderClear(renderer);
     SDL_RenderPresent(renderer);
 
-    uint64_t last_tick = SDL_GetTicks();
+    uint64_t period = 1000000000ull/fps;
+    uint64_t deadline = trace::now()+period;
+    uint64_t last_tick = trace::now();
     float last_delta_correction = 1.0;
     glm::vec3 origin={0,0,0};
     uint64_t frames=0;
     float avg_delta = 1000/fps;
 
+    //Earliest input moving the camera which is not on screen yet, to measure the latency until it is.
+    uint64_t first_input = 0;
+    camera_t last_camera = camera;
+    int ret = 0;
+
 	//ImTerm::terminal<terminal_helper_example> terminal_log;
 	//terminal_log.set_min_log_level(ImTerm::message::severity::info);
 
+    trace::enable();
+    start_worker(scene.renderer);
+
     while (running) {
-        if(auto t=scene.renderer(camera,buffer)!=0)return t;
+        uint64_t frame_start = trace::now();
+        trace::scope trace_frame("ui","app");
+
+        if(int err=worker.error.load();err!=0){ret=err;break;}
+
+        uint64_t presented_input = 0;
+        if(worker.frames.update()){
+            auto& frame = worker.frames.front();
+            //Frames rendered before a resize are dropped.
+            if(frame.pixels.size()==(size_t)width*height*4)SDL_UpdateTexture(texture, nullptr, (void*)frame.pixels.data(), width*4);
+            presented_input = frame.input_ns;
+
+            auto events = trace::collect(frame.start_ns);
+            std::erase_if(events,[&](const trace::event_t& e){return e.begin>frame.done_ns;});
+            stats.frame_ns = frame.done_ns-frame.start_ns;
+            stats.passes = trace::totals(events,"pass");
+            stats.transfers = trace::totals(events,"transfer");
+
+            //The resolution follows how long frames take to render while the view moves, not the pace of the UI.
+            //Refinements of a still view are slower by design, and frames with no input behind them would keep the scale drifting.
+            if(frame.camera.sample==0 && frame.input_ns!=0)camera.resolution_scale=glm::clamp(camera.resolution_scale+(stats.frame_ns>period?0.02f:-0.02f),1.0f,10.f);
+            stats.sample = frame.camera.sample;
+        }
 
-        SDL_UpdateTexture(texture, nullptr, (void*)buffer, width*4);
         SDL_FRect a ={0,0,(float)width,(float)height};
         SDL_FRect b={0,0,(float)width,(float)height};
         SDL_RenderTexture(renderer,texture,&a,&b);
@@ -367,7 +397,7 @@ int App::run(scene_t scene, uint fps){
                     if (event.button.button == SDL_BUTTON_MIDDLE) {
                         float mouseX, mouseY;
                         SDL_GetMouseState(&mouseX, &mouseY);
-                        origin = scene.raycaster(camera,{mouseX,mouseY});
+                        if(auto hit = raycast(scene,{mouseX,mouseY},true))origin = *hit;
                     }
                 case SDL_EVENT_KEY_DOWN:
                     {
@@ -412,6 +442,12 @@ int App::run(scene_t scene, uint fps){
             }
         }
 
+        //Nothing is submitted while the view is still, the worker refines the last frame instead.
+        bool moved = !same_view(camera,last_camera);
+        if(moved && first_input==0)first_input=frame_start;
+        if(moved || camera.resolution_scale!=last_camera.resolution_scale || refresh_pending.exchange(false))submit(camera,first_input);
+        last_camera=camera;
+
         ImGui_ImplSDLRenderer3_NewFrame();
         ImGui_ImplSDL3_NewFrame();
 
@@ -478,9 +514,11 @@ int App::run(scene_t scene, uint fps){
 
                 // Mark the following controls as read-only by disabling them.
 
+                //Only when the render thread is idle, else the last one is shown.
                 float mouseX, mouseY;
                 SDL_GetMouseState(&mouseX, &mouseY);
-                auto cast = scene.raycaster(camera,{mouseX,mouseY});
+                static glm::vec3 cast = {0,0,0};
+                if(auto hit = raycast(scene,{mouseX,mouseY},false))cast = *hit;
 
                 // Display the Position vector.
                 ImGui::InputFloat3("Position", (float*)&camera.pos);
@@ -501,6 +539,7 @@ int App::run(scene_t scene, uint fps){
             std::vector<std::string> leftEntries = {
                 std::format("[FPS] {:>6.2f}/{:>6.2f}",1000.0/avg_delta,(float)fps),
                 std::format("[SCALE] {:>3.0f}%",1.0/camera.resolution_scale*100),
+                std::format("[SAMPLES] {}/{}",stats.sample,worker.refine.load()),
             };
             std::vector<std::string> rightEntries = {
                 "⏰ 12:34",   // a clock icon and time
@@ -559,29 +598,32 @@ int App::run(scene_t scene, uint fps){
         ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), renderer);
         SDL_RenderPresent(renderer);
 
-        //Logic to handle stable frames and correction for framerate-dependent operations.
+        if(presented_input!=0){
+            stats.latency.AddPoint(frames,(trace::now()-presented_input)/1e6f);
+            if(presented_input==first_input)first_input=0;
+        }
 
-        uint64_t old_tick = last_tick;
-        last_tick = SDL_GetTicks();
+        //Logic to handle stable frames and correction for framerate-dependent operations.
+        //Iterations are paced against a deadline, so that the time spent in the loop does not make the rate drift.
 
-        auto delta = last_tick-old_tick;
+        trace_frame.close();
+        uint64_t now = trace::now();
+        float delta = (now-last_tick)/1e6f;
         avg_delta=(9.0f*avg_delta+delta)/10.0f;
-        
-        if(delta<1000.0/(float)fps){
-            SDL_Delay( 1000.0/(float)fps - delta );
-            last_delta_correction=60.0/fps;
-            camera.resolution_scale=glm::clamp(camera.resolution_scale-0.02f,1.0f,10.f);
-        }
-        else{
-            last_delta_correction=delta/(1000/(float)fps)*60.0/fps;
-            camera.resolution_scale=glm::clamp(camera.resolution_scale+0.02f,1.0f,10.f);
-        }
+        last_delta_correction=glm::max(delta,period/1e6f)/(1000/(float)fps)*60.0/fps;
+
+        if(now<deadline)SDL_DelayNS(deadline-now);
+        deadline+=period;
+        now = trace::now();
+        //Too late, start again from here instead of rushing the next ones to catch up.
+        if(deadline<now)deadline=now+period;
+
         if(frames%fps==0){
             SDL_SetWindowTitle(window,std::format("SDF Previewer").c_str());
             //SDL_SetWindowTitle(window,std::format("Hello {:3.2f} fps possible", 1000.0/(float)avg_delta).c_str());
             //std::print("[REPORT] camera.zoom={} camera.pos={},{},{} origin={},{},{} \n",camera.zoom, camera.pos.x, camera.pos.y, camera.pos.z, origin.x, origin.y, origin.z);
         }
-        last_tick = SDL_GetTicks();
+        last_tick = now;
 
         stats.fps.AddPoint(frames,1000.0f/(float)delta);
         stats.fps_avg.AddPoint(frames,1000.0f/(float)avg_delta);
@@ -590,7 +632,84 @@ int App::run(scene_t scene, uint fps){
 
         frames++;
     }
-    return 0;
+    stop_worker();
+    return ret;
+}
+
+void App::start_worker(const render_t& render){
+    worker.quit = false;
+    worker.error = 0;
+    worker.thread = std::thread([this,render](){
+        uint64_t rendered = 0;
+        camera_t current;
+        uint32_t sample = 0;
+        while(true){
+            auto& frame = worker.frames.back();
+            {
+                std::unique_lock lock(worker.mtx);
+                worker.rendering = false;
+                worker.cv.wait(lock,[&]{return worker.quit || worker.generation!=rendered || (rendered!=0 && sample<worker.refine);});
+                if(worker.quit)return;
+                if(worker.generation!=rendered){
+                    rendered = worker.generation;
+                    current = worker.camera;
+                    sample = 0;
+                    frame.input_ns = worker.input_ns;
+                }
+                else{
+                    sample++;
+                    frame.input_ns = 0;
+                }
+                frame.camera = current;
+                frame.camera.sample = sample;
+                worker.in_flight = frame.camera;
+                worker.rendering = true;
+                worker.cancel = false;
+            }
+
+            std::lock_guard busy(worker.busy);
+            trace::scope trace_render("render","app");
+            frame.start_ns = trace::now();
+            frame.pixels.resize((size_t)frame.camera.canvas_width*frame.camera.canvas_height*4);
+            if(int ret = render(frame.camera,frame.pixels.data(),worker.cancel); ret!=0){
+                worker.error = ret;
+                return;
+            }
+            if(worker.cancel)continue;
+            frame.done_ns = trace::now();
+            worker.frames.publish();
+        }
+    });
+}
+
+void App::stop_worker(){
+    if(!worker.thread.joinable())return;
+    {
+        std::lock_guard lock(worker.mtx);
+        worker.quit = true;
+        worker.cancel = true;
+    }
+    worker.cv.notify_one();
+    worker.thread.join();
+}
+
+void App::submit(const camera_t& camera, uint64_t input_ns){
+    {
+        std::lock_guard lock(worker.mtx);
+        worker.camera = camera;
+        worker.input_ns = input_ns;
+        worker.generation++;
+        //Changes to the resolution alone are not worth throwing away the work done, refinements of an old view always are.
+        if(worker.rendering && (!same_view(worker.in_flight,camera) || worker.in_flight.sample>0))worker.cancel = true;
+    }
+    worker.cv.notify_one();
+}
+
+std::optional<glm::vec3> App::raycast(const scene_t& scene, const glm::vec2& point, bool wait){
+    std::unique_lock lock(worker.busy,std::defer_lock);
+    if(wait)lock.lock();
+    else if(!lock.try_lock())return std::nullopt;
+    return scene.raycaster(camera,point);
 }
 
 void App::RenderCtxMenu(contextual_menu_t& menu){
@@ -686,11 +805,35 @@ void App::RenderStatsView(){
         ImPlot::PlotInfLines("FPS Target",&fps_target,1,ImPlotInfLinesFlags_Horizontal);
         ImPlot::PlotShaded("FPS", &stats.fps.Data[0].x, &stats.fps.Data[0].y, stats.fps.Data.size(), -INFINITY, 0, stats.fps.Offset, 2 * sizeof(float));
         ImPlot::PlotLine("FPS (avg)", &stats.fps_avg.Data[0].x, &stats.fps_avg.Data[0].y, stats.fps_avg.Data.size(), 0, stats.fps_avg.Offset, 2 * sizeof(float));
+        ImPlot::PlotLine("Latency (ms)", &stats.latency.Data[0].x, &stats.latency.Data[0].y, stats.latency.Data.size(), 0, stats.latency.Offset, 2 * sizeof(float));
 
         ImPlot::SetAxis(ImAxis_Y2);
         ImPlot::PlotLine("Scaling", &stats.resdiv.Data[0].x, &stats.resdiv.Data[0].y, stats.resdiv.Data.size(), 0, stats.resdiv.Offset, 2 * sizeof(float));
 ImPlot::EndPlot();
     }
+
+    if (ImGui::BeginTable("Passes", 2, ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Pass");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableHeadersRow();
+        auto row = [&](const char* name, uint64_t ns){
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name);
+            ImGui::TableNextColumn();
+            ImGui::ProgressBar(stats.frame_ns>0?(float)ns/stats.frame_ns:0.0f, ImVec2(-1,0), std::format("{:.2f}",ns/1e6).c_str());
+        };
+        for(auto& [name,ns] : stats.passes)row(name,ns);
+        for(auto& [name,ns] : stats.transfers)row(name,ns);
+        row("render",stats.frame_ns);
+        ImGui::EndTable();
+    }
+
+    //The whole content of the buffers is written, so it covers the last few seconds.
+    if (ImGui::Button("Export trace")) {
+        std::ofstream out("trace.json");
+        trace::write_chrome(trace::collect(),out);
+    }
     ImGui::End();
 }
 
@@ -768,12 +911,13 @@ void App::RenderStatusBar(const std::vector<std::string>& leftEntries, const std
 
 
 App::~App(){
+    stop_worker();
+
     ImGui_ImplSDLRenderer3_Shutdown();
     ImGui_ImplSDL3_Shutdown();
     ImPlot::DestroyContext();
     ImGui::DestroyContext();
 
-    free(buffer);
     if(texture!=nullptr)SDL_DestroyTexture(texture);
     if(renderer!=nullptr)SDL_DestroyRenderer(renderer);
     if(window!=nullptr)SDL_DestroyWindow(window);
@@ -784,7 +928,6 @@ void App::resize(int width, int height){
     this->height=height;
     this->camera.canvas_width=width;
     this->camera.canvas_height=height;
-    buffer = (uint8_t *)realloc(buffer,width*height*4);
     SDL_DestroyTexture(texture);
     texture = SDL_CreateTexture(renderer, SDL_PixelFormat::SDL_PIXELFORMAT_RGBA8888, SDL_TextureAccess::SDL_TEXTUREACCESS_STREAMING, width, height);
 }
\ No newline at end of file
@@ -1,7 +1,18 @@
 #include <cassert>
+#include <cstring>
+#include <sstream>
+#include <thread>
 
 #define SDF_HEADLESS true
 #include "sdf/sdf.hpp"
+#include "solver/mesh/extract.hpp"
+#include "solver/slice/slicer.hpp"
+#include "solver/projection/base.hpp"
+#include "pipeline/query.hpp"
+#include "solver/collision/contacts.hpp"
+#include "utils/jobs.hpp"
+#include "utils/trace.hpp"
+#include "utils/triple-buffer.hpp"
 
 void test(auto sdf, float target){
     float sample_host = sdf.sample({0,0,0}), sample_target;
@@ -23,5 +34,454 @@ int main(){
         test(Sphere_t<sdf::color_attrs>({5.0}),-5.0f);
     }
 
+    {
+        //Nodes built in an arena are counted until their last handle is dropped, and freezing them does not keep any alive.
+        using namespace sdf::dynamic;
+        arena storage;
+        {
+            sdf::utils::dyn_arena_scope scope(storage);
+            auto scene = Join(Sphere({5.0}),Translate(Sphere({3.0}),{glm::vec3{5,0,0}}));
+            assert(storage.alive()==4);
+            auto frozen = freeze(scene);
+            assert(std::abs(frozen.sample({8,0,0})-scene->sample({8,0,0}))<sdf::EPS);
+        }
+        assert(storage.alive()==0);
+    }
+
+    {
+        //Repeated subtrees are stored once, evaluation must not change.
+        using namespace sdf::dynamic;
+        auto part = [](){return Join(Sphere({5.0}),Translate(Sphere({3.0}),{glm::vec3{5,0,0}}));};
+        auto scene = Join(part(),Join(part(),Translate(part(),{glm::vec3{0,10,0}})));
+
+        sdf::tree::builder builder;
+        builder.share_subtrees = true;
+        builder.close(scene->to_tree(builder));
+        assert(builder.stats.shared==2);
+        assert(builder.stats.bytes_saved>0);
+
+        auto frozen = sdf::comptime::Frozen(sdf::impl::Frozen<sdf::default_attrs>(builder));
+        for(float x=-10;x<=10;x+=2.5)
+            for(float y=-10;y<=20;y+=2.5){
+                assert(abs(frozen.sample({x,y,0})-scene->sample({x,y,0}))<sdf::EPS);
+            }
+    }
+
+    {
+        //Domain repetition must match the explicit copies.
+        using namespace sdf::comptime;
+        auto grid = Array(Sphere({1.0}),{{4,4,0},{100,100,1}});
+        test(grid,-1.0f);
+        assert(std::abs(grid.sample({398,200,0})-1.0f)<sdf::EPS);
+        assert(std::abs(grid.sample({-3,0,0})-2.0f)<sdf::EPS);
+        assert(std::abs(grid.sample({402,0,0})-5.0f)<sdf::EPS);
+
+        auto ring = CyclicArray(Translate(Sphere({1.0}),{glm::vec3{5,0,0}}),{6});
+        assert(std::abs(ring.sample({2.5f,2.5f*sqrtf(3.0f),0})+1.0f)<sdf::EPS);
+        assert(std::abs(ring.sample({0,0,0})-4.0f)<sdf::EPS);
+
+        auto mirrored = Mirror(Translate(Sphere({1.0}),{glm::vec3{3,0,0}}),{{1,0,0}});
+        assert(std::abs(mirrored.sample({-3,0,0})+1.0f)<sdf::EPS);
+        assert(std::abs(mirrored.sample({0,0,0})-2.0f)<sdf::EPS);
+    }
+
+    {
+        //Extracted vertices must be on the surface, within the resolution.
+        using namespace sdf::comptime;
+        auto shape = Join(Sphere({1.0}),Translate(Box({glm::vec3{0.5,0.5,0.5}}),{glm::vec3{1,0,0}}));
+        struct sink_t{
+            const decltype(shape)& sdf;
+            float error = 0;
+            bool write(std::span<const solver::mesh::triangle_t> data){
+                for(auto& t : data)for(auto& v : t.v)error=std::max(error,std::abs(sdf.sample(v)));
+                return true;
+            }
+        }sink{shape};
+        solver::mesh::config_t cfg;
+        cfg.resolution=0.05f;
+        auto stats = solver::mesh::extract(shape,sink,cfg);
+        assert(stats.triangles>0);
+        assert(sink.error<cfg.resolution);
+    }
+
+    {
+        //A ring sliced through the middle is an outer contour and a hole.
+        using namespace sdf::comptime;
+        auto ring = Cut(Sphere({3.0}),Sphere({5.0}));
+        solver::slice::config_t cfg;
+        cfg.resolution=0.05f;
+        solver::slice::slicer slicer(ring,cfg);
+        std::vector<solver::slice::contour_t> contours;
+        slicer.plane(0.0f,contours);
+        assert(contours.size()==2);
+        float area = 0;
+        for(auto& contour : contours){
+            assert(contour.closed);
+            area+=contour.area;
+        }
+        assert(contours[0].hole()!=contours[1].hole());
+        assert(std::abs(area-std::numbers::pi_v<float>*16.0f)<0.5f);
+    }
+
+    {
+        //Bounds over a box must contain every sample taken in it.
+        using namespace sdf::comptime;
+        auto check = [](const auto& sdf){
+            srand(7);
+            for(int i=0;i<64;i++){
+                glm::vec3 from = {rand()%2000/100.0f-10.0f,rand()%2000/100.0f-10.0f,rand()%2000/100.0f-10.0f};
+                glm::vec3 size = {rand()%600/100.0f,rand()%600/100.0f,rand()%600/100.0f};
+                sdf::bbox_t box = {from,from+size};
+                auto range = sdf.bounds(box);
+                for(int x=0;x<=6;x++)for(int y=0;y<=6;y++)for(int z=0;z<=6;z++){
+                    float d = sdf.sample(box.min+size*glm::vec3(x,y,z)/6.0f);
+                    float eps = 1e-4f*(1.0f+std::abs(d));
+                    assert(d>=range.min-eps && d<=range.max+eps);
+                }
+            }
+        };
+
+        auto a = Translate(Box({glm::vec3{2,1,3}}),{glm::vec3{1,0,0}});
+        auto b = Sphere({3.0});
+        check(b);
+        check(a);
+        check(Plane({}));
+        check(Join(a,b));
+        check(Common(a,b));
+        check(Cut(a,b));
+        check(Xor(a,b));
+        check(SmoothJoin(a,b,{1.5f}));
+        check(Rotate(a,{glm::vec3{0.3,1.2,-0.7}}));
+        check(Scale(a,{0.5f}));
+        check(Mirror(a,{{1,1,0}}));
+        check(Array(b,{{7,4,0},{3,5,1}}));
+        check(Array(b,{{1.5,1.5,1.5},{40,40,40}}));
+        check(CyclicArray(a,{5}));
+        check(CyclicArray(Translate(b,{glm::vec3{6,0,0}}),{64}));
+
+        //Exact where the primitives allow it.
+        auto whole = b.bounds({glm::vec3(-4),glm::vec3(4)});
+        assert(whole.min==-3.0f && std::abs(whole.max-(std::sqrt(48.0f)-3.0f))<sdf::EPS);
+        assert(b.bounds({glm::vec3(5),glm::vec3(6)}).min>0.0f);
+
+        //The same through the dispatch of packed trees.
+        {
+            namespace dyn = sdf::dynamic;
+            auto scene = dyn::Join(dyn::Rotate(dyn::Box({glm::vec3{2,1,3}}),{glm::vec3{0.3,1.2,-0.7}}),dyn::Translate(dyn::Sphere({3.0}),{glm::vec3{4,0,0}}));
+            auto frozen = sdf::dynamic::freeze(scene);
+            check(frozen);
+            sdf::bbox_t box = {glm::vec3{-1,0,2},glm::vec3{3,1,5}};
+            assert(frozen.bounds(box).min==scene->bounds(box).min && frozen.bounds(box).max==scene->bounds(box).max);
+        }
+    }
+
+    {
+        //Trees specialized for a region must match the full one inside it, and be smaller where only part of the scene is.
+        namespace dyn = sdf::dynamic;
+        auto scene = dyn::Translate(dyn::Sphere({1.0}),{glm::vec3{0,0,0}});
+        for(int i=1;i<16;i++){
+            scene = dyn::Join(scene,dyn::Translate(dyn::Sphere({1.0}),{glm::vec3{(i%4)*3.0f,(i/4)*3.0f,0}}));
+        }
+        scene = dyn::Cut(dyn::Rotate(dyn::Box({glm::vec3{0.5,0.5,4}}),{glm::vec3{0,0,0.7}}),dyn::SmoothJoin(scene,dyn::Plane({}),{0.5f}));
+        auto full = dyn::freeze(scene);
+
+        sdf::region_cache cache(full);
+        for(int i=0;i<4;i++)for(int j=0;j<4;j++){
+            sdf::bbox_t region = {glm::vec3{i*3.0f-1.5f,j*3.0f-1.5f,0.5f},glm::vec3{i*3.0f+1.5f,j*3.0f+1.5f,2.5f}};
+            auto& pruned = cache.get(region);
+            assert(&pruned==&cache.get(region));
+            assert(pruned.size()<full.size());
+            for(int x=0;x<=8;x++)for(int y=0;y<=8;y++)for(int z=0;z<=8;z++){
+                auto pos = region.min+(region.max-region.min)*glm::vec3(x,y,z)/8.0f;
+                assert(std::abs(pruned.sample(pos)-full.sample(pos))<sdf::EPS);
+            }
+        }
+        assert(cache.size()==16);
+
+        //Far from everything only the plane is left.
+        sdf::tree::builder builder;
+        builder.prune = true;
+        builder.region = {glm::vec3{-50,-50,5},glm::vec3{-40,-40,6}};
+        builder.close(scene->to_tree(builder));
+        assert(std::string(sdf::comptime::Frozen(sdf::impl::Frozen<sdf::default_attrs>(builder)).name())=="Plane");
+        assert(builder.stats.pruned==2);
+
+        //Long chains, as loaded from XML, keep only the nodes around the region, from dynamic and flat trees alike.
+        {
+            std::shared_ptr<sdf::utils::base_dyn<sdf::default_attrs>> chain = dyn::Sphere({0.5});
+            for(int i=1;i<64;i++)chain = dyn::Join(chain,dyn::Translate(dyn::Sphere({0.5}),{glm::vec3{(float)i,0,0}}));
+            sdf::bbox_t region = {glm::vec3{9.9,-0.1,-0.1},glm::vec3{10.1,0.1,0.1}};
+            auto frozen = dyn::freeze(chain);
+            for(int flat=0;flat<2;flat++){
+                sdf::tree::builder part;
+                part.prune = true;
+                part.region = region;
+                part.close(flat?frozen.to_tree(part):chain->to_tree(part));
+                assert(part.stats.pruned>=50);
+                auto pruned = sdf::comptime::Frozen(sdf::impl::Frozen<sdf::default_attrs>(part));
+                for(float x=9.9f;x<=10.1f;x+=0.05f)assert(std::abs(pruned.sample({x,0.1f,0})-chain->sample({x,0.1f,0}))<sdf::EPS);
+            }
+        }
+
+        //Meshes extracted with pruning are the same.
+        solver::mesh::config_t cfg;
+        cfg.resolution=0.1f;
+        cfg.box={glm::vec3{-2,-2,-1},glm::vec3{11,11,2}};
+        solver::mesh::counter_t a, b;
+        solver::mesh::extract(full,a,cfg);
+        cfg.prune=true;
+        solver::mesh::extract(full,b,cfg);
+        assert(a.triangles==b.triangles);
+    }
+
+    {
+        //Skipping empty cells must find the same hits, with fewer samples of the SDF.
+        using namespace sdf::comptime;
+        auto scene = Join(Join(Sphere({1.0}),Translate(Box({glm::vec3{0.1,2.0,0.1}}),{glm::vec3{3,0,4}})),Translate(Plane({}),{glm::vec3{0,-1,0}}));
+        sampler::occupancy::builder grid({glm::vec3{-10,-2,-10},glm::vec3{10,4,10}},0.25f);
+        grid.build(scene);
+        assert(grid.stats()->levels>1);
+
+        solver::projection::base<decltype(scene)> camera(scene,{0,0.5,-8});
+        size_t plain = 0, skipped = 0;
+        for(int i=-16;i<=16;i++)for(int j=-16;j<=16;j++){
+            glm::vec3 rd = glm::normalize(glm::vec3{i/16.0f,j/16.0f-0.1f,1.0f});
+            auto a = camera.march_schnell(camera.camera.pos,rd,0.0f,nullptr);
+            auto b = camera.march_schnell(camera.camera.pos,rd,0.0f,grid.stats());
+            assert(std::isinf(a.first)==std::isinf(b.first));
+            if(!std::isinf(a.first))assert(std::abs(a.first-b.first)<1e-3f);
+            plain+=a.second;
+            skipped+=b.second;
+        }
+        assert(skipped<plain);
+
+        //With odd dimensions the last coarse cells are only partly baked, so a wall right outside the grid must still be hit.
+        auto wall = Translate(Box({glm::vec3{0.2,10.0,10.0}}),{glm::vec3{5.5,2.5,2.5}});
+        sampler::occupancy::builder odd({glm::vec3{0,0,0},glm::vec3{5,5,5}},1.0f);
+        odd.build(wall);
+        assert(odd.stats()->dims[0].x==5 && odd.stats()->levels>1);
+        solver::projection::base<decltype(wall)> inside(wall,{0.5,2.5,2.5});
+        for(float dy : {0.0f,0.1f,-0.2f}){
+            glm::vec3 rd = glm::normalize(glm::vec3{1.0f,dy,0.05f});
+            assert(sampler::occupancy::skip(odd.stats(),inside.camera.pos,rd,0.0f,100.0f)<4.8f/rd.x);
+            auto a = inside.march_schnell(inside.camera.pos,rd,0.0f,nullptr);
+            auto b = inside.march_schnell(inside.camera.pos,rd,0.0f,odd.stats());
+            assert(!std::isinf(a.first) && std::abs(a.first-b.first)<1e-3f);
+        }
+    }
+
+    {
+        //Packets of rays must find the same hits of rays marched one by one.
+        using namespace sdf::comptime;
+        auto scene = Join(Join(Sphere({1.0}),Translate(Box({glm::vec3{0.1,2.0,0.1}}),{glm::vec3{3,0,4}})),Translate(Plane({}),{glm::vec3{0,-1,0}}));
+        solver::projection::base<decltype(scene)> camera(scene,{0,0.5,-8});
+        sampler::occupancy::builder grid({glm::vec3{-10,-2,-10},glm::vec3{10,4,10}},0.25f);
+        grid.build(scene);
+        for(int i=-32;i<32;i+=8)for(int j=-32;j<32;j+=8){
+            glm::vec3 rd[64];
+            std::pair<float,uint> res[64];
+            for(int y=0;y<8;y++)for(int x=0;x<8;x++)rd[y*8+x]=camera.direction({(j+x)/32.0f,(i+y)/32.0f});
+            camera.march_packet_schnell<8>(camera.camera.pos,rd,res);
+            for(int k=0;k<64;k++){
+                auto ref = camera.march_schnell(camera.camera.pos,rd[k]);
+                assert(std::isinf(ref.first)==std::isinf(res[k].first));
+                if(!std::isinf(ref.first))assert(std::abs(ref.first-res[k].first)<1e-3f);
+            }
+            //And the same when lanes skip the empty cells of an occupancy grid.
+            camera.march_packet_schnell<8>(camera.camera.pos,rd,res,grid.stats());
+            for(int k=0;k<64;k++){
+                auto ref = camera.march_schnell(camera.camera.pos,rd[k],0.0f,grid.stats());
+                assert(std::isinf(ref.first)==std::isinf(res[k].first));
+                if(!std::isinf(ref.first))assert(std::abs(ref.first-res[k].first)<1e-3f);
+            }
+        }
+    }
+
+    {
+        //Batched queries, on the host device.
+        using namespace sdf::comptime;
+        auto shape = Join(Sphere({1.0}),Translate(Box({glm::vec3{1,1,1}}),{glm::vec3{5,0,0}}));
+        pipeline::query<decltype(shape)> engine(omp_get_initial_device(),shape);
+
+        std::vector<decltype(engine)::ray_t> rays = {{{0,0,-5},{0,0,1}},{{5,0,-5},{0,0,1}},{{0,5,-5},{0,0,1}},{{0,0,-5},{0,0,1},2.0f}};
+        std::vector<decltype(engine)::hit_t> hits(rays.size());
+        assert(engine.raycast(rays.data(),hits.data(),rays.size())==2);
+        assert(std::abs(hits[0].distance-4.0f)<1e-3f && glm::length(hits[0].normal-glm::vec3{0,0,-1})<1e-2f);
+        assert(std::abs(hits[1].distance-4.0f)<1e-3f);
+        assert(std::isinf(hits[2].distance) && std::isinf(hits[3].distance));
+
+        std::vector<glm::vec3> points = {{-3,0,0},{0,0.5,0},{5,3,0}};
+        std::vector<decltype(engine)::point_t> out(points.size());
+        engine.closest(points.data(),out.data(),points.size());
+        assert(std::abs(out[0].distance-2.0f)<1e-3f && glm::length(out[0].gradient-glm::vec3{-1,0,0})<1e-2f);
+        assert(glm::length(out[0].projection-glm::vec3{-1,0,0})<1e-3f);
+        assert(std::abs(out[1].distance+0.5f)<1e-3f && glm::length(out[1].projection-glm::vec3{0,1,0})<1e-3f);
+        assert(glm::length(out[2].projection-glm::vec3{5,1,0})<1e-3f);
+    }
+
+    {
+        //Contacts between objects with their own transforms.
+        using namespace sdf::comptime;
+        using namespace solver::collision;
+        auto ball = Sphere({1.0});
+        auto slab = Box({glm::vec3{1.0,0.2,1.0}});
+        solver::collision::config_t cfg;
+        cfg.resolution=0.02f;
+
+        std::vector<contact_t> out;
+        auto stats = contacts(ball,{},ball,{glm::mat3(1.0f),{1.5,0,0}},out,cfg);
+        assert(stats.contacts==out.size() && out.size()>100);
+        float deepest = 0.0f;
+        for(auto& c: out){
+            assert(std::abs(c.position.x-0.75f)<1e-3f && glm::length(glm::vec2{c.position.y,c.position.z})<0.67f);
+            assert(glm::length(c.normal-glm::vec3{1,0,0})<1e-2f);
+            deepest=std::max(deepest,c.depth);
+        }
+        assert(std::abs(deepest-0.5f)<1e-2f);
+        //Sampling the whole overlap at the same resolution would take far more.
+        assert(stats.leaves*4<std::pow(2.0f/cfg.resolution,3.0f)/8);
+
+        //The slab is turned on the side, so it is thin along x.
+        out.clear();
+        pose_t turned = {glm::mat3(glm::vec3{0,1,0},glm::vec3{-1,0,0},glm::vec3{0,0,1}),{1.1,0,0}};
+        contacts(ball,{},slab,turned,out,cfg);
+        assert(out.size()>10);
+        for(auto& c: out){
+            assert(c.normal.x>0.9f && c.depth<0.11f);
+        }
+
+        out.clear();
+        assert(contacts(ball,{},ball,{glm::mat3(1.0f),{2.5,0,0}},out,cfg).contacts==0);
+
+        //The margin given to the detector is the one used to search, apart surfaces within it are reported.
+        cfg.margin=0.1f;
+        out.clear();
+        detector(ball,{},ball,{glm::mat3(1.0f),{2.05,0,0}},cfg).run(out);
+        assert(out.size()>0);
+        for(auto& c: out)assert(c.depth<0.0f && c.depth>=-2.0f*cfg.margin);
+    }
+
+    {
+        //Per node counters, in the same order as the visitors.
+        using namespace sdf::dynamic;
+        auto root = Join(Sphere({1.0}),Translate(Sphere({1.0}),{glm::vec3{2,0,0}}));
+        sdf::profile::reset();
+        for(int i=0;i<100;i++)root->sample({0.01f*i,0,0});
+
+        auto entries = sdf::profile::collect(*root);
+        assert(entries.size()==4);
+        assert(strcmp(entries[0].name,"Join")==0 && entries[0].parent==0 && entries[0].depth==0);
+        assert(entries[1].parent==0 && entries[2].parent==0 && entries[3].parent==2 && entries[3].depth==2);
+        if constexpr(SDF_PROFILE_ENABLED){
+            for(auto& e: entries)assert(e.total.samples==100);
+            std::stringstream flame;
+            sdf::profile::flame(entries,flame);
+            assert(flame.str().find("Join;Translate;Sphere ")!=std::string::npos);
+        }
+        else{
+            for(auto& e: entries)assert(e.total.samples==0);
+        }
+    }
+
+    {
+        //Trace events from several threads, and their export.
+        trace::clear();
+        { trace::scope ignored("ignored","test"); }
+        trace::enable();
+        uint64_t start = trace::now();
+        #pragma omp parallel for
+        for(int i=0;i<64;i++){
+            trace::scope outer("outer","test");
+            trace::scope inner("inner","test");
+        }
+        {
+            trace::scope closed("closed","other");
+            closed.close();
+        }
+        trace::enable(false);
+
+        auto events = trace::collect(start);
+        assert(events.size()==129);
+        for(size_t i=1;i<events.size();i++)assert(events[i-1].begin<=events[i].begin && events[i].begin<=events[i].end);
+        auto totals = trace::totals(events,"test");
+        assert(totals.size()==2 && strcmp(totals[0].first,"outer")==0 && totals[0].second>=totals[1].second);
+        assert(trace::totals(events).size()==3);
+
+        std::stringstream json;
+        trace::write_chrome(events,json);
+        assert(json.str().find("\"name\": \"closed\", \"cat\": \"other\", \"ph\": \"X\"")!=std::string::npos);
+    }
+
+    {
+        //Latest value handed between two threads, neither waiting for the other.
+        triple_buffer<int> mailbox;
+        mailbox.front()=-1;
+        assert(!mailbox.update() && mailbox.front()==-1);
+
+        constexpr int N = 100000;
+        std::thread producer([&]{
+            for(int i=0;i<N;i++){
+                mailbox.back()=i;
+                mailbox.publish();
+            }
+        });
+        int last = -1;
+        while(last<N-1){
+            if(mailbox.update()){
+                assert(mailbox.front()>last);
+                last=mailbox.front();
+            }
+        }
+        producer.join();
+        assert(!mailbox.update() && mailbox.front()==N-1);
+    }
+
+    {
+        //Background jobs, with publication deferred to flush, cancellation and failures.
+        jobs::pool pool(2);
+        int published = 0;
+        auto ok = pool.submit([](jobs::status_t& status){status.expect(4);for(int i=0;i<4;i++)status.advance();return true;},[&]{published++;return true;});
+        assert(ok.wait()==jobs::state_t::READY && ok.progress()==1.0f && published==0);
+        assert(pool.flush()==1 && ok.state()==jobs::state_t::DONE && published==1);
+
+        auto failing = pool.submit([](jobs::status_t&)->bool{throw "Broken";});
+        assert(failing.wait()==jobs::state_t::FAILED && strcmp(failing.error(),"Broken")==0);
+
+        std::atomic<bool> started = false;
+        auto endless = pool.submit([&](jobs::status_t& status){started=true;while(!status.cancelled()){std::this_thread::yield();}return true;});
+        while(!started)std::this_thread::yield();
+        endless.cancel();
+        assert(endless.wait()==jobs::state_t::CANCELLED);
+
+        //Closing a pool stops the jobs still running.
+        {
+            jobs::pool closing(1);
+            started = false;
+            endless = closing.submit([&](jobs::status_t& status){started=true;while(!status.cancelled()){std::this_thread::yield();}return true;});
+            while(!started)std::this_thread::yield();
+        }
+        assert(endless.wait()==jobs::state_t::CANCELLED);
+
+        //Jobs can spawn more jobs, and a cancelled mesh extraction stops before writing anything.
+        std::atomic<int> inner = 0;
+        auto outer = pool.submit([&](jobs::status_t&){
+            for(int i=0;i<8;i++)pool.submit([&](jobs::status_t&){inner++;return true;},{},jobs::priority_t::HIGH);
+            return true;
+        });
+        outer.wait();
+        while(inner<8)std::this_thread::yield();
+
+        using namespace sdf::comptime;
+        auto sphere = Sphere({1.0f});
+        solver::mesh::counter_t sink;
+        jobs::status_t status;
+        status.cancel=true;
+        solver::mesh::extract(sphere,sink,{.box={glm::vec3{-2},glm::vec3{2}},.resolution=0.1f},&status);
+        assert(sink.triangles==0);
+        status.cancel=false;
+        solver::mesh::extract(sphere,sink,{.box={glm::vec3{-2},glm::vec3{2}},.resolution=0.1f},&status);
+        assert(sink.triangles>0 && status.progress()==1.0f);
+    }
+
     return 0;
 }
\ No newline at end of file
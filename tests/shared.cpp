@@ -0,0 +1,158 @@
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+//Features backed by shared slots need a table of their own, the headless build has none.
+#define SDF_SHARED_SLOTS
+#include "utils/shared.hpp"
+shared_map<16> global_shared;
+
+#include "sdf/sdf.hpp"
+#include "sdf/versioned.hpp"
+
+int main(){
+    {
+        //Instances must match the explicit join of their copies, and stay a lower bound of it far from them.
+        namespace dyn = sdf::dynamic;
+        constexpr size_t SLOT = 0, TREE = 1;
+        auto place = [](size_t i, float t){return glm::vec3{(i%5)*3.0f+t,(i/5)*2.5f,(i%3)*1.5f};};
+
+        auto child = sdf::comptime::Box({glm::vec3{1.0,0.5,0.75}});
+        auto instances = sampler::instances::builder<sdf::default_attrs>::from(child);
+        for(size_t i=0;i<20;i++)instances.add(glm::mat3(1.0f),place(i,0.0f));
+        assert(instances.build());
+        assert(instances.make_shared(SLOT));
+        auto head = instances.stats();
+        assert(head->count==20 && head->cells>1);
+
+        auto joined = [&](float t){
+            std::shared_ptr<sdf::utils::base_dyn<sdf::default_attrs>> ret = dyn::Translate(dyn::Box({glm::vec3{1.0,0.5,0.75}}),{place(0,t)});
+            for(size_t i=1;i<20;i++)ret = dyn::Join(ret,dyn::Translate(dyn::Box({glm::vec3{1.0,0.5,0.75}}),{place(i,t)}));
+            return sdf::dynamic::freeze(ret);
+        };
+
+        //Served from the tree in its own slot, so that updates can be checked not to touch it.
+        sdf::tree::builder builder;
+        builder.close(dyn::Instances(dyn::Box({glm::vec3{1.0,0.5,0.75}}),{SLOT})->to_tree(builder));
+        assert(builder.make_shared(TREE));
+        sdf::comptime::Interpreted_t<sdf::default_attrs> scene(TREE);
+
+        auto compare = [&](const auto& reference, float margin, float t){
+            srand(11);
+            for(int i=0;i<8192;i++){
+                //Half the samples are close to an instance, the others span well beyond the grid to cover the bound used far from all of them.
+                glm::vec3 p = i%2==0?
+                    place(rand()%20,t)+glm::vec3{rand()%400/100.0f-2.0f,rand()%400/100.0f-2.0f,rand()%400/100.0f-2.0f}:
+                    glm::vec3{rand()%6000/100.0f-20.0f,rand()%5000/100.0f-20.0f,rand()%4000/100.0f-20.0f};
+                float expected = reference.sample(p), got = scene.sample(p);
+                //Instances within the margin are always listed in the cell, further ones may only be bounded.
+                if(expected<margin)assert(std::abs(got-expected)<sdf::EPS);
+                else assert(got>0.0f && got<=expected+sdf::EPS);
+            }
+        };
+        compare(joined(0.0f),head->margin,0.0f);
+
+        //Moving the instances only rebuilds and syncs their slot, the tree is reused as it is.
+        auto tree = global_shared[TREE];
+        std::vector<uint8_t> tree_bytes((uint8_t*)tree.base,(uint8_t*)tree.base+tree.size);
+        auto before = global_shared[SLOT].base;
+        for(size_t i=0;i<20;i++)instances.set(i,glm::mat3(1.0f),place(i,0.5f));
+        assert(instances.update(SLOT));
+        assert(global_shared[SLOT].base==before);
+        assert(global_shared[TREE].base==tree.base && global_shared[TREE].size==tree.size);
+        assert(memcmp(tree.base,tree_bytes.data(),tree.size)==0);
+        compare(joined(0.5f),instances.stats()->margin,0.5f);
+    }
+
+    {
+        //Bounds of Instances over a box must contain every sample taken in it, as checked for the other nodes in test-sdf.
+        using namespace sdf::comptime;
+        constexpr size_t SLOT = 2;
+        auto check = [](const auto& sdf){
+            srand(7);
+            for(int i=0;i<64;i++){
+                glm::vec3 from = {rand()%2000/100.0f-10.0f,rand()%2000/100.0f-10.0f,rand()%2000/100.0f-10.0f};
+                glm::vec3 size = {rand()%600/100.0f,rand()%600/100.0f,rand()%600/100.0f};
+                sdf::bbox_t box = {from,from+size};
+                auto range = sdf.bounds(box);
+                for(int x=0;x<=6;x++)for(int y=0;y<=6;y++)for(int z=0;z<=6;z++){
+                    float d = sdf.sample(box.min+size*glm::vec3(x,y,z)/6.0f);
+                    float eps = 1e-4f*(1.0f+std::abs(d));
+                    assert(d>=range.min-eps && d<=range.max+eps);
+                }
+            }
+        };
+
+        auto child = Translate(Box({glm::vec3{2,1,3}}),{glm::vec3{1,0,0}});
+        auto instances = sampler::instances::builder<sdf::default_attrs>::from(child);
+        for(int i=0;i<12;i++){
+            float angle = i*0.5f;
+            glm::mat3 rotation = {{cosf(angle),0,-sinf(angle)},{0,1,0},{sinf(angle),0,cosf(angle)}};
+            instances.add(rotation,{(i%4)*4.0f-6.0f,(i/4)*3.0f-3.0f,0});
+        }
+        assert(instances.build());
+        assert(instances.make_shared(SLOT));
+        check(Instances(child,{SLOT}));
+
+        //With a small grid, large boxes take the path visiting all instances.
+        auto coarse = sampler::instances::builder<sdf::default_attrs>::from(child,0.1f,128);
+        for(int i=0;i<12;i++)coarse.add(glm::mat3(1.0f),{(i%4)*4.0f-6.0f,(i/4)*3.0f-3.0f,0});
+        assert(coarse.build());
+        assert(coarse.make_shared(SLOT+1));
+        check(Instances(child,{SLOT+1}));
+    }
+
+    {
+        //Versions of a tree in a ring of slots, as seen by frames holding snapshots.
+        constexpr size_t FIRST = 8;
+        sdf::versioned scene(FIRST,3);
+        auto fill = [](uint8_t value){return std::vector<uint8_t>(64,value);};
+        auto content = [](const sdf::versioned::snapshot& s){return ((const uint8_t*)global_shared[s.slot()].base)[0];};
+
+        assert(!scene.acquire().valid());
+
+        auto v1 = fill(1);
+        assert(scene.publish(v1.data(),v1.size()));
+        auto first = scene.acquire();
+        assert(first.valid() && first.version()==1 && content(first)==1);
+
+        //A held snapshot keeps its slot and content while newer versions are published.
+        auto v2 = fill(2);
+        assert(scene.publish(v2.data(),v2.size()));
+        auto second = scene.acquire();
+        assert(second.version()==2 && second.slot()!=first.slot());
+        assert(content(first)==1 && content(second)==2);
+
+        //All slots taken: the current one, and two held by snapshots.
+        auto v3 = fill(3);
+        assert(scene.publish(v3.data(),v3.size()));
+        auto third = scene.acquire();
+        auto v4 = fill(4);
+        assert(!scene.publish(v4.data(),v4.size()));
+        assert(scene.version()==3 && content(first)==1 && content(second)==2);
+
+        //Released slots are reused, and the one still held is untouched.
+        auto reused = first.slot();
+        first.release();
+        assert(!first.valid());
+        assert(scene.publish(v4.data(),v4.size()));
+        auto fourth = scene.acquire();
+        assert(fourth.slot()==reused && content(fourth)==4 && content(second)==2);
+        second.release();
+        third.release();
+
+        //Edits of single fields are checked against the field and the size of the tree.
+        sdf::field_t field = {.readonly=false,.type=sdf::field_t::type_float,.offset=0,.length=4};
+        float value = 1.0f;
+        assert(scene.set(0,field,&value));
+        assert(!scene.set(62,field,&value));
+        field.readonly = true;
+        assert(!scene.set(0,field,&value));
+        assert(scene.version()==5);
+    }
+
+    return 0;
+}